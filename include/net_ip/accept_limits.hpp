@@ -0,0 +1,84 @@
+/** @file
+ *
+ *  @ingroup net_ip_module
+ *
+ *  @brief Admission control configuration and statistics for TCP acceptors.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef ACCEPT_LIMITS_HPP_INCLUDED
+#define ACCEPT_LIMITS_HPP_INCLUDED
+
+#include <cstddef> // std::size_t
+
+namespace chops {
+namespace net {
+
+/**
+ *  @brief Policy applied when a TCP acceptor is at its connection limit or has no
+ *  accept rate tokens available.
+ *
+ *  @c pause stops accepting until a connection closes (connection limit) or the next
+ *  token is available (rate limit); in the meantime incoming connections wait in the
+ *  kernel listen backlog, and are refused by the kernel if the backlog fills. @c close
+ *  keeps accepting, and immediately closes each connection that is over a limit,
+ *  without notifying the application.
+ */
+enum class accept_limit_policy {
+  pause,
+  close
+};
+
+/**
+ *  @brief @c accept_limits bound the number of concurrent connections of a TCP acceptor
+ *  and the rate at which connections are accepted.
+ *
+ *  A @c max_connections of 0 means no limit. The accept rate is a token bucket:
+ *  @c accept_rate tokens (connections) per second are added, up to @c accept_burst
+ *  tokens, and each accepted connection takes a token. An @c accept_rate of 0 means
+ *  no rate limit.
+ *
+ *  With an @c io_context_distributor, connections still being handed off to their
+ *  @c io_context count against the connection limit.
+ */
+struct accept_limits {
+
+  std::size_t max_connections = 0;
+  double accept_rate = 0.0; // connections per second
+  std::size_t accept_burst = 1;
+  accept_limit_policy policy = accept_limit_policy::pause;
+};
+
+/**
+ *  @brief @c accept_stats provides the admission control counters of a TCP acceptor.
+ *
+ *  The pause counts are the number of times accepting was paused (see
+ *  @c accept_limit_policy), and the reject counts are the number of connections
+ *  closed immediately after being accepted.
+ *
+ *  The accept wake-ups are the number of times the acceptor's @c io_context ran an
+ *  accept handler, one per connection unless batch accepts are enabled.
+ */
+struct accept_stats {
+
+  std::size_t current_connections = 0;
+  std::size_t total_accepted = 0; // connections handed to the application
+  std::size_t connection_limit_pauses = 0;
+  std::size_t rate_limit_pauses = 0;
+  std::size_t connection_limit_rejects = 0;
+  std::size_t rate_limit_rejects = 0;
+  std::size_t accept_wakeups = 0; // accept completions, or readiness wake-ups when batched
+};
+
+} // end net namespace
+} // end chops namespace
+
+#endif
+
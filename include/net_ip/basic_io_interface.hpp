@@ -104,7 +104,7 @@ public:
  *  internal constructor only and not to be used by application code.
  *
  */
-  explicit basic_io_interface(std::weak_ptr<IOT> p) noexcept : m_ioh_wptr(p) { }
+  explicit basic_io_interface(std::weak_ptr<IOT> p) noexcept : m_ioh_wptr(std::move(p)) { }
 
 /**
  *  @brief Query whether an IO handler is associated with this object.
@@ -130,6 +130,25 @@ public:
     throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
   }
 
+/**
+ *  @brief Return the connection id of the associated IO handler.
+ *
+ *  Each IO handler is assigned an id when it is created, which is unique within the 
+ *  process and never 0, and does not change. It is a cheap key for hashing or lookup 
+ *  in application containers (e.g. per connection state), avoiding the @c std::weak_ptr
+ *  locking of the @c basic_io_interface comparison operators.
+ *
+ *  @return The connection id.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  std::size_t connection_id() const {
+    if (auto p = m_ioh_wptr.lock()) {
+      return p->connection_id();
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
 /**
  *  @brief Return a reference to the underlying socket, allowing socket options to be queried 
  *  or set or other socket methods to be called.
@@ -160,6 +179,145 @@ public:
     throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
   }
 
+/**
+ *  @brief Return the number of buffers in the output queue, without the cost of
+ *  copying all of the output queue statistics.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  std::size_t output_queue_size() const {
+    if (auto p = m_ioh_wptr.lock()) {
+      return p->output_queue_size();
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Return the number of bytes in the output queue, without the cost of
+ *  copying all of the output queue statistics.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  std::size_t bytes_in_output_queue() const {
+    if (auto p = m_ioh_wptr.lock()) {
+      return p->bytes_in_output_queue();
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Set the limits for gathering queued buffers into a single write.
+ *
+ *  This method is not implemented for UDP IO handlers (each UDP datagram is a
+ *  separate send).
+ *
+ *  When many buffers are queued for a TCP connection, up to @c max_bufs buffers
+ *  (or @c max_bytes total bytes) are drained from the output queue and written
+ *  with one scatter / gather write, instead of one write per buffer. The default
+ *  is no batching (each buffer written individually). At least one buffer is
+ *  always written, even if it is larger than @c max_bytes.
+ *
+ *  The limits can be changed at any time, and take effect on the next write.
+ *
+ *  @param max_bufs Maximum number of buffers in one write; 0 or 1 disables batching.
+ *
+ *  @param max_bytes Maximum number of bytes in one write; 0 means no byte limit.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  void set_write_batch_limits(std::size_t max_bufs, std::size_t max_bytes = 0) const {
+    if (auto p = m_ioh_wptr.lock()) {
+      p->set_write_batch_limits(max_bufs, max_bytes);
+      return;
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Set the number of datagrams received or sent with one system call.
+ *
+ *  This method is not implemented for TCP IO handlers (see @c set_write_batch_limits).
+ *
+ *  On Linux, a batch size greater than 1 enables batched UDP IO: incoming datagrams 
+ *  are received with @c recvmmsg into a preallocated array of @c batch_size slots 
+ *  (each of the @c start_io maximum size), and queued output datagrams are flushed 
+ *  with @c sendmmsg, up to @c batch_size at a time. The message handler is still 
+ *  invoked once per datagram. On other platforms the batch size is ignored.
+ *
+ *  The receive batch size is used when @c start_io is called, so this method must
+ *  be called before @c start_io to batch reads. The send batch size takes effect on
+ *  the next write.
+ *
+ *  @param batch_size Maximum datagrams per system call; 0 or 1 disables batching.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  void set_datagram_batch_size(std::size_t batch_size) const {
+    if (auto p = m_ioh_wptr.lock()) {
+      p->set_datagram_batch_size(batch_size);
+      return;
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Set limits and backpressure water marks for the output queue of the
+ *  associated network IO handler.
+ *
+ *  By default the output queue is unbounded. When a buffer is sent while the queue 
+ *  is at a buffer count or byte limit, the policy in the limits is applied: the 
+ *  @c send is rejected (returns @c false), the oldest queued buffers are dropped, 
+ *  the buffer being sent is dropped, or the connection is closed (for UDP the 
+ *  entity is stopped) with an @c output_queue_overflow error code delivered to 
+ *  the net entity error callback. Dropped and rejected buffers are counted in the
+ *  @c output_queue_stats.
+ *
+ *  High and low water mark crossings (in bytes) are delivered to the net entity
+ *  error callback as @c output_queue_high_water_mark and 
+ *  @c output_queue_low_water_mark error codes, allowing producers to throttle 
+ *  before the limits are reached. 
+ *
+ *  The limits can be changed at any time.
+ *
+ *  @param lim Output queue limits, policy and water marks.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  void set_output_queue_limits(const output_queue_limits& lim) const {
+    if (auto p = m_ioh_wptr.lock()) {
+      p->set_output_queue_limits(lim);
+      return;
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Make the output queue of the associated network IO handler a conflating
+ *  queue, holding at most one unsent buffer per key.
+ *
+ *  Each buffer that is queued (because a write is in progress) is given a key by the 
+ *  function object. If an unsent buffer with the same key is already queued, it is 
+ *  replaced in place by the new buffer (keeping its position in the queue), and is 
+ *  counted as dropped in the @c output_queue_stats. For market data or state 
+ *  replication this bounds the memory used by a slow consumer, which never receives 
+ *  stale updates.
+ *
+ *  This method must be called before @c start_io.
+ *
+ *  @param key_func Function object returning the key of a buffer, an empty function 
+ *  object restores the default (FIFO) output queue.
+ *
+ *  @return @c false if IO has already been started, otherwise @c true.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  bool set_output_queue_conflation(output_queue_key_func key_func) const {
+    if (auto p = m_ioh_wptr.lock()) {
+      return p->set_output_queue_conflation(std::move(key_func));
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
 /**
  *  @brief Send a buffer of data through the associated network IO handler.
  *
@@ -170,9 +328,12 @@ public:
  *
  *  @param sz Size of buffer.
  *
+ *  @return @c false if the buffer is rejected due to output queue limits (see 
+ *  @c set_output_queue_limits), otherwise @c true.
+ *
  *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
  */
-  void send(const void* buf, std::size_t sz) const { send(chops::const_shared_buffer(buf, sz)); }
+  bool send(const void* buf, std::size_t sz) const { return send(chops::const_shared_buffer(buf, sz)); }
 
 /**
  *  @brief Send a reference counted buffer through the associated network IO handler.
@@ -181,12 +342,14 @@ public:
  *
  *  @param buf @c chops::const_shared_buffer containing data.
  *
+ *  @return @c false if the buffer is rejected due to output queue limits (see 
+ *  @c set_output_queue_limits), otherwise @c true.
+ *
  *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
  */
-  void send(chops::const_shared_buffer buf) const {
+  bool send(chops::const_shared_buffer buf) const {
     if (auto p = m_ioh_wptr.lock()) {
-      p->send(buf);
-      return;
+      return p->send(buf);
     }
     throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
   }
@@ -209,10 +372,43 @@ public:
  *
  *  @param buf @c chops::mutable_shared_buffer containing data.
  *
+ *  @return @c false if the buffer is rejected due to output queue limits (see 
+ *  @c set_output_queue_limits), otherwise @c true.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  bool send(chops::mutable_shared_buffer&& buf) const { 
+    return send(chops::const_shared_buffer(std::move(buf)));
+  }
+
+/**
+ *  @brief Send a reference counted buffer with a priority through the associated network
+ *  IO handler.
+ *
+ *  If the buffer is queued (because a write is in progress), it is queued in the output
+ *  queue lane for the priority. Queued buffers are written from the highest priority 
+ *  lane first, so e.g. a heartbeat or control message is not delayed behind a bulk 
+ *  transfer. The @c send methods without a priority use priority 0. Buffers are in 
+ *  send order within a priority, but not across priorities. For UDP IO handlers the 
+ *  buffer is sent to the default destination endpoint.
+ *
+ *  This is a non-blocking call.
+ *
+ *  @param buf @c chops::const_shared_buffer containing data.
+ *
+ *  @param priority Priority from 0 (lowest) to @c num_send_priorities @c - @c 1 
+ *  (highest), a larger value is treated as the highest priority.
+ *
+ *  @return @c false if the buffer is rejected due to output queue limits (see 
+ *  @c set_output_queue_limits), otherwise @c true.
+ *
  *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
  */
-  void send(chops::mutable_shared_buffer&& buf) const { 
-    send(chops::const_shared_buffer(std::move(buf)));
+  bool send(chops::const_shared_buffer buf, std::size_t priority) const {
+    if (auto p = m_ioh_wptr.lock()) {
+      return p->send(buf, priority);
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
   }
 
 /**
@@ -230,10 +426,13 @@ public:
  *
  *  @param endp Destination @c asio::ip::udp::endpoint for the buffer.
  *
+ *  @return @c false if the buffer is rejected due to output queue limits (see 
+ *  @c set_output_queue_limits), otherwise @c true.
+ *
  *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
  */
-  void send(const void* buf, std::size_t sz, const endpoint_type& endp) const {
-    send(chops::const_shared_buffer(buf, sz), endp);
+  bool send(const void* buf, std::size_t sz, const endpoint_type& endp) const {
+    return send(chops::const_shared_buffer(buf, sz), endp);
   }
 
 /**
@@ -246,12 +445,14 @@ public:
  *
  *  @param endp Destination @c asio::ip::udp::endpoint for the buffer.
  *
+ *  @return @c false if the buffer is rejected due to output queue limits (see 
+ *  @c set_output_queue_limits), otherwise @c true.
+ *
  *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
  */
-  void send(chops::const_shared_buffer buf, const endpoint_type& endp) const {
+  bool send(chops::const_shared_buffer buf, const endpoint_type& endp) const {
     if (auto p = m_ioh_wptr.lock()) {
-      p->send(buf, endp);
-      return;
+      return p->send(buf, endp);
     }
     throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
   }
@@ -267,10 +468,13 @@ public:
  *
  *  @param endp Destination @c asio::ip::udp::endpoint for the buffer.
  *
+ *  @return @c false if the buffer is rejected due to output queue limits (see 
+ *  @c set_output_queue_limits), otherwise @c true.
+ *
  *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
  */
-  void send(chops::mutable_shared_buffer&& buf, const endpoint_type& endp) const {
-    send(chops::const_shared_buffer(std::move(buf)), endp);
+  bool send(chops::mutable_shared_buffer&& buf, const endpoint_type& endp) const {
+    return send(chops::const_shared_buffer(std::move(buf)), endp);
   }
 
 
@@ -307,7 +511,12 @@ public:
  *  @c basic_io_interface can be used for sending a reply. The endpoint is the remote 
  *  endpoint that sent the data (not used in the @c send method call, but may be
  *  useful for other purposes). 
-
+ *
+ *  The first parameter can instead be a @c chops::net::pooled_buffer, an owning, 
+ *  reference counted buffer from the @c recv_buffer_pool of the @c io_context, which
+ *  can be kept (or passed to another thread) after the message handler returns. For
+ *  this @c start_io the message bytes are moved into the pooled buffer without a copy.
+ *
  *  Returning @c false from the message handler callback causes the connection to be 
  *  closed.
  *
@@ -351,7 +560,49 @@ public:
   }
 
 /**
- *  @brief Enable IO processing for the associated network IO handler with delimeter 
+ *  @brief Enable IO processing for the associated network IO handler with message
+ *  frame logic, reading ahead into a larger buffer.
+ *
+ *  This method is not implemented for UDP IO handlers.
+ *
+ *  The message handler and message frame function objects are the same as in the
+ *  @c start_io method without the read-ahead size, and are called in the same order
+ *  with the same buffer sizes. The difference is in how the bytes are read: instead
+ *  of one read for the header and another for the body of each message, as many
+ *  bytes as are available (up to the buffer size) are read at once, and the message
+ *  frame logic is run over the bytes already in memory. Every complete message in
+ *  the buffer is passed to the message handler before the next read is started.
+ *
+ *  For small messages this greatly reduces the number of reads (system calls) per
+ *  message. The buffer is enlarged if a single message does not fit.
+ *
+ *  @param header_size The initial size (in bytes) of each incoming message, must be
+ *  greater than 0.
+ *
+ *  @param msg_handler A message handler function object callback, as described in
+ *  the corresponding @c start_io method.
+ *
+ *  @param msg_frame A message frame function object callback, as described in the
+ *  corresponding @c start_io method.
+ *
+ *  @param read_ahead_size Size of the read buffer, for example 64K.
+ *
+ *  @return @c false if already started or the header size is 0, otherwise @c true.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  template <typename MH, typename MF>
+  bool start_io(std::size_t header_size, MH&& msg_handler, MF&& msg_frame,
+                std::size_t read_ahead_size) {
+    if (auto p = m_ioh_wptr.lock()) {
+      return p->start_io(header_size, std::forward<MH>(msg_handler),
+                         std::forward<MF>(msg_frame), read_ahead_size);
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Enable IO processing for the associated network IO handler with delimeter
  *  logic.
  *
  *  This method is not implemented for UDP IO handlers.
@@ -22,9 +22,12 @@
 #include <utility> // std::move, std::forward
 #include <system_error> // std::make_error, std::error_code
 
+#include "asio/ip/address.hpp"
+
 #include "net_ip/net_ip_error.hpp"
 
 #include "net_ip/basic_io_interface.hpp"
+#include "net_ip/accept_limits.hpp"
 
 namespace chops {
 namespace net {
@@ -256,6 +259,120 @@ public:
     }
     throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
   }
+
+/**
+ *  @brief Set the admission control limits of the associated TCP acceptor net entity.
+ *
+ *  The limits bound the number of concurrent connections and the rate at which 
+ *  connections are accepted, with a policy for connections over a limit (see
+ *  @c accept_limits and @c accept_limit_policy). By default there are no limits.
+ *
+ *  This method is only available for TCP acceptor net entities, and must be called 
+ *  before @c start.
+ *
+ *  @param lim Admission control limits.
+ *
+ *  @return @c false if @c start has already been called, otherwise @c true.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated net entity.
+ */
+  bool set_accept_limits(const accept_limits& lim) {
+    if (auto p = m_eh_wptr.lock()) {
+      return p->set_accept_limits(lim);
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Set the maximum number of connections accepted per wake-up of the associated
+ *  TCP acceptor net entity.
+ *
+ *  By default each connection is accepted with a separate asynchronous accept, so a
+ *  burst of connections takes one reactor wake-up per connection. With a batch size 
+ *  greater than 1 the acceptor waits for the listen socket to be readable, then 
+ *  accepts (non-blocking) until the listen backlog is empty or the batch size is 
+ *  reached. Admission control (see @c set_accept_limits) is applied to each connection.
+ *
+ *  This method is only available for TCP acceptor net entities, and must be called 
+ *  before @c start.
+ *
+ *  @param batch_size Maximum connections accepted per wake-up; 0 or 1 disables batching.
+ *
+ *  @return @c false if @c start has already been called, otherwise @c true.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated net entity.
+ */
+  bool set_accept_batch_size(std::size_t batch_size) {
+    if (auto p = m_eh_wptr.lock()) {
+      return p->set_accept_batch_size(batch_size);
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Return the admission control counters of the associated TCP acceptor net 
+ *  entity.
+ *
+ *  This method is only available for TCP acceptor net entities.
+ *
+ *  @return @c accept_stats object.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated net entity.
+ */
+  accept_stats get_accept_stats() const {
+    if (auto p = m_eh_wptr.lock()) {
+      return p->get_accept_stats();
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Join a multicast group on the associated UDP net entity.
+ *
+ *  A multicast receiver (see the @c net_ip @c make_udp_multicast_receiver method) joins 
+ *  the group specified in its @c multicast_options when started; additional groups can be
+ *  joined (and left) with this method after @c start has been called. The interface in the
+ *  @c multicast_options (if any) is used for the join.
+ *
+ *  This method is only available for UDP net entities.
+ *
+ *  @param group Multicast group address.
+ *
+ *  @param source Source address for a source-specific multicast join, or an unspecified
+ *  address (the default) for any source.
+ *
+ *  @return Error code from the socket option, which is non-zero on failure (e.g. 
+ *  @c std::errc::operation_not_supported for a source-specific join on a platform 
+ *  without support).
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated net entity.
+ */
+  std::error_code join_multicast_group(const asio::ip::address& group,
+                                       const asio::ip::address& source = asio::ip::address()) {
+    if (auto p = m_eh_wptr.lock()) {
+      return p->join_multicast_group(group, source);
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Leave a multicast group previously joined on the associated UDP net entity.
+ *
+ *  @param group Multicast group address.
+ *
+ *  @param source Source address, which must match the source used in the join.
+ *
+ *  @return Error code from the socket option, which is non-zero on failure.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated net entity.
+ */
+  std::error_code leave_multicast_group(const asio::ip::address& group,
+                                        const asio::ip::address& source = asio::ip::address()) {
+    if (auto p = m_eh_wptr.lock()) {
+      return p->leave_multicast_group(group, source);
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
 /**
  *  @brief Compare two @c basic_net_entity objects for equality.
  *
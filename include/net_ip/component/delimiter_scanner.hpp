@@ -0,0 +1,126 @@
+/** @file
+ *
+ *  @ingroup net_ip_component_module
+ *
+ *  @brief Resumable delimiter scanner for text protocol message framing.
+ *
+ *  Text protocols (CR / LF, or multi-byte delimiters such as CR LF) are framed by
+ *  scanning for the delimiter. Bytes usually arrive in pieces, and a naive scan
+ *  starts over from the beginning of the message for every piece. A
+ *  @c delimiter_scanner remembers how far a partial message has already been
+ *  scanned and resumes from there, backing up only enough to find a delimiter that
+ *  straddles two pieces.
+ *
+ *  The search is performed with SSE2 or AVX2 instructions when the CPU supports
+ *  them (selected at runtime), otherwise with a scalar search.
+ *
+ *  @note This is not a necessary dependency of the @c net_ip library (which uses the
+ *  same search in the @c basic_io_interface delimiter @c start_io method), but is
+ *  useful when framing text messages outside of a TCP IO handler, e.g. from a file
+ *  or within UDP datagrams.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef DELIMITER_SCANNER_HPP_INCLUDED
+#define DELIMITER_SCANNER_HPP_INCLUDED
+
+#include <cstddef> // std::size_t, std::byte
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include "asio/buffer.hpp"
+
+#include "net_ip/detail/delimiter_search.hpp"
+
+namespace chops {
+namespace net {
+
+/**
+ *  @brief Scan for a delimiter in a partial message, resuming where the previous
+ *  scan of the same message stopped.
+ *
+ */
+class delimiter_scanner {
+private:
+  std::string               m_delimiter;
+  std::size_t               m_scan_pos;
+  detail::delim_search_func m_search;
+
+public:
+/**
+ *  @brief Construct a @c delimiter_scanner.
+ *
+ *  @param delimiter Delimiter bytes, which must not be empty.
+ *
+ *  @throw @c std::system_error with @c std::errc::invalid_argument if the delimiter
+ *  is empty.
+ *
+ */
+  explicit delimiter_scanner(std::string_view delimiter) :
+    m_delimiter(delimiter), m_scan_pos(0), m_search(detail::select_delim_search()) {
+    if (m_delimiter.empty()) {
+      throw std::system_error(std::make_error_code(std::errc::invalid_argument));
+    }
+  }
+
+/**
+ *  @brief Scan a buffer for the end of a message.
+ *
+ *  The buffer must start at the beginning of the message. When a previous call
+ *  did not find a delimiter, the buffer must contain the same beginning bytes,
+ *  followed by any newly arrived bytes.
+ *
+ *  @param buf Buffer starting at the beginning of the message.
+ *
+ *  @return Size of the message including the delimiter, or zero if the buffer does
+ *  not (yet) contain a delimiter. After a non-zero return the next call scans a
+ *  new message.
+ *
+ */
+  std::size_t scan(asio::const_buffer buf) noexcept {
+    auto beg = static_cast<const std::byte*>(buf.data());
+    auto end = beg + buf.size();
+    auto delim = reinterpret_cast<const std::byte*>(m_delimiter.data());
+    if (m_scan_pos > buf.size()) {
+      m_scan_pos = 0u;
+    }
+    auto p = m_search(beg + m_scan_pos, end, delim, m_delimiter.size());
+    if (p == end) {
+      // next scan starts where a partial delimiter could begin
+      m_scan_pos = (buf.size() < m_delimiter.size()) ? 0u : buf.size() - m_delimiter.size() + 1u;
+      return 0u;
+    }
+    m_scan_pos = 0u;
+    return static_cast<std::size_t>(p - beg) + m_delimiter.size();
+  }
+
+/**
+ *  @brief Forget any partial scan, so the next call to @c scan starts a new message.
+ */
+  void reset() noexcept { m_scan_pos = 0u; }
+
+/**
+ *  @brief Return the number of bytes of the current message already scanned.
+ */
+  std::size_t scan_position() const noexcept { return m_scan_pos; }
+
+/**
+ *  @brief Return the delimiter.
+ */
+  std::string_view delimiter() const noexcept { return m_delimiter; }
+
+};
+
+} // end net namespace
+} // end chops namespace
+
+#endif
+
@@ -18,10 +18,19 @@
 #define SEND_TO_ALL_HPP_INCLUDED
 
 #include <cstddef> // std::size_t
-#include <utility> // std::move
+#include <utility> // std::move, std::declval
+#include <algorithm> // std::find_if
 
 #include <mutex>
 #include <vector>
+#include <memory> // std::shared_ptr, std::atomic_load, std::atomic_store
+#include <type_traits> // std::void_t, std::true_type, std::false_type
+#include <atomic>
+#include <unordered_map>
+#include <chrono>
+
+#include "asio/post.hpp"
+#include "asio/steady_timer.hpp"
 
 #include "net_ip/basic_io_interface.hpp"
 #include "net_ip/queue_stats.hpp"
@@ -32,6 +41,66 @@
 namespace chops {
 namespace net {
 
+namespace detail {
+
+// IO handlers that can be sent to from the thread running their io_context without
+// a post (tcp_io and udp_entity_io) are broadcast to with one post per executor
+template <typename IOT, typename = void>
+struct has_send_in_io_thread : std::false_type { };
+
+template <typename IOT>
+struct has_send_in_io_thread<IOT, 
+    std::void_t<decltype(std::declval<IOT&>().send_in_io_thread(std::declval<chops::const_shared_buffer>())),
+                typename IOT::socket_type::executor_type>> : std::true_type { };
+
+template <typename IOT, bool = has_send_in_io_thread<IOT>::value>
+struct io_executor { using type = void*; };
+
+template <typename IOT>
+struct io_executor<IOT, true> { using type = typename IOT::socket_type::executor_type; };
+
+template <typename IOT>
+struct executor_group {
+  typename io_executor<IOT>::type  m_exec;
+  std::vector<std::size_t>         m_idxs; // into the collection of IO interfaces
+};
+
+// groups a collection of IO interfaces by the executor of their IO handlers, leaving out
+// IO handlers that are already closed; get_io returns the IO interface at an index
+template <typename IOT, typename F>
+std::vector<executor_group<IOT>> make_executor_groups(std::size_t num, F&& get_io) {
+  std::vector<executor_group<IOT>> grps;
+  for (std::size_t i = 0u; i < num; ++i) {
+    auto p = get_io(i).get_shared_ptr();
+    if (!p) {
+      continue;
+    }
+    auto ex = p->get_socket().get_executor();
+    auto it = std::find_if(grps.begin(), grps.end(), 
+                           [&ex] (const executor_group<IOT>& g) { return g.m_exec == ex; } );
+    if (it == grps.end()) {
+      grps.push_back(executor_group<IOT> { ex, std::vector<std::size_t> { i } });
+    }
+    else {
+      it->m_idxs.push_back(i);
+    }
+  }
+  return grps;
+}
+
+} // end detail namespace
+
+/**
+ *  @brief Policy applied by @c send_to_all to a member whose output queue is over the
+ *  configured byte threshold when a buffer is broadcast.
+ */
+enum class slow_member_policy {
+  none,       // always send (the default)
+  skip,       // the buffer is not sent to the member
+  conflate,   // only the latest buffer (per key) is kept, and sent once the member catches up
+  disconnect  // the member's IO is stopped
+};
+
 /**
  *  @brief Manage a collection of @c basic_io_interface objects and provide a way
  *  to send data to all. or to all except a specific object.
@@ -50,25 +119,88 @@ namespace net {
  *
  *  This class is thread-safe for concurrent access.
  *
+ *  The collection is stored as an immutable snapshot which is atomically replaced
+ *  (copy-on-write) when an object is added or removed. Sends iterate over the current
+ *  snapshot without holding the membership mutex, so a broadcast to many objects does
+ *  not block membership changes or other broadcasts. An object removed while a send is
+ *  in progress may still be sent to by that send (which is harmless, since the
+ *  @c basic_io_interface send is a no-op for a closed IO handler). The snapshot is
+ *  read and replaced with the @c std::shared_ptr atomic access functions, which are not
+ *  lock-free in common standard library implementations (e.g. libstdc++ uses a small
+ *  internal mutex pool), so a send briefly takes a lock to copy the snapshot pointer.
+ *
+ *  For TCP and UDP IO handlers the objects are also grouped by executor, and a 
+ *  broadcast posts one function object per executor (i.e. per @c io_context thread)
+ *  which queues the buffer on every IO handler in that group, instead of one post
+ *  (and one buffer reference count increment) per IO handler. The buffers are queued
+ *  when the posted function object runs, so a @c send through an individual 
+ *  @c basic_io_interface following a broadcast from the same thread may be sent first.
+ *
+ *  A slow member (one whose output queue holds more than a configured number of bytes)
+ *  can be isolated from the rest of the collection with a @c slow_member_policy, so 
+ *  that it does not grow without bound. Buffers that are not sent to a member (skipped,
+ *  replaced by a later conflated buffer, or broadcast when disconnecting) are counted 
+ *  per member. Conflated buffers are sent when a later broadcast finds the member
+ *  caught up, when @c flush is called, and (for TCP and UDP IO handlers) when a 
+ *  periodic check on the member's executor finds it caught up, so the latest buffers
+ *  are delivered even if the broadcasts stop.
+ *
  */
 template <typename IOT>
 class send_to_all {
+public:
+  using conflate_key_func = chops::net::output_queue_key_func;
+
 private:
   using lock_guard = std::lock_guard<std::mutex>;
   using io_intf    = basic_io_interface<IOT>;
   using io_intfs   = std::vector<io_intf>;
+  using executor_groups = std::vector<detail::executor_group<IOT>>;
+
+  static constexpr bool batched = detail::has_send_in_io_thread<IOT>::value;
+
+  // mutable state shared by every snapshot containing the member
+  struct member_state {
+    std::atomic_size_t    m_dropped { 0u };
+    std::mutex            m_mutex; // protects the conflated bufs and the flush flag
+    std::unordered_map<std::size_t, chops::const_shared_buffer> m_conflated;
+    bool                  m_flush_timer_running = false;
+  };
+
+  using member_state_ptr = std::shared_ptr<member_state>;
+
+  struct member {
+    io_intf            m_io;
+    member_state_ptr   m_state;
+  };
+
+  struct members {
+    std::vector<member>          m_members;
+    executor_groups              m_groups; // only used for batched broadcasts
+    slow_member_policy           m_policy = slow_member_policy::none;
+    std::size_t                  m_max_bytes = 0u;
+    conflate_key_func            m_key_func;
+    std::chrono::milliseconds    m_flush_interval { 0 };
+  };
+
+  using snapshot   = std::shared_ptr<const members>;
 
 private:
-  mutable std::mutex    m_mutex;
-  io_intfs              m_io_intfs;
+  std::mutex            m_mutex; // serializes membership changes only
+  snapshot              m_members;
 
 public:
+
+  send_to_all() : m_mutex(), m_members(std::make_shared<const members>()) { }
+
 /**
  *  @brief Add a @c basic_io_interface object to the collection.
  */
   void add_io_interface(io_intf io) {
     lock_guard gd { m_mutex };
-    m_io_intfs.push_back(io);
+    auto mbrs = std::make_shared<members>(*std::atomic_load(&m_members));
+    mbrs->m_members.push_back(member { io, std::make_shared<member_state>() });
+    publish(std::move(mbrs));
   }
 
 /**
@@ -76,7 +208,9 @@ public:
  */
   void remove_io_interface(io_intf io) {
     lock_guard gd { m_mutex };
-    chops::erase_where(m_io_intfs, io);
+    auto mbrs = std::make_shared<members>(*std::atomic_load(&m_members));
+    chops::erase_where_if(mbrs->m_members, [&io] (const member& m) { return m.m_io == io; } );
+    publish(std::move(mbrs));
   }
 
 /**
@@ -92,15 +226,77 @@ public:
     }
   }
 
+/**
+ *  @brief Set the policy for members whose output queue is over a byte threshold.
+ *
+ *  The bytes in the output queue of each member are checked before each buffer is sent
+ *  to it (unless the policy is @c none).
+ *
+ *  @param policy Slow member policy.
+ *
+ *  @param max_bytes A member with more bytes than this in its output queue is slow.
+ *
+ *  @param key_func For the @c conflate policy, returns the key of a buffer (e.g. a
+ *  symbol id), where only the latest buffer per key is kept for a slow member. If
+ *  empty, all buffers have the same key, i.e. only the latest buffer is kept.
+ *
+ *  @param flush_interval For the @c conflate policy with TCP or UDP IO handlers, how 
+ *  often a member holding conflated buffers is checked (on its executor) to see if it 
+ *  has caught up, and if so the buffers are sent. 0 disables the checks, in which 
+ *  case the buffers are sent by the next broadcast or a @c flush call.
+ */
+  void set_slow_member_policy(slow_member_policy policy, std::size_t max_bytes,
+                              conflate_key_func key_func = conflate_key_func(),
+                              std::chrono::milliseconds flush_interval = 
+                                  std::chrono::milliseconds(10)) {
+    lock_guard gd { m_mutex };
+    auto mbrs = std::make_shared<members>(*std::atomic_load(&m_members));
+    mbrs->m_policy = policy;
+    mbrs->m_max_bytes = max_bytes;
+    mbrs->m_key_func = std::move(key_func);
+    mbrs->m_flush_interval = flush_interval;
+    std::atomic_store(&m_members, snapshot(std::move(mbrs)));
+  }
+
+/**
+ *  @brief Send the buffers held by the @c conflate policy to every member that has 
+ *  caught up (i.e. is no longer over the byte threshold).
+ *
+ *  For TCP and UDP IO handlers the buffers are sent from a function object posted
+ *  to each executor.
+ */
+  void flush() const {
+    auto mbrs = std::atomic_load(&m_members);
+    if constexpr (batched) {
+      for (const auto& grp : mbrs->m_groups) {
+        asio::post(grp.m_exec, [mbrs, &grp] {
+            for (auto idx : grp.m_idxs) {
+              const auto& mbr = mbrs->m_members[idx];
+              if (auto p = mbr.m_io.get_shared_ptr()) {
+                lock_guard gd { mbr.m_state->m_mutex };
+                flush_conflated(*mbr.m_state, *p, mbrs->m_max_bytes);
+              }
+            }
+          }
+        );
+      }
+    }
+    else {
+      for (const auto& mbr : mbrs->m_members) {
+        if (auto p = mbr.m_io.get_shared_ptr()) {
+          lock_guard gd { mbr.m_state->m_mutex };
+          flush_conflated(*mbr.m_state, *p, mbrs->m_max_bytes);
+        }
+      }
+    }
+  }
+
 /**
  *  @brief Send a reference counted buffer to all @c basic_io_interface
  *  objects.
  */
   void send(chops::const_shared_buffer buf) const {
-    lock_guard gd { m_mutex };
-    for (const auto& io : m_io_intfs) {
-      io.send(buf);
-    }
+    send(std::move(buf), io_intf());
   }
 
 /**
@@ -108,10 +304,28 @@ public:
  *  objects except @c cur_io.
  */
   void send(chops::const_shared_buffer buf, io_intf cur_io) const { // TG
-    lock_guard gd { m_mutex };
-    for (const auto& io : m_io_intfs) {
-      if ( !(cur_io == io) ) {
-        io.send(buf);
+    auto mbrs = std::atomic_load(&m_members);
+    auto skip = cur_io.get_shared_ptr();
+    if constexpr (batched) {
+      for (const auto& grp : mbrs->m_groups) {
+        asio::post(grp.m_exec, [mbrs, &grp, buf, skip] {
+            for (auto idx : grp.m_idxs) {
+              const auto& mbr = mbrs->m_members[idx];
+              auto p = mbr.m_io.get_shared_ptr();
+              if (p && p != skip) {
+                deliver(*mbrs, mbr, *p, buf);
+              }
+            }
+          }
+        );
+      }
+    }
+    else {
+      for (const auto& mbr : mbrs->m_members) {
+        auto p = mbr.m_io.get_shared_ptr();
+        if (p && p != skip) {
+          deliver(*mbrs, mbr, *p, buf);
+        }
       }
     }
   }
@@ -152,8 +366,23 @@ public:
  *  @brief Return the number of @c basic_io_interface objects in the collection.
  */
   std::size_t size() const noexcept {
-    lock_guard gd { m_mutex };
-    return m_io_intfs.size();
+    return std::atomic_load(&m_members)->m_members.size();
+  }
+
+/**
+ *  @brief Return the number of broadcast buffers not sent to a member because of the
+ *  slow member policy.
+ *
+ *  @return Dropped count, zero if the object is not in the collection.
+ */
+  std::size_t dropped_count(io_intf io) const noexcept {
+    auto mbrs = std::atomic_load(&m_members);
+    for (const auto& mbr : mbrs->m_members) {
+      if (mbr.m_io == io) {
+        return mbr.m_state->m_dropped;
+      }
+    }
+    return 0u;
   }
 
 /**
@@ -163,14 +392,149 @@ public:
  */
   auto get_total_output_queue_stats() const noexcept {
     chops::net::output_queue_stats tot { };
-    lock_guard gd { m_mutex };
-    for (const auto& io : m_io_intfs) {
-      auto qs = io.get_output_queue_stats();
-      tot.output_queue_size += qs.output_queue_size;
-      tot.bytes_in_output_queue += qs.bytes_in_output_queue;
+    auto mbrs = std::atomic_load(&m_members);
+    for (const auto& mbr : mbrs->m_members) {
+      if (auto p = mbr.m_io.get_shared_ptr()) {
+        tot.output_queue_size += p->output_queue_size();
+        tot.bytes_in_output_queue += p->bytes_in_output_queue();
+      }
     }
     return tot;
   }
+
+private:
+
+  static bool send_buf(IOT& ioh, chops::const_shared_buffer buf) {
+    if constexpr (batched) {
+      return ioh.send_in_io_thread(std::move(buf));
+    }
+    else {
+      return ioh.send(std::move(buf));
+    }
+  }
+
+  static void deliver(const members& mbrs, const member& mbr, IOT& ioh, 
+                      const chops::const_shared_buffer& buf) {
+    if (mbrs.m_policy == slow_member_policy::none) {
+      send_buf(ioh, buf);
+      return;
+    }
+    auto& st = *mbr.m_state;
+    bool slow = ioh.bytes_in_output_queue() > mbrs.m_max_bytes;
+    switch (mbrs.m_policy) {
+      case slow_member_policy::skip:
+        if (slow) {
+          ++st.m_dropped;
+          return;
+        }
+        break;
+      case slow_member_policy::disconnect:
+        if (slow) {
+          ++st.m_dropped;
+          stop_member(mbr, ioh);
+          return;
+        }
+        break;
+      case slow_member_policy::conflate: {
+        lock_guard gd { st.m_mutex };
+        if (slow) {
+          auto key = mbrs.m_key_func ? mbrs.m_key_func(buf) : 0u;
+          if (!st.m_conflated.insert_or_assign(key, buf).second) {
+            ++st.m_dropped; // the previous buffer for the key is replaced
+          }
+          if constexpr (batched) {
+            start_flush_timer(mbr, ioh, mbrs.m_max_bytes, mbrs.m_flush_interval);
+          }
+          return;
+        }
+        flush_conflated(st, ioh, mbrs.m_max_bytes); // caught up, send the latest bufs first
+        break;
+      }
+      case slow_member_policy::none:
+        break;
+    }
+    send_buf(ioh, buf);
+  }
+
+  // for TCP and UDP IO handlers the stop is posted to the member's executor, as with the
+  // sends, so the close notifications do not run in the middle of a broadcast
+  static void stop_member(const member& mbr, IOT& ioh) {
+    if constexpr (batched) {
+      asio::post(ioh.get_socket().get_executor(), [io = mbr.m_io] {
+          if (auto p = io.get_shared_ptr()) {
+            p->stop_io();
+          }
+        }
+      );
+    }
+    else {
+      ioh.stop_io();
+    }
+  }
+
+  // called with the member state mutex held, returns false if the member is still slow
+  static bool flush_conflated(member_state& st, IOT& ioh, std::size_t max_bytes) {
+    if (st.m_conflated.empty()) {
+      return true;
+    }
+    if (ioh.bytes_in_output_queue() > max_bytes) {
+      return false;
+    }
+    for (auto& kb : st.m_conflated) {
+      send_buf(ioh, std::move(kb.second));
+    }
+    st.m_conflated.clear();
+    return true;
+  }
+
+  using timer_ptr = std::shared_ptr<asio::steady_timer>;
+
+  // called in the member's io_context thread with the member state mutex held; the 
+  // timer is owned by its handler, and is released when the conflated bufs are sent
+  // or the member's IO handler is stopped or destroyed
+  static void start_flush_timer(const member& mbr, IOT& ioh, std::size_t max_bytes,
+                                std::chrono::milliseconds interval) {
+    if (mbr.m_state->m_flush_timer_running || interval <= std::chrono::milliseconds::zero()) {
+      return;
+    }
+    mbr.m_state->m_flush_timer_running = true;
+    auto timer = std::make_shared<asio::steady_timer>(ioh.get_socket().get_executor());
+    wait_flush_timer(std::move(timer), mbr, max_bytes, interval);
+  }
+
+  static void wait_flush_timer(timer_ptr timer, member mbr, std::size_t max_bytes,
+                               std::chrono::milliseconds interval) {
+    timer->expires_after(interval);
+    auto& tmr = *timer;
+    tmr.async_wait([timer = std::move(timer), mbr = std::move(mbr), max_bytes, interval] 
+                   (const std::error_code& err) mutable {
+        auto& st = *mbr.m_state;
+        lock_guard gd { st.m_mutex };
+        auto p = mbr.m_io.get_shared_ptr();
+        if (err || !p || !p->is_io_started()) {
+          st.m_conflated.clear();
+          st.m_flush_timer_running = false;
+          return;
+        }
+        if (flush_conflated(st, *p, max_bytes)) {
+          st.m_flush_timer_running = false;
+          return;
+        }
+        wait_flush_timer(std::move(timer), std::move(mbr), max_bytes, interval);
+      }
+    );
+  }
+
+  // called with the membership mutex held
+  void publish(std::shared_ptr<members> mbrs) {
+    mbrs->m_groups.clear();
+    if constexpr (batched) {
+      const auto& m = mbrs->m_members;
+      mbrs->m_groups = detail::make_executor_groups<IOT>(m.size(), 
+                                 [&m] (std::size_t i) -> const io_intf& { return m[i].m_io; } );
+    }
+    std::atomic_store(&m_members, snapshot(std::move(mbrs)));
+  }
 };
 
 } // end net namespace
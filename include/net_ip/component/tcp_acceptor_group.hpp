@@ -0,0 +1,207 @@
+/** @file
+ *
+ *  @ingroup net_ip_component_module
+ *
+ *  @brief A group of TCP acceptors listening on the same endpoint, each in a different
+ *  @c io_context, using the @c SO_REUSEPORT socket option.
+ *
+ *  A single TCP acceptor performs all accepts (and all IO on the accepted connections)
+ *  through the threads running one @c io_context. With @c SO_REUSEPORT, multiple
+ *  listening sockets can be bound to the same endpoint and the kernel distributes
+ *  incoming connections across them. When each listening socket is owned by a different
+ *  @c io_context (typically each run by one thread), the connection IO is spread across
+ *  cores without any locking or cross-thread handoff.
+ *
+ *  @note This is not a necessary dependency of the @c net_ip library, and @c SO_REUSEPORT
+ *  is not available on every platform (the acceptors report an
+ *  @c std::errc::operation_not_supported error when started in that case).
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef TCP_ACCEPTOR_GROUP_HPP_INCLUDED
+#define TCP_ACCEPTOR_GROUP_HPP_INCLUDED
+
+#include "asio/ip/tcp.hpp"
+#include "asio/io_context.hpp"
+
+#include <memory> // std::make_shared
+#include <vector>
+#include <atomic>
+#include <functional> // std::function
+#include <system_error>
+#include <cstddef> // std::size_t
+#include <utility> // std::forward
+
+#include "net_ip/detail/tcp_acceptor.hpp"
+#include "net_ip/net_entity.hpp"
+#include "net_ip/io_interface.hpp"
+
+namespace chops {
+namespace net {
+
+/**
+ *  @brief Manage a set of TCP acceptors sharing one listening endpoint, presenting one
+ *  combined IO state change and error callback interface and an aggregated connection count.
+ *
+ *  The callbacks are invoked from the thread running the @c io_context of the acceptor
+ *  that accepted the connection, so they may be invoked concurrently and must be
+ *  thread-safe. The connection count passed to the IO state change callback is the
+ *  total across all acceptors in the group.
+ *
+ *  The connection count and the user callbacks are kept in a shared state object which
+ *  the per-acceptor callbacks hold by @c std::shared_ptr, so aborted accepts and connection
+ *  close notifications that are still in flight when the group is stopped or destroyed
+ *  are safely delivered (and any referenced application state must still be valid at
+ *  that point, e.g. by resetting the workers before it goes out of scope).
+ *
+ *  The endpoint must have a specific port: with port 0 each acceptor binds to a
+ *  different ephemeral port, instead of sharing (and sharding) one port.
+ */
+class tcp_acceptor_group {
+private:
+  using io_state_chg_cb = std::function<void (tcp_io_interface, std::size_t, bool)>;
+  using error_cb = std::function<void (tcp_io_interface, std::error_code)>;
+
+  struct group_state {
+    std::atomic_size_t    m_conn_count { 0u };
+    io_state_chg_cb       m_io_state_chg_cb;
+    error_cb              m_error_cb;
+  };
+
+  std::vector<detail::tcp_acceptor_ptr> m_acceptors;
+  std::shared_ptr<group_state>          m_state;
+
+public:
+
+/**
+ *  @brief Construct a @c tcp_acceptor_group, creating one acceptor per @c io_context.
+ *
+ *  @param beg Beginning of a sequence of @c asio::io_context references (or objects
+ *  convertible to a reference, such as @c std::reference_wrapper).
+ *
+ *  @param end End of the sequence.
+ *
+ *  @param endp Endpoint that each acceptor binds to when started.
+ *
+ *  @param reuse_addr If @c true (default), the @c reuse_address socket option is also set.
+ */
+  template <typename Iter>
+  tcp_acceptor_group(Iter beg, Iter end, const asio::ip::tcp::endpoint& endp,
+                     bool reuse_addr = true) :
+      m_acceptors(), m_state(std::make_shared<group_state>()) {
+    for (; beg != end; ++beg) {
+      asio::io_context& ioc = *beg;
+      m_acceptors.push_back(std::make_shared<detail::tcp_acceptor>(ioc, endp, reuse_addr, true));
+    }
+  }
+
+  ~tcp_acceptor_group() { stop(); }
+
+private:
+  tcp_acceptor_group(const tcp_acceptor_group&) = delete;
+  tcp_acceptor_group(tcp_acceptor_group&&) = delete;
+  tcp_acceptor_group& operator=(const tcp_acceptor_group&) = delete;
+  tcp_acceptor_group& operator=(tcp_acceptor_group&&) = delete;
+
+public:
+
+/**
+ *  @brief Start all of the acceptors in the group.
+ *
+ *  The function object signatures are the same as for the @c basic_net_entity @c start
+ *  method, except that the count in the IO state change callback is the total number
+ *  of connections in the group. Each start begins a new connection count.
+ *
+ *  An acceptor that fails to bind or listen (e.g. another socket without @c SO_REUSEPORT
+ *  holds the port, or @c SO_REUSEPORT is not supported) reports the error through the
+ *  error callback and is left stopped, while the other acceptors keep listening. In
+ *  that partial failure state @c is_started returns @c true, and @c stop must be called
+ *  before the group can be started again.
+ *
+ *  @return Number of acceptors that started and are listening, which is less than
+ *  @c size if any failed, or 0 if the group was already started or every acceptor failed.
+ */
+  template <typename F1, typename F2>
+  std::size_t start(F1&& io_state_chg_func, F2&& err_func) {
+    if (is_started()) {
+      return 0u;
+    }
+    m_state = std::make_shared<group_state>();
+    m_state->m_io_state_chg_cb = std::forward<F1>(io_state_chg_func);
+    m_state->m_error_cb = std::forward<F2>(err_func);
+    std::size_t num_started = 0u;
+    for (auto& acc : m_acceptors) {
+      bool started = acc->start( [st = m_state] (tcp_io_interface io, std::size_t, bool starting) {
+          auto cnt = starting ? st->m_conn_count.fetch_add(1u) + 1u :
+                                st->m_conn_count.fetch_sub(1u) - 1u;
+          st->m_io_state_chg_cb(io, cnt, starting);
+        },
+        [st = m_state] (tcp_io_interface io, std::error_code err) {
+          st->m_error_cb(io, err);
+        }
+      );
+      num_started += started ? 1u : 0u;
+    }
+    return num_started;
+  }
+
+/**
+ *  @brief Stop all of the acceptors in the group, which closes all of the connections.
+ *
+ *  @return @c false if already stopped, otherwise @c true.
+ */
+  bool stop() {
+    bool stopped = false;
+    for (auto& acc : m_acceptors) {
+      stopped = acc->stop() || stopped;
+    }
+    return stopped;
+  }
+
+/**
+ *  @brief Query whether any acceptor in the group has been started.
+ */
+  bool is_started() const noexcept {
+    for (const auto& acc : m_acceptors) {
+      if (acc->is_started()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+/**
+ *  @brief Return the number of acceptors in the group.
+ */
+  std::size_t size() const noexcept { return m_acceptors.size(); }
+
+/**
+ *  @brief Return the total number of connections across all acceptors.
+ */
+  std::size_t connection_count() const noexcept { return m_state->m_conn_count; }
+
+/**
+ *  @brief Return a @c tcp_acceptor_net_entity for an individual acceptor, e.g. to
+ *  access the listening socket.
+ *
+ *  @param idx Index of the acceptor, corresponding to the @c io_context sequence
+ *  order at construction.
+ */
+  tcp_acceptor_net_entity get_acceptor(std::size_t idx) const {
+    return tcp_acceptor_net_entity(m_acceptors.at(idx));
+  }
+
+};
+
+} // end net namespace
+} // end chops namespace
+
+#endif
+
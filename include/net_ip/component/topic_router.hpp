@@ -0,0 +1,440 @@
+/** @file
+ *
+ *  @ingroup net_ip_component_module
+ *
+ *  @brief A class template that routes published messages to the @c basic_io_interface
+ *  objects subscribed to a topic.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef TOPIC_ROUTER_HPP_INCLUDED
+#define TOPIC_ROUTER_HPP_INCLUDED
+
+#include <cstddef> // std::size_t
+#include <utility> // std::move
+#include <algorithm> // std::find_if
+#include <functional> // std::hash
+
+#include <mutex>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <memory> // std::shared_ptr, std::weak_ptr, std::atomic_load, std::atomic_store
+
+#include "asio/post.hpp"
+
+#include "net_ip/basic_io_interface.hpp"
+#include "net_ip/component/send_to_all.hpp" // detail::make_executor_groups
+
+#include "utility/erase_where.hpp"
+#include "marshall/shared_buffer.hpp"
+
+namespace chops {
+namespace net {
+
+/**
+ *  @brief Route each published buffer to the @c basic_io_interface objects subscribed to
+ *  its topic (e.g. a symbol), a publish / subscribe generalization of @c send_to_all.
+ *
+ *  The topic index is a flat open addressing hash table (linear probing) from topic to
+ *  an immutable subscriber array. The whole index uses the same copy-on-write snapshot
+ *  as the @c send_to_all membership, replaced when a subscription changes. A 
+ *  subscription change copies the table slots (a hash and a pointer per topic) and the
+ *  subscribers of the changed topics only. A reverse index holds the topics of each
+ *  subscriber, so unsubscribing from every topic (e.g. on disconnect) only visits the
+ *  topics of that subscriber, and publishes a single new snapshot.
+ *
+ *  A @c publish loads the index snapshot, looks up the topic, and sends to the subscribers,
+ *  without taking the subscription mutex. Publishers do not block each other or wait for
+ *  a subscription change.
+ *
+ *  As in @c send_to_all, the subscribers of a topic that are TCP or UDP IO handlers are
+ *  grouped by executor, and a publish posts one function object per executor which
+ *  queues the buffer on every subscriber in that group. Subscribers whose IO handler
+ *  is closed are skipped.
+ *
+ *  A function object operator overload is provided so that a @c std::ref to a
+ *  @c topic_router object can be used in composing function objects for
+ *  @c io_state_change calls: when an IO handler starts it is subscribed to the initial
+ *  topics (if any were supplied at construction), and when it stops it is unsubscribed
+ *  from every topic.
+ *
+ *  This class is thread-safe for concurrent access.
+ *
+ */
+template <typename IOT>
+class topic_router {
+private:
+  using lock_guard = std::lock_guard<std::mutex>;
+  using io_intf    = basic_io_interface<IOT>;
+  using io_wptr    = std::weak_ptr<IOT>;
+  using io_wptrs   = std::vector<io_wptr>;
+
+  static constexpr bool batched = detail::has_send_in_io_thread<IOT>::value;
+
+  static constexpr std::size_t min_index_slots = 16u; // must be a power of 2
+
+  struct topic_entry {
+    std::string  m_topic;
+    io_wptrs     m_subs;
+    std::vector<detail::executor_group<IOT>>  m_groups; // only used for batched publishes
+  };
+
+  using entry_ptr  = std::shared_ptr<const topic_entry>;
+
+  struct index_slot {
+    std::size_t  m_hash;
+    entry_ptr    m_entry; // empty slot when null
+  };
+
+  struct topic_index {
+    std::vector<index_slot>  m_slots; // size is a power of 2, at most half full
+    std::size_t              m_size;
+  };
+
+  using index_ptr  = std::shared_ptr<const topic_index>;
+
+  struct sub_topics {
+    io_wptr                   m_wptr;
+    std::vector<std::string>  m_topics;
+  };
+
+  using sub_index  = std::unordered_map<const IOT*, sub_topics>;
+
+private:
+  std::mutex                m_mutex; // serializes subscription changes
+  index_ptr                 m_index; // accessed with std::atomic_load and std::atomic_store
+  sub_index                 m_subs; // protected by m_mutex
+  std::vector<std::string>  m_initial_topics;
+
+public:
+
+/**
+ *  @brief Construct a @c topic_router.
+ *
+ *  @param initial_topics Topics that each IO handler is subscribed to when started
+ *  through the function object operator.
+ */
+  explicit topic_router(std::vector<std::string> initial_topics = std::vector<std::string>()) :
+    m_mutex(), 
+    m_index(std::make_shared<const topic_index>(topic_index { std::vector<index_slot>(min_index_slots), 0u })),
+    m_subs(), m_initial_topics(std::move(initial_topics)) { }
+
+/**
+ *  @brief Subscribe a @c basic_io_interface object to a topic.
+ *
+ *  @return @c false if already subscribed to the topic or not associated with an IO
+ *  handler, otherwise @c true.
+ */
+  bool subscribe(std::string_view topic, io_intf io) {
+    auto p = io.get_shared_ptr();
+    if (!p) {
+      return false;
+    }
+    io_wptr wp(p);
+    lock_guard gd { m_mutex };
+    auto r = m_subs.find(p.get());
+    if (r != m_subs.end() && !same_io(r->second.m_wptr, wp)) {
+      // a destroyed IO handler at the same address was never unsubscribed
+      remove_topics(r->second);
+      m_subs.erase(r);
+    }
+    auto idx = std::atomic_load(&m_index);
+    auto h = hash_topic(topic);
+    const auto& entry = idx->m_slots[find_slot(*idx, h, topic)].m_entry;
+    io_wptrs new_subs;
+    if (entry) {
+      const auto& subs = entry->m_subs;
+      if (std::find_if(subs.begin(), subs.end(), 
+                       [&wp] (const io_wptr& s) { return same_io(s, wp); } ) != subs.end()) {
+        return false;
+      }
+      new_subs = subs;
+    }
+    new_subs.push_back(wp);
+    auto new_idx = *idx;
+    store_entry(new_idx, h, make_entry(std::string(topic), std::move(new_subs)));
+    publish_index(std::move(new_idx));
+    auto& st = m_subs[p.get()];
+    st.m_wptr = wp;
+    st.m_topics.emplace_back(topic);
+    return true;
+  }
+
+/**
+ *  @brief Unsubscribe a @c basic_io_interface object from a topic, removing the topic
+ *  when it has no more subscribers.
+ *
+ *  @return @c false if not subscribed to the topic or not associated with an IO handler,
+ *  otherwise @c true.
+ */
+  bool unsubscribe(std::string_view topic, io_intf io) {
+    auto p = io.get_shared_ptr();
+    if (!p) {
+      return false;
+    }
+    lock_guard gd { m_mutex };
+    auto new_idx = *std::atomic_load(&m_index);
+    if (!remove_sub(new_idx, topic, io_wptr(p))) {
+      return false;
+    }
+    publish_index(std::move(new_idx));
+    auto r = m_subs.find(p.get());
+    if (r != m_subs.end()) {
+      chops::erase_where(r->second.m_topics, topic);
+      if (r->second.m_topics.empty()) {
+        m_subs.erase(r);
+      }
+    }
+    return true;
+  }
+
+/**
+ *  @brief Unsubscribe a @c basic_io_interface object from every topic.
+ *
+ *  If the object is no longer associated with an IO handler, every subscriber whose IO
+ *  handler has been destroyed is unsubscribed.
+ *
+ *  @return Number of topics the object was unsubscribed from.
+ */
+  std::size_t unsubscribe_all(io_intf io) {
+    lock_guard gd { m_mutex };
+    if (auto p = io.get_shared_ptr()) {
+      auto r = m_subs.find(p.get());
+      if (r == m_subs.end()) {
+        return 0u;
+      }
+      auto cnt = remove_topics(r->second);
+      m_subs.erase(r);
+      return cnt;
+    }
+    std::size_t cnt = 0u;
+    for (auto r = m_subs.begin(); r != m_subs.end(); ) {
+      if (!r->second.m_wptr.expired()) {
+        ++r;
+        continue;
+      }
+      cnt += remove_topics(r->second);
+      r = m_subs.erase(r);
+    }
+    return cnt;
+  }
+
+/**
+ *  @brief Interface for @c io_state_change parameter of @c start
+ *  method.
+ */
+  void operator() (io_intf io, std::size_t, bool starting) {
+    if (starting) {
+      for (const auto& topic : m_initial_topics) {
+        subscribe(topic, io);
+      }
+    }
+    else {
+      unsubscribe_all(io);
+    }
+  }
+
+/**
+ *  @brief Send a reference counted buffer to all subscribers of a topic.
+ *
+ *  @return Number of subscribers the buffer was sent to, not counting subscribers whose
+ *  IO handler is closed. For TCP and UDP IO handlers the buffer is queued when the 
+ *  posted function object runs, so this is the number of open subscribers at the time
+ *  of the publish.
+ */
+  std::size_t publish(std::string_view topic, chops::const_shared_buffer buf) const {
+    auto idx = std::atomic_load(&m_index);
+    const auto& entry = idx->m_slots[find_slot(*idx, hash_topic(topic), topic)].m_entry;
+    if (!entry) {
+      return 0u;
+    }
+    std::size_t cnt = 0u;
+    if constexpr (batched) {
+      for (const auto& grp : entry->m_groups) {
+        for (auto i : grp.m_idxs) {
+          cnt += entry->m_subs[i].expired() ? 0u : 1u;
+        }
+        asio::post(grp.m_exec, [entry, &grp, buf] {
+            for (auto i : grp.m_idxs) {
+              if (auto p = entry->m_subs[i].lock()) {
+                p->send_in_io_thread(buf);
+              }
+            }
+          }
+        );
+      }
+    }
+    else {
+      for (const auto& wp : entry->m_subs) {
+        auto p = wp.lock();
+        if (p && p->send(buf)) {
+          ++cnt;
+        }
+      }
+    }
+    return cnt;
+  }
+
+/**
+ *  @brief Copy the bytes, create a reference counted buffer, then send it to all
+ *  subscribers of a topic.
+ */
+  std::size_t publish(std::string_view topic, const void* buf, std::size_t sz) const {
+    return publish(topic, chops::const_shared_buffer(buf, sz));
+  }
+
+/**
+ *  @brief Move the buffer from a writable reference counted buffer to a
+ *  immutable reference counted buffer, then send to all subscribers of a topic.
+ */
+  std::size_t publish(std::string_view topic, chops::mutable_shared_buffer&& buf) const {
+    return publish(topic, chops::const_shared_buffer(std::move(buf)));
+  }
+
+/**
+ *  @brief Return the number of topics with at least one subscriber.
+ */
+  std::size_t topic_count() const {
+    return std::atomic_load(&m_index)->m_size;
+  }
+
+/**
+ *  @brief Return the number of subscribers to a topic.
+ */
+  std::size_t subscriber_count(std::string_view topic) const {
+    auto idx = std::atomic_load(&m_index);
+    const auto& entry = idx->m_slots[find_slot(*idx, hash_topic(topic), topic)].m_entry;
+    return entry ? entry->m_subs.size() : 0u;
+  }
+
+private:
+
+  // identity of the IO handler, which still distinguishes destroyed IO handlers
+  static bool same_io(const io_wptr& lhs, const io_wptr& rhs) noexcept {
+    return !lhs.owner_before(rhs) && !rhs.owner_before(lhs);
+  }
+
+  static std::size_t hash_topic(std::string_view topic) noexcept {
+    return std::hash<std::string_view>{}(topic);
+  }
+
+  // returns the slot holding the topic, or the empty slot ending the probe sequence
+  static std::size_t find_slot(const topic_index& idx, std::size_t h, std::string_view topic) noexcept {
+    auto mask = idx.m_slots.size() - 1u;
+    auto i = h & mask;
+    while (idx.m_slots[i].m_entry && 
+           (idx.m_slots[i].m_hash != h || idx.m_slots[i].m_entry->m_topic != topic)) {
+      i = (i + 1u) & mask;
+    }
+    return i;
+  }
+
+  static void rehash(topic_index& idx, std::size_t num_slots) {
+    std::vector<index_slot> slots(num_slots);
+    slots.swap(idx.m_slots);
+    for (auto& s : slots) {
+      if (s.m_entry) {
+        auto i = find_slot(idx, s.m_hash, s.m_entry->m_topic);
+        idx.m_slots[i] = std::move(s);
+      }
+    }
+  }
+
+  // adds or replaces the entry of a topic
+  static void store_entry(topic_index& idx, std::size_t h, entry_ptr entry) {
+    auto i = find_slot(idx, h, entry->m_topic);
+    if (!idx.m_slots[i].m_entry) {
+      if ((idx.m_size + 1u) * 2u > idx.m_slots.size()) {
+        rehash(idx, idx.m_slots.size() * 2u);
+        i = find_slot(idx, h, entry->m_topic);
+      }
+      ++idx.m_size;
+    }
+    idx.m_slots[i] = index_slot { h, std::move(entry) };
+  }
+
+  // backward shift deletion, keeping every remaining topic reachable from its home slot
+  static void erase_slot(topic_index& idx, std::size_t i) noexcept {
+    auto mask = idx.m_slots.size() - 1u;
+    for (auto j = (i + 1u) & mask; idx.m_slots[j].m_entry; j = (j + 1u) & mask) {
+      auto home = idx.m_slots[j].m_hash & mask;
+      bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+      if (!stays) {
+        idx.m_slots[i] = std::move(idx.m_slots[j]);
+        i = j;
+      }
+    }
+    idx.m_slots[i] = index_slot { 0u, entry_ptr() };
+    --idx.m_size;
+  }
+
+  static entry_ptr make_entry(std::string topic, io_wptrs subs) {
+    auto entry = std::make_shared<topic_entry>(topic_entry { std::move(topic), std::move(subs), { } });
+    if constexpr (batched) {
+      const auto& s = entry->m_subs;
+      entry->m_groups = detail::make_executor_groups<IOT>(s.size(), 
+                                    [&s] (std::size_t i) { return io_intf(s[i]); } );
+    }
+    return entry;
+  }
+
+  // the subscription mutex must be held
+  void publish_index(topic_index&& idx) {
+    std::atomic_store(&m_index, index_ptr(std::make_shared<const topic_index>(std::move(idx))));
+  }
+
+  // replaces the entry in the index copy with a copy without the subscriber, removing 
+  // the topic when there are no subscribers left
+  static bool remove_sub(topic_index& idx, std::string_view topic, const io_wptr& wp) {
+    auto i = find_slot(idx, hash_topic(topic), topic);
+    auto entry = idx.m_slots[i].m_entry;
+    if (!entry) {
+      return false;
+    }
+    const auto& subs = entry->m_subs;
+    auto it = std::find_if(subs.begin(), subs.end(), 
+                           [&wp] (const io_wptr& s) { return same_io(s, wp); } );
+    if (it == subs.end()) {
+      return false;
+    }
+    if (subs.size() == 1u) {
+      erase_slot(idx, i);
+      return true;
+    }
+    auto new_subs = subs;
+    new_subs.erase(new_subs.begin() + (it - subs.begin()));
+    idx.m_slots[i].m_entry = make_entry(entry->m_topic, std::move(new_subs));
+    return true;
+  }
+
+  // the subscription mutex must be held
+  std::size_t remove_topics(const sub_topics& st) {
+    auto new_idx = *std::atomic_load(&m_index);
+    std::size_t cnt = 0u;
+    for (const auto& topic : st.m_topics) {
+      if (remove_sub(new_idx, topic, st.m_wptr)) {
+        ++cnt;
+      }
+    }
+    if (cnt != 0u) {
+      publish_index(std::move(new_idx));
+    }
+    return cnt;
+  }
+
+};
+
+} // end net namespace
+} // end chops namespace
+
+#endif
+
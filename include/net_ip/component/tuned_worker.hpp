@@ -0,0 +1,213 @@
+/** @file
+ *
+ *  @ingroup net_ip_component_module
+ *
+ *  @brief Executor and work guard class with multiple threads, CPU affinity, real-time
+ *  scheduling priority, and a busy-poll run mode, for low latency deployments.
+ *
+ *  A thread blocked in the OS event demultiplexer (e.g. @c epoll) has to be woken up
+ *  when data arrives, adding latency (and jitter) to every message. In spin mode the
+ *  threads instead loop on @c poll, only falling back to a blocking @c run_one call
+ *  after a configurable spin budget has elapsed without any ready handlers. Pinning
+ *  the spinning threads to isolated CPUs, and optionally running them with @c SCHED_FIFO
+ *  priority, avoids migrations and preemption.
+ *
+ *  CPU affinity and scheduling priority are only supported on Linux; elsewhere they are
+ *  reported as @c std::errc::operation_not_supported.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef TUNED_WORKER_HPP_INCLUDED
+#define TUNED_WORKER_HPP_INCLUDED
+
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cstddef> // std::size_t
+#include <system_error>
+
+#include <exception>
+#include <iostream>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "asio/io_context.hpp"
+#include "asio/executor.hpp"
+#include "asio/executor_work_guard.hpp"
+
+namespace chops {
+namespace net {
+
+/**
+ *  @brief Thread configuration for a @c tuned_worker.
+ */
+struct worker_options {
+  // number of threads calling run (or poll) on the io_context
+  std::size_t                num_threads = 1u;
+  // CPU for each thread, thread i is pinned to cpus[i % size], empty means no pinning
+  std::vector<int>           cpus;
+  // SCHED_FIFO priority (1 - 99) for each thread, 0 means default scheduling
+  int                        fifo_priority = 0;
+  // busy-poll time without ready handlers before blocking, 0 means always block
+  std::chrono::microseconds  spin_budget { 0 };
+};
+
+/**
+ *  @brief Convenience class that combines an executor work guard and a set of threads,
+ *  with CPU affinity, real-time priority, and busy-poll options.
+ *
+ *  @note With more than one thread the handlers of a single IO handler or net entity may
+ *  be invoked concurrently, which the @c net_ip library does not synchronize. Use one
+ *  thread per @c io_context for @c net_ip entities (e.g. multiple @c tuned_worker
+ *  objects, each with one pinned thread).
+ *
+ *  @note This class is not a necessary dependency of the @c net_ip library, but
+ *  is provided for convenience in many use cases.
+ */
+class tuned_worker {
+private:
+  asio::io_context                                           m_ioc;
+  asio::executor_work_guard<asio::io_context::executor_type> m_wg;
+  worker_options                                             m_opts;
+  std::vector<std::thread>                                   m_run_thrs;
+
+public:
+  explicit tuned_worker(const worker_options& opts) :
+    m_ioc(), m_wg(asio::make_work_guard(m_ioc)), m_opts(opts), m_run_thrs() { }
+
+/**
+ *  @brief Provide access to the @c io_context.
+ *
+ *  @return Reference to a @c asio::io_context.
+ */
+  asio::io_context& get_io_context() { return m_ioc; }
+
+/**
+ *  @brief Start the threads that invoke the underlying asynchronous operations,
+ *  applying the CPU affinity and scheduling priority.
+ *
+ *  @return The first error from setting CPU affinity or scheduling priority (e.g.
+ *  @c EPERM when not privileged for @c SCHED_FIFO), otherwise an empty error code. The
+ *  threads are running in either case.
+ */
+  std::error_code start() {
+    std::error_code first_err;
+    for (std::size_t i = 0u; i < m_opts.num_threads; ++i) {
+      m_run_thrs.emplace_back([this] () {
+          try {
+            if (m_opts.spin_budget.count() > 0) {
+              spin_run();
+            }
+            else {
+              m_ioc.run();
+            }
+          }
+          catch (const std::exception& e) {
+            std::cerr << "std::exception caught in tuned_worker::start: " << e.what() << std::endl;
+          }
+          catch (...) {
+            std::cerr << "Unknown exception caught in tuned_worker::start" << std::endl;
+          }
+        }
+      );
+      auto err = tune_thread(m_run_thrs.back(), i);
+      if (err && !first_err) {
+        first_err = err;
+      }
+    }
+    return first_err;
+  }
+
+/**
+ *  @brief Shutdown the executor and join the threads, abandoning any outstanding operations or handlers.
+ */
+  void stop() {
+    m_ioc.stop();
+    join_thrs();
+  }
+
+/**
+ *  @brief Reset the internal work guard and join the threads, waiting for outstanding operations or
+ *  handlers to complete.
+ */
+  void reset() {
+    m_wg.reset();
+    join_thrs();
+  }
+
+private:
+
+  void join_thrs() {
+    for (auto& thr : m_run_thrs) {
+      thr.join();
+    }
+    m_run_thrs.clear();
+  }
+
+  // poll returns without blocking; once the work guard is reset and all work is done
+  // poll (or run_one) stops the io_context
+  void spin_run() {
+    using clock = std::chrono::steady_clock;
+    while (!m_ioc.stopped()) {
+      auto deadline = clock::now() + m_opts.spin_budget;
+      while (m_ioc.poll() == 0u) {
+        if (m_ioc.stopped()) {
+          return;
+        }
+        if (clock::now() >= deadline) {
+          m_ioc.run_one(); // idle, block until a handler is ready
+          break;
+        }
+      }
+    }
+  }
+
+  std::error_code tune_thread(std::thread& thr, std::size_t idx) {
+    if (m_opts.cpus.empty() && m_opts.fifo_priority == 0) {
+      return std::error_code();
+    }
+#if defined(__linux__)
+    // both settings are applied even if one fails, and the first error is returned
+    std::error_code first_err;
+    if (!m_opts.cpus.empty()) {
+      cpu_set_t cpu_set;
+      CPU_ZERO(&cpu_set);
+      CPU_SET(m_opts.cpus[idx % m_opts.cpus.size()], &cpu_set);
+      if (int rc = pthread_setaffinity_np(thr.native_handle(), sizeof(cpu_set), &cpu_set)) {
+        first_err = std::error_code(rc, std::system_category());
+      }
+    }
+    if (m_opts.fifo_priority != 0) {
+      sched_param param { };
+      param.sched_priority = m_opts.fifo_priority;
+      if (int rc = pthread_setschedparam(thr.native_handle(), SCHED_FIFO, &param)) {
+        if (!first_err) {
+          first_err = std::error_code(rc, std::system_category());
+        }
+      }
+    }
+    return first_err;
+#else
+    (void) thr;
+    (void) idx;
+    return std::make_error_code(std::errc::operation_not_supported);
+#endif
+  }
+
+};
+
+}  // end net namespace
+}  // end chops namespace
+
+#endif
+
@@ -0,0 +1,202 @@
+/** @file
+ *
+ *  @ingroup net_ip_component_module
+ *
+ *  @brief A pool of workers, each running one @c io_context in one thread, with
+ *  distribution of TCP connections across the pool.
+ *
+ *  Running multiple threads on a single @c io_context requires strands (or locking)
+ *  for every connection. Instead, each @c io_context in a @c worker_pool is run by
+ *  exactly one thread, and each accepted connection is associated with one
+ *  @c io_context, so all of the reads, writes, and callbacks for a connection stay on
+ *  one thread while throughput scales with the number of cores.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef WORKER_POOL_HPP_INCLUDED
+#define WORKER_POOL_HPP_INCLUDED
+
+#include <vector>
+#include <memory> // std::unique_ptr
+#include <atomic>
+#include <cstddef> // std::size_t
+#include <thread> // std::thread::hardware_concurrency
+#include <functional> // std::reference_wrapper
+
+#include "asio/io_context.hpp"
+
+#include "net_ip/component/worker.hpp"
+#include "net_ip/io_context_distributor.hpp"
+
+namespace chops {
+namespace net {
+
+/**
+ *  @brief Policy for selecting the @c io_context of each new connection.
+ */
+enum class distribution_policy {
+  round_robin, // each connection goes to the next io_context in turn
+  least_loaded // each connection goes to the io_context with the fewest connections
+};
+
+/**
+ *  @brief A fixed size pool of @c worker objects, providing @c io_context_distributor
+ *  function objects for a TCP acceptor.
+ *
+ *  @note This class is not a necessary dependency of the @c net_ip library, but
+ *  is provided for convenience in many use cases.
+ */
+class worker_pool {
+private:
+  std::vector<std::unique_ptr<worker>>  m_workers;
+  std::unique_ptr<std::atomic_size_t[]> m_loads;
+  std::atomic_size_t                    m_next;
+  distribution_policy                   m_policy;
+
+public:
+
+/**
+ *  @brief Construct a @c worker_pool.
+ *
+ *  @param num_workers Number of workers (each is one @c io_context and one thread),
+ *  defaulting to the number of hardware threads.
+ *
+ *  @param policy Distribution policy for connections.
+ */
+  explicit worker_pool(std::size_t num_workers = std::thread::hardware_concurrency(),
+                       distribution_policy policy = distribution_policy::round_robin) :
+      m_workers(), m_loads(), m_next(0u), m_policy(policy) {
+    if (num_workers == 0u) {
+      num_workers = 1u;
+    }
+    for (std::size_t i = 0u; i < num_workers; ++i) {
+      m_workers.push_back(std::make_unique<worker>());
+    }
+    m_loads = std::make_unique<std::atomic_size_t[]>(num_workers);
+    for (std::size_t i = 0u; i < num_workers; ++i) {
+      m_loads[i] = 0u;
+    }
+  }
+
+/**
+ *  @brief Start the thread of every worker.
+ */
+  void start() {
+    for (auto& w : m_workers) {
+      w->start();
+    }
+  }
+
+/**
+ *  @brief Shutdown every executor and join the threads, abandoning outstanding
+ *  operations or handlers.
+ */
+  void stop() {
+    for (auto& w : m_workers) {
+      w->stop();
+    }
+  }
+
+/**
+ *  @brief Reset every work guard and join the threads, waiting for outstanding
+ *  operations or handlers to complete.
+ */
+  void reset() {
+    for (auto& w : m_workers) {
+      w->reset();
+    }
+  }
+
+/**
+ *  @brief Return the number of workers in the pool.
+ */
+  std::size_t size() const noexcept { return m_workers.size(); }
+
+/**
+ *  @brief Provide access to the @c io_context of a worker.
+ */
+  asio::io_context& get_io_context(std::size_t idx) { return m_workers.at(idx)->get_io_context(); }
+
+/**
+ *  @brief Return references to all of the @c io_context objects, e.g. for the
+ *  @c tcp_acceptor_group constructor.
+ */
+  std::vector<std::reference_wrapper<asio::io_context>> get_io_contexts() {
+    std::vector<std::reference_wrapper<asio::io_context>> iocs;
+    for (auto& w : m_workers) {
+      iocs.push_back(std::ref(w->get_io_context()));
+    }
+    return iocs;
+  }
+
+/**
+ *  @brief Return the number of connections currently distributed to a worker, including
+ *  a pending accept.
+ */
+  std::size_t load(std::size_t idx) const { return m_loads[idx]; }
+
+/**
+ *  @brief Select an @c io_context according to the distribution policy, and count
+ *  it as one more connection for that worker.
+ *
+ *  This method can be called concurrently.
+ */
+  asio::io_context& acquire_io_context() {
+    std::size_t idx = 0u;
+    if (m_policy == distribution_policy::least_loaded) {
+      // a racing acquire may pick the same worker, which is an acceptable imbalance
+      std::size_t min_load = m_loads[0];
+      for (std::size_t i = 1u; i < size(); ++i) {
+        std::size_t ld = m_loads[i];
+        if (ld < min_load) {
+          min_load = ld;
+          idx = i;
+        }
+      }
+    }
+    else {
+      idx = m_next.fetch_add(1u, std::memory_order_relaxed) % size();
+    }
+    ++m_loads[idx];
+    return m_workers[idx]->get_io_context();
+  }
+
+/**
+ *  @brief Count one less connection for the worker running the @c io_context.
+ */
+  void release_io_context(asio::io_context& ioc) {
+    for (std::size_t i = 0u; i < size(); ++i) {
+      if (&m_workers[i]->get_io_context() == &ioc) {
+        --m_loads[i];
+        return;
+      }
+    }
+  }
+
+/**
+ *  @brief Return an @c io_context_distributor for this pool, to be used when creating
+ *  a TCP acceptor (see @c net_ip @c make_tcp_acceptor).
+ *
+ *  The @c worker_pool must outlive any TCP acceptor using the distributor.
+ */
+  io_context_distributor get_distributor() {
+    return io_context_distributor {
+      [this] () -> asio::io_context& { return acquire_io_context(); },
+      [this] (asio::io_context& ioc) { release_io_context(ioc); }
+    };
+  }
+
+};
+
+}  // end net namespace
+}  // end chops namespace
+
+#endif
+
@@ -0,0 +1,113 @@
+/** @file
+ *
+ *  @ingroup net_ip_module
+ *
+ *  @brief A slot map of the IO handlers owned by a net entity (e.g. the TCP connections
+ *  of an acceptor), with constant time insertion and removal, and the process wide
+ *  connection ids of the IO handlers.
+ *
+ *  Each IO handler stores the index of its slot, so removal does not search the
+ *  container, and freed slots are reused before the container grows. Disconnect storms
+ *  with many connections are therefore linear in the number of disconnects rather than
+ *  quadratic.
+ *
+ *  @note For internal use only.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef CONNECTION_REGISTRY_HPP_INCLUDED
+#define CONNECTION_REGISTRY_HPP_INCLUDED
+
+#include <cstddef> // std::size_t
+#include <vector>
+#include <memory> // std::shared_ptr
+#include <atomic>
+#include <utility> // std::move
+
+namespace chops {
+namespace net {
+namespace detail {
+
+// connection ids are unique within the process, and 0 is never used
+inline std::size_t next_connection_id() noexcept {
+  static std::atomic_size_t next_id { 1u };
+  return next_id.fetch_add(1u, std::memory_order_relaxed);
+}
+
+// not thread safe, the owning entity provides any locking; the IO handler type provides
+// get_registry_slot and set_registry_slot
+template <typename IOT>
+class connection_registry {
+public:
+  using io_ptr = std::shared_ptr<IOT>;
+
+private:
+  std::vector<io_ptr>       m_slots;
+  std::vector<std::size_t>  m_free_slots;
+  std::size_t               m_size;
+
+public:
+  connection_registry() noexcept : m_slots(), m_free_slots(), m_size(0u) { }
+
+  // returns the number of IO handlers after the add
+  std::size_t add(io_ptr iop) {
+    std::size_t slot = m_slots.size();
+    if (m_free_slots.empty()) {
+      m_slots.push_back(io_ptr());
+    }
+    else {
+      slot = m_free_slots.back();
+      m_free_slots.pop_back();
+    }
+    iop->set_registry_slot(slot);
+    m_slots[slot] = std::move(iop);
+    return ++m_size;
+  }
+
+  // false if the IO handler is not in the registry, e.g. already removed
+  bool remove(const io_ptr& iop) {
+    auto slot = iop->get_registry_slot();
+    if (slot >= m_slots.size() || m_slots[slot] != iop) {
+      return false;
+    }
+    m_slots[slot].reset();
+    m_free_slots.push_back(slot);
+    --m_size;
+    return true;
+  }
+
+  bool contains(const io_ptr& iop) const noexcept {
+    auto slot = iop->get_registry_slot();
+    return slot < m_slots.size() && m_slots[slot] == iop;
+  }
+
+  std::size_t size() const noexcept { return m_size; }
+
+  bool empty() const noexcept { return m_size == 0u; }
+
+  // copy of the IO handlers, for iterating without holding the owning entity's lock
+  std::vector<io_ptr> snapshot() const {
+    std::vector<io_ptr> iohs;
+    iohs.reserve(m_size);
+    for (const auto& p : m_slots) {
+      if (p) {
+        iohs.push_back(p);
+      }
+    }
+    return iohs;
+  }
+};
+
+} // end detail namespace
+} // end net namespace
+} // end chops namespace
+
+#endif
+
@@ -0,0 +1,147 @@
+/** @file
+ *
+ *  @ingroup net_ip_module
+ *
+ *  @brief Delimiter search functions, with SSE2 and AVX2 implementations selected
+ *  at runtime and a scalar fallback.
+ *
+ *  The vectorized searches compare a block of bytes against both the first and last
+ *  byte of the delimiter at once, and only the (rare) candidates that match both are
+ *  compared byte by byte. A single byte delimiter (e.g. LF) needs no candidate
+ *  verification at all.
+ *
+ *  The vectorized implementations are only compiled for x86 with GCC or Clang, and
+ *  can be disabled by defining @c CHOPS_NET_NO_SIMD.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef DELIMITER_SEARCH_HPP_INCLUDED
+#define DELIMITER_SEARCH_HPP_INCLUDED
+
+#include <cstddef> // std::size_t, std::byte
+#include <cstring> // std::memchr, std::memcmp
+
+#if !defined(CHOPS_NET_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define CHOPS_NET_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace chops {
+namespace net {
+namespace detail {
+
+/**
+ *  @brief Signature of the delimiter search functions.
+ *
+ *  @param beg Beginning of the bytes to search.
+ *
+ *  @param end End of the bytes to search.
+ *
+ *  @param delim Pointer to the delimiter bytes.
+ *
+ *  @param delim_sz Size of the delimiter, which must be greater than zero.
+ *
+ *  @return Pointer to the first byte of the first complete delimiter found, or @c end
+ *  if there isn't one.
+ */
+using delim_search_func = const std::byte* (*)(const std::byte* beg, const std::byte* end,
+                                               const std::byte* delim, std::size_t delim_sz);
+
+inline const std::byte* delim_search_scalar(const std::byte* beg, const std::byte* end,
+                                            const std::byte* delim, std::size_t delim_sz) {
+  while (static_cast<std::size_t>(end - beg) >= delim_sz) {
+    auto p = static_cast<const std::byte*>(std::memchr(beg, std::to_integer<int>(*delim),
+                                           end - beg - delim_sz + 1u));
+    if (p == nullptr) {
+      break;
+    }
+    if (std::memcmp(p + 1, delim + 1, delim_sz - 1u) == 0) {
+      return p;
+    }
+    beg = p + 1;
+  }
+  return end;
+}
+
+#ifdef CHOPS_NET_X86_SIMD
+
+// mask bits are candidates matching both the first and last delimiter byte
+template <typename M>
+const std::byte* verify_candidates(M mask, const std::byte* p,
+                                   const std::byte* delim, std::size_t delim_sz) {
+  while (mask != 0u) {
+    auto i = __builtin_ctz(mask);
+    if (delim_sz <= 2u || std::memcmp(p + i + 1, delim + 1, delim_sz - 2u) == 0) {
+      return p + i;
+    }
+    mask &= mask - 1u;
+  }
+  return nullptr;
+}
+
+inline const std::byte* delim_search_sse2(const std::byte* beg, const std::byte* end,
+                                          const std::byte* delim, std::size_t delim_sz) {
+  const __m128i first = _mm_set1_epi8(std::to_integer<char>(*delim));
+  const __m128i last = _mm_set1_epi8(std::to_integer<char>(*(delim + delim_sz - 1u)));
+  for (; static_cast<std::size_t>(end - beg) >= 16u + delim_sz - 1u; beg += 16) {
+    __m128i blk_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(beg));
+    __m128i blk_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(beg + delim_sz - 1u));
+    auto mask = static_cast<unsigned>(_mm_movemask_epi8(
+                      _mm_and_si128(_mm_cmpeq_epi8(blk_first, first),
+                                    _mm_cmpeq_epi8(blk_last, last))));
+    if (auto p = verify_candidates(mask, beg, delim, delim_sz)) {
+      return p;
+    }
+  }
+  return delim_search_scalar(beg, end, delim, delim_sz);
+}
+
+__attribute__((target("avx2")))
+inline const std::byte* delim_search_avx2(const std::byte* beg, const std::byte* end,
+                                          const std::byte* delim, std::size_t delim_sz) {
+  const __m256i first = _mm256_set1_epi8(std::to_integer<char>(*delim));
+  const __m256i last = _mm256_set1_epi8(std::to_integer<char>(*(delim + delim_sz - 1u)));
+  for (; static_cast<std::size_t>(end - beg) >= 32u + delim_sz - 1u; beg += 32) {
+    __m256i blk_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(beg));
+    __m256i blk_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(beg + delim_sz - 1u));
+    auto mask = static_cast<unsigned>(_mm256_movemask_epi8(
+                      _mm256_and_si256(_mm256_cmpeq_epi8(blk_first, first),
+                                       _mm256_cmpeq_epi8(blk_last, last))));
+    if (auto p = verify_candidates(mask, beg, delim, delim_sz)) {
+      return p;
+    }
+  }
+  return delim_search_sse2(beg, end, delim, delim_sz);
+}
+
+#endif
+
+/**
+ *  @brief Return the fastest delimiter search function supported by the CPU.
+ *
+ *  The CPU check is performed once, on first call.
+ */
+inline delim_search_func select_delim_search() noexcept {
+#ifdef CHOPS_NET_X86_SIMD
+  static const delim_search_func func =
+      __builtin_cpu_supports("avx2") ? delim_search_avx2 : delim_search_sse2;
+  return func;
+#else
+  return delim_search_scalar;
+#endif
+}
+
+} // end detail namespace
+} // end net namespace
+} // end chops namespace
+
+#endif
+
@@ -0,0 +1,98 @@
+/** @file
+ *
+ *  @ingroup net_ip_module
+ *
+ *  @brief A statically dispatched notification callback from an IO handler to the
+ *  net entity that owns it.
+ *
+ *  An IO handler (e.g. @c tcp_io) notifies its owning net entity (e.g. @c tcp_acceptor)
+ *  when it shuts down or has an error. Binding the entity's member function in a
+ *  @c std::function (through @c std::bind) requires a heap allocation for every IO
+ *  handler, plus an indirect call through the type erasure. Instead the member function
+ *  is a template parameter, so the notifier is a pointer to the entity plus a plain
+ *  function pointer to a thunk that calls the member function directly.
+ *
+ *  @note For internal use only.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef ENTITY_NOTIFIER_HPP_INCLUDED
+#define ENTITY_NOTIFIER_HPP_INCLUDED
+
+#include <memory> // std::shared_ptr, std::make_shared
+#include <system_error>
+#include <utility> // std::forward, std::move
+#include <type_traits> // std::decay_t, std::enable_if_t, std::is_same_v
+
+namespace chops {
+namespace net {
+namespace detail {
+
+template <typename IOT>
+class entity_notifier {
+private:
+  using thunk_type = void (*)(void*, const std::error_code&, const std::shared_ptr<IOT>&);
+
+  std::shared_ptr<void>  m_target; // keeps the entity (or callable) alive
+  thunk_type             m_thunk;
+
+  entity_notifier(std::shared_ptr<void> target, thunk_type thunk) noexcept :
+    m_target(std::move(target)), m_thunk(thunk) { }
+
+  template <auto MF, typename E>
+  static void call_member(void* p, const std::error_code& err, const std::shared_ptr<IOT>& iop) {
+    (static_cast<E*>(p)->*MF)(err, iop);
+  }
+
+  template <typename F>
+  static void call_func(void* p, const std::error_code& err, const std::shared_ptr<IOT>& iop) {
+    (*static_cast<F*>(p))(err, iop);
+  }
+
+public:
+
+  entity_notifier() noexcept : m_target(), m_thunk(nullptr) { }
+
+/**
+ *  @brief Construct from an arbitrary callable, which is moved into shared storage
+ *  once, primarily for testing IO handlers without a net entity.
+ */
+  template <typename F,
+            typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, entity_notifier>>>
+  entity_notifier(F&& func) :
+    m_target(std::make_shared<std::decay_t<F>>(std::forward<F>(func))),
+    m_thunk(&call_func<std::decay_t<F>>) { }
+
+/**
+ *  @brief Bind a member function of a net entity, without any allocation.
+ *
+ *  @tparam MF Pointer to member function, taking a @c std::error_code and a
+ *  @c std::shared_ptr to the IO handler; it can be private to the entity.
+ *
+ *  @param ent Entity, kept alive by the notifier.
+ */
+  template <auto MF, typename E>
+  static entity_notifier bind(std::shared_ptr<E> ent) noexcept {
+    return entity_notifier(std::shared_ptr<void>(std::move(ent)), &call_member<MF, E>);
+  }
+
+  void operator()(const std::error_code& err, const std::shared_ptr<IOT>& iop) const {
+    m_thunk(m_target.get(), err, iop);
+  }
+
+  explicit operator bool() const noexcept { return m_thunk != nullptr; }
+};
+
+} // end detail namespace
+} // end net namespace
+} // end chops namespace
+
+#endif
+
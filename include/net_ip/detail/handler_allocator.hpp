@@ -0,0 +1,161 @@
+/** @file
+ *
+ *  @ingroup net_ip_module
+ *
+ *  @brief Recycling handler memory and an associated allocator for the asynchronous
+ *  operations of an IO handler.
+ *
+ *  Every asynchronous operation (read, write, post) allocates storage for its handler,
+ *  and the handlers capture a @c std::shared_ptr and (for reads) the application's
+ *  message handler. Each IO handler has a small number of outstanding operations at
+ *  any time, so a few fixed size slots owned by the IO handler are recycled for every
+ *  operation, falling back to the heap when all slots are in use or a handler is too
+ *  large. This is the custom allocation technique from the @c asio allocation example,
+ *  with atomic slot flags since a post can be made from any thread.
+ *
+ *  @note For internal use only.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef HANDLER_ALLOCATOR_HPP_INCLUDED
+#define HANDLER_ALLOCATOR_HPP_INCLUDED
+
+#include <cstddef> // std::size_t, std::max_align_t
+#include <atomic>
+#include <array>
+#include <new> // operator new, operator delete
+#include <utility> // std::forward, std::move
+#include <type_traits> // std::decay_t, std::aligned_storage_t
+
+#include "asio/io_context.hpp"
+#include "asio/post.hpp"
+
+namespace chops {
+namespace net {
+namespace detail {
+
+class handler_memory {
+public:
+  static constexpr std::size_t num_slots = 4u;
+  static constexpr std::size_t slot_size = 512u;
+
+private:
+  struct slot {
+    std::aligned_storage_t<slot_size, alignof(std::max_align_t)> m_storage;
+    std::atomic_bool                                             m_in_use { false };
+  };
+
+  std::array<slot, num_slots>  m_slots;
+  std::atomic_size_t           m_heap_allocs;
+
+public:
+  handler_memory() noexcept : m_slots(), m_heap_allocs(0u) { }
+
+  handler_memory(const handler_memory&) = delete;
+  handler_memory& operator=(const handler_memory&) = delete;
+
+  // can be called from any thread
+  void* allocate(std::size_t sz) {
+    if (sz <= slot_size) {
+      for (auto& s : m_slots) {
+        if (!s.m_in_use.load(std::memory_order_relaxed) &&
+            !s.m_in_use.exchange(true, std::memory_order_acquire)) {
+          return &s.m_storage;
+        }
+      }
+    }
+    m_heap_allocs.fetch_add(1u, std::memory_order_relaxed);
+    return ::operator new(sz);
+  }
+
+  void deallocate(void* p) noexcept {
+    for (auto& s : m_slots) {
+      if (p == &s.m_storage) {
+        s.m_in_use.store(false, std::memory_order_release);
+        return;
+      }
+    }
+    ::operator delete(p);
+  }
+
+  // number of allocations that did not fit in a slot
+  std::size_t heap_allocs() const noexcept { return m_heap_allocs.load(std::memory_order_relaxed); }
+};
+
+template <typename T>
+class handler_allocator {
+private:
+  template <typename> friend class handler_allocator;
+
+  handler_memory&  m_memory;
+
+public:
+  using value_type = T;
+
+  explicit handler_allocator(handler_memory& mem) noexcept : m_memory(mem) { }
+
+  template <typename U>
+  handler_allocator(const handler_allocator<U>& other) noexcept : m_memory(other.m_memory) { }
+
+  T* allocate(std::size_t n) const {
+    return static_cast<T*>(m_memory.allocate(sizeof(T) * n));
+  }
+
+  void deallocate(T* p, std::size_t /* n */) const noexcept {
+    m_memory.deallocate(p);
+  }
+
+  bool operator==(const handler_allocator& rhs) const noexcept { return &m_memory == &rhs.m_memory; }
+  bool operator!=(const handler_allocator& rhs) const noexcept { return &m_memory != &rhs.m_memory; }
+};
+
+// wraps a completion handler so that asio uses the handler memory for the operation
+template <typename Handler>
+class custom_alloc_handler {
+private:
+  handler_memory&  m_memory;
+  Handler          m_handler;
+
+public:
+  using allocator_type = handler_allocator<Handler>;
+
+  custom_alloc_handler(handler_memory& mem, Handler&& h) :
+    m_memory(mem), m_handler(std::move(h)) { }
+
+  allocator_type get_allocator() const noexcept { return allocator_type(m_memory); }
+
+  template <typename... Args>
+  void operator()(Args&&... args) {
+    m_handler(std::forward<Args>(args)...);
+  }
+};
+
+template <typename Handler>
+custom_alloc_handler<std::decay_t<Handler>> make_custom_alloc_handler(handler_memory& mem, Handler&& h) {
+  return custom_alloc_handler<std::decay_t<Handler>>(mem, std::forward<Handler>(h));
+}
+
+// a post through a type erased executor ignores the handler allocator, so the post is
+// made through the io_context executor when that is what the executor wraps
+template <typename Executor, typename Handler>
+void post_custom_alloc_handler(const Executor& ex, handler_memory& mem, Handler&& h) {
+  if (auto ioc_ex = ex.template target<asio::io_context::executor_type>()) {
+    asio::post(*ioc_ex, make_custom_alloc_handler(mem, std::forward<Handler>(h)));
+    return;
+  }
+  asio::post(ex, make_custom_alloc_handler(mem, std::forward<Handler>(h)));
+}
+
+} // end detail namespace
+} // end net namespace
+} // end chops namespace
+
+#endif
+
@@ -19,12 +19,18 @@
 #define IO_COMMON_HPP_INCLUDED
 
 #include <atomic>
+#include <mutex>
 #include <system_error>
 #include <functional> // std::function, used for type erased notifications to net_entity objects
 #include <memory> // std::shared_ptr
+#include <vector>
+#include <cstddef> // std::size_t
+#include <utility> // std::move
+#include <algorithm> // std::min
 
 #include "net_ip/detail/output_queue.hpp"
 #include "net_ip/queue_stats.hpp"
+#include "net_ip/net_ip_error.hpp"
 #include "marshall/shared_buffer.hpp"
 
 namespace chops {
@@ -38,23 +44,97 @@ private:
 
 public:
   using outq_type = output_queue<typename IOT::endpoint_type>;
+  using outq_el = typename outq_type::queue_element;
   using outq_opt_el = typename outq_type::opt_queue_element;
   using queue_stats = chops::net::output_queue_stats;
+  using buf_vec = std::vector<chops::const_shared_buffer>;
 
 private:
 
-  std::atomic_bool     m_io_started; // may be called from multiple threads concurrently
-  bool                 m_write_in_progress; // internal only, doesn't need to be atomic
-  outq_type            m_outq;
+  // sends from application threads are pushed onto an intrusive lock-free stack,
+  // which the run thread takes all at once (so there is no ABA problem) and 
+  // reverses to restore send order
+  using time_point = typename outq_type::time_point;
+
+  struct send_node {
+    outq_el     m_elem;
+    time_point  m_send_time;
+    std::size_t m_priority;
+    send_node*  m_next;
+  };
+
+  std::atomic_bool        m_io_started; // may be called from multiple threads concurrently
+  bool                    m_write_in_progress; // internal only, doesn't need to be atomic
+  bool                    m_outq_overflow; // internal only, set when the close policy applies
+  outq_type               m_outq;
+  std::atomic<send_node*> m_send_head;
+  std::atomic_size_t      m_pending_bufs;
+  std::atomic_size_t      m_pending_bytes;
+
+  // drained send nodes are recycled through a small free list; the list is only
+  // try-locked, so a contended send (or drain) falls back to new (or delete)
+  static constexpr std::size_t max_free_send_nodes = 16u;
+
+  std::mutex              m_free_mutex;
+  send_node*              m_free_nodes;
+  std::size_t             m_num_free_nodes;
 
 public:
 
+  // result of a send push, a drain must be posted when the pending sends become 
+  // non-empty
+  enum class push_result { rejected, pending, post_drain };
+
   explicit io_common() noexcept :
-    m_io_started(false), m_write_in_progress(false), m_outq() { }
+    m_io_started(false), m_write_in_progress(false), m_outq_overflow(false), m_outq(), 
+    m_send_head(nullptr), m_pending_bufs(0), m_pending_bytes(0),
+    m_free_mutex(), m_free_nodes(nullptr), m_num_free_nodes(0u) { }
+
+  ~io_common() {
+    delete_send_nodes(m_send_head.exchange(nullptr));
+    delete_send_nodes(m_free_nodes);
+  }
+
+  io_common(const io_common&) = delete;
+  io_common& operator=(const io_common&) = delete;
+
+  void set_output_queue_limits(const chops::net::output_queue_limits& lim) noexcept {
+    m_outq.set_limits(lim);
+  }
+
+  // the output queue is only accessed within the run thread once IO has started
+  bool set_output_queue_key_func(chops::net::output_queue_key_func key_func) {
+    if (m_io_started) {
+      return false;
+    }
+    m_outq.set_key_func(std::move(key_func));
+    return true;
+  }
+
+  // the push methods can be called concurrently from any thread; a post_drain return
+  // means the pending sends went from empty to non-empty, and the caller must post 
+  // a call to drain_sends to the run thread
+  push_result push_send(chops::const_shared_buffer buf, std::size_t priority = 0u) {
+    if (reject_send(buf.size())) {
+      return push_result::rejected;
+    }
+    return push_send_node(make_send_node(outq_el(std::move(buf), std::nullopt), priority));
+  }
+
+  push_result push_send(chops::const_shared_buffer buf, const endp_type& endp) {
+    if (reject_send(buf.size())) {
+      return push_result::rejected;
+    }
+    return push_send_node(make_send_node(outq_el(std::move(buf), endp), 0u));
+  }
 
-  // the following four methods can be called concurrently
+  // the following six methods can be called concurrently
   queue_stats get_output_queue_stats() const noexcept { return m_outq.get_queue_stats(); }
 
+  std::size_t output_queue_size() const noexcept { return m_outq.queue_size(); }
+
+  std::size_t bytes_in_output_queue() const noexcept { return m_outq.num_bytes(); }
+
   bool is_io_started() const noexcept { return m_io_started; }
 
   bool set_io_started() noexcept {
@@ -75,6 +155,94 @@ public:
 
   outq_opt_el get_next_element();
 
+  std::size_t get_next_elements(buf_vec&, std::size_t, std::size_t);
+
+  std::size_t get_next_elements(std::vector<outq_el>&, std::size_t);
+
+  outq_opt_el drain_sends();
+
+  // called when a write completes, before the next element is requested
+  void write_completed() noexcept { m_outq.write_completed(); }
+
+  // an output queue overflow (close policy) or water mark crossing since the last call,
+  // to be delivered to the net entity
+  std::error_code output_queue_event() noexcept;
+
+private:
+
+  bool reject_send(std::size_t sz) noexcept {
+    if (m_outq.reject(m_pending_bufs + 1u, m_pending_bytes + sz)) {
+      m_outq.count_rejected();
+      return true;
+    }
+    return false;
+  }
+
+  send_node* make_send_node(outq_el&& e, std::size_t priority) {
+    send_node* node = nullptr;
+    if (m_free_mutex.try_lock()) {
+      node = m_free_nodes;
+      if (node) {
+        m_free_nodes = node->m_next;
+        --m_num_free_nodes;
+      }
+      m_free_mutex.unlock();
+    }
+    if (!node) {
+      return new send_node { std::move(e), outq_type::clock_type::now(), priority, nullptr };
+    }
+    node->m_elem = std::move(e);
+    node->m_send_time = outq_type::clock_type::now();
+    node->m_priority = priority;
+    node->m_next = nullptr;
+    return node;
+  }
+
+  // the element of the node must already be moved from, releasing the buffer
+  void recycle_send_node(send_node* node) noexcept {
+    if (m_free_mutex.try_lock()) {
+      if (m_num_free_nodes < max_free_send_nodes) {
+        node->m_next = m_free_nodes;
+        m_free_nodes = node;
+        ++m_num_free_nodes;
+        node = nullptr;
+      }
+      m_free_mutex.unlock();
+    }
+    delete node;
+  }
+
+  push_result push_send_node(send_node* node) noexcept {
+    ++m_pending_bufs;
+    m_pending_bytes += node->m_elem.first.size();
+    // the node is owned by the run thread once published, so it is not touched after
+    // a successful exchange
+    auto old_head = m_send_head.load(std::memory_order_relaxed);
+    do {
+      node->m_next = old_head;
+    } while (!m_send_head.compare_exchange_weak(old_head, node,
+                                                std::memory_order_release,
+                                                std::memory_order_relaxed));
+    return old_head == nullptr ? push_result::post_drain : push_result::pending;
+  }
+
+  void add_element(outq_el&& e, time_point send_time, std::size_t priority = 0u) {
+    if (m_outq_overflow) {
+      return; // connection closing, drop the buf
+    }
+    if (m_outq.add_element(std::move(e), send_time, priority) == outq_type::add_result::overflow) {
+      m_outq_overflow = true;
+    }
+  }
+
+  static void delete_send_nodes(send_node* node) noexcept {
+    while (node) {
+      auto next = node->m_next;
+      delete node;
+      node = next;
+    }
+  }
+
 };
 
 template <typename IOT>
@@ -83,9 +251,10 @@ bool io_common<IOT>::start_write_setup(const chops::const_shared_buffer& buf) {
     return false; // shutdown happening or not io_started, don't start a write
   }
   if (m_write_in_progress) { // queue buffer
-    m_outq.add_element(buf);
+    add_element(outq_el(buf, std::nullopt), outq_type::clock_type::now());
     return false;
   }
+  m_outq.write_started(buf.size(), outq_type::clock_type::now());
   m_write_in_progress = true;
   return true;
 }
@@ -97,9 +266,10 @@ bool io_common<IOT>::start_write_setup(const chops::const_shared_buffer& buf,
     return false; // shutdown happening or not io_started, don't start a write
   }
   if (m_write_in_progress) { // queue buffer
-    m_outq.add_element(buf, endp);
+    add_element(outq_el(buf, endp), outq_type::clock_type::now());
     return false;
   }
+  m_outq.write_started(buf.size(), outq_type::clock_type::now());
   m_write_in_progress = true;
   return true;
 }
@@ -114,6 +284,98 @@ typename io_common<IOT>::outq_opt_el io_common<IOT>::get_next_element() {
   return elem;
 }
 
+template <typename IOT>
+std::size_t io_common<IOT>::get_next_elements(buf_vec& bufs, 
+                                              std::size_t max_bufs, std::size_t max_bytes) {
+  if (!m_io_started) { // shutting down
+    return 0;
+  }
+  auto cnt = m_outq.get_next_elements(bufs, max_bufs, max_bytes);
+  m_write_in_progress = (cnt != 0);
+  return cnt;
+}
+
+template <typename IOT>
+std::size_t io_common<IOT>::get_next_elements(std::vector<outq_el>& elems, std::size_t max_elems) {
+  if (!m_io_started) { // shutting down
+    return 0;
+  }
+  auto cnt = m_outq.get_next_elements(elems, max_elems);
+  m_write_in_progress = (cnt != 0);
+  return cnt;
+}
+
+// all pending sends are moved to the output queue in one pass; if no write is in 
+// progress the one in the highest priority lane (the oldest, if more than one) is 
+// returned to be written instead
+template <typename IOT>
+typename io_common<IOT>::outq_opt_el io_common<IOT>::drain_sends() {
+  send_node* node = m_send_head.exchange(nullptr, std::memory_order_acquire);
+  send_node* prev = nullptr;
+  std::size_t num_bufs = 0u;
+  std::size_t num_bytes = 0u;
+  while (node) { // reverse into send order
+    ++num_bufs;
+    num_bytes += node->m_elem.first.size();
+    auto next = node->m_next;
+    node->m_next = prev;
+    prev = node;
+    node = next;
+  }
+  m_pending_bufs -= num_bufs;
+  m_pending_bytes -= num_bytes;
+  if (!m_io_started) { // shutdown happening or not io_started, drop the bufs
+    delete_send_nodes(prev);
+    return outq_opt_el { };
+  }
+  // the output queue is empty when no write is in progress, so this is the element 
+  // get_next_element would return if every drained buf was queued first; the drained
+  // bufs are not queued first, since that would count the written buf against the 
+  // output queue limits
+  send_node* first_node = nullptr;
+  if (!m_write_in_progress) {
+    std::size_t top = 0u;
+    for (node = prev; node; node = node->m_next) {
+      auto lane = std::min(node->m_priority, num_send_priorities - 1u);
+      if (!first_node || lane > top) {
+        first_node = node;
+        top = lane;
+      }
+    }
+  }
+  outq_opt_el first { };
+  for (node = prev; node; node = prev) {
+    prev = node->m_next;
+    if (node == first_node) {
+      m_write_in_progress = true;
+      m_outq.write_started(node->m_elem.first.size(), node->m_send_time);
+      first.emplace(std::move(node->m_elem));
+    }
+    else {
+      add_element(std::move(node->m_elem), node->m_send_time, node->m_priority);
+    }
+    recycle_send_node(node);
+  }
+  return first;
+}
+
+template <typename IOT>
+std::error_code io_common<IOT>::output_queue_event() noexcept {
+  if (m_outq_overflow) {
+    m_outq_overflow = false;
+    return std::make_error_code(net_ip_errc::output_queue_overflow);
+  }
+  switch (m_outq.water_mark_check()) {
+  case outq_type::water_mark_chg::high:
+    return std::make_error_code(net_ip_errc::output_queue_high_water_mark);
+  case outq_type::water_mark_chg::low:
+    return std::make_error_code(net_ip_errc::output_queue_low_water_mark);
+  default:
+    break;
+  }
+  return std::error_code();
+}
+
 } // end detail namespace
 } // end net namespace
 } // end chops namespace
@@ -22,7 +22,7 @@
 #include <atomic>
 #include <system_error>
 #include <functional> // std::function, for io state change and error callbacks
-#include <utility> // std::move
+#include <utility> // std::forward
 #include <memory>
 #include <cstddef> // std::size_t
 
@@ -32,6 +32,9 @@ namespace chops {
 namespace net {
 namespace detail {
 
+// the application callbacks are supplied at start rather than at entity construction,
+// so they are type-erased; each call constructs a basic_io_interface from the IO handler
+// shared_ptr, which is one weak count increment and decrement per notification
 template <typename IOT>
 class net_entity_common {
 public:
@@ -56,8 +59,8 @@ public:
   bool start(F1&& io_state_chg_func, F2&& err_func) {
     bool expected = false;
     if (m_started.compare_exchange_strong(expected, true)) {
-      m_io_state_chg_cb = io_state_chg_func;
-      m_error_cb = err_func;
+      m_io_state_chg_cb = std::forward<F1>(io_state_chg_func);
+      m_error_cb = std::forward<F2>(err_func);
       return true;
     }
     return false;
@@ -68,11 +71,11 @@ public:
     return m_started.compare_exchange_strong(expected, false); 
   }
 
-  void call_io_state_chg_cb(std::shared_ptr<IOT> p, std::size_t sz, bool starting) {
+  void call_io_state_chg_cb(const std::shared_ptr<IOT>& p, std::size_t sz, bool starting) {
     m_io_state_chg_cb(basic_io_interface<IOT>(p), sz, starting);
   }
 
-  void call_error_cb(std::shared_ptr<IOT> p, const std::error_code& err) {
+  void call_error_cb(const std::shared_ptr<IOT>& p, const std::error_code& err) {
     m_error_cb(basic_io_interface<IOT>(p), err);
   }
 
@@ -4,6 +4,9 @@
  *
  *  @brief Utility class to manage output data queueing.
  *
+ *  The queue has a fixed number of priority lanes, each a FIFO, and elements are
+ *  always taken from the highest priority non-empty lane.
+ *
  *  The @c std::atomic counters allow the IO handler to update
  *  while the application queries the stats.
  *
@@ -21,11 +24,16 @@
 #ifndef OUTPUT_QUEUE_HPP_INCLUDED
 #define OUTPUT_QUEUE_HPP_INCLUDED
 
-#include <queue>
+#include <deque>
+#include <vector>
+#include <unordered_map>
 #include <atomic>
 #include <cstddef> // std::size_t
-#include <utility> // std::pair
+#include <utility> // std::pair, std::move
 #include <optional>
+#include <array>
+#include <chrono>
+#include <cstdint> // std::uint64_t
 
 #include "net_ip/queue_stats.hpp"
 #include "marshall/shared_buffer.hpp"
@@ -39,58 +47,387 @@ class output_queue {
 private:
 
   using opt_endpoint = std::optional<E>;
+
+public:
   using queue_element = std::pair<chops::const_shared_buffer, opt_endpoint>;
+  using clock_type = std::chrono::steady_clock;
+  using time_point = clock_type::time_point;
 
 private:
+  using dwell_histogram = chops::net::queue_dwell_histogram;
+
+  struct stamped_element {
+    queue_element m_elem;
+    time_point    m_enq_time;
+    std::size_t   m_key;
+  };
+
+  // conflation is per lane, each queued element has a sequence number, the index of
+  // the front element is m_front_seq, and the key map refers to the sequence number 
+  // of the queued element for each key; the lane sizes are only modified within the
+  // run thread
+  struct lane {
+    std::deque<stamped_element>                  m_elems;
+    std::unordered_map<std::size_t, std::size_t> m_key_seqs;
+    std::size_t                                  m_front_seq = 0u;
+    std::atomic_size_t                           m_queue_size { 0u };
+    std::atomic_size_t                           m_num_bytes { 0u };
+  };
 
-  std::queue<queue_element> m_output_queue;
-  std::atomic_size_t        m_queue_size;
+  std::array<lane, chops::net::num_send_priorities> m_lanes;
+  std::atomic_size_t        m_queue_size; // totals across all lanes
   std::atomic_size_t        m_current_num_bytes;
-  // std::size_t               m_total_bufs_sent;
-  // std::size_t               m_total_bytes_sent;
+  std::atomic_size_t        m_bufs_dropped;
+
+  // the cumulative counters and histogram are only modified within the run thread, 
+  // so relaxed loads and stores are sufficient (no read-modify-write needed)
+  std::atomic_size_t        m_total_bufs_sent;
+  std::atomic_size_t        m_total_bytes_sent;
+  std::atomic_size_t        m_peak_queue_size;
+  std::array<std::atomic_size_t, dwell_histogram::num_buckets> m_dwell_counts;
+
+  // bufs handed to the socket whose write has not yet completed, only used within the
+  // run thread; the cumulative counters and histogram are updated on write completion
+  struct in_flight_write {
+    std::size_t   m_num_bytes;
+    time_point    m_send_time;
+  };
+  std::vector<in_flight_write> m_in_flight;
+
+  // limits can be set from any thread, and are read by sending threads for the 
+  // reject policy; the water mark state is only used within the run thread
+  std::atomic_size_t                         m_max_bufs;
+  std::atomic_size_t                         m_max_bytes;
+  std::atomic<chops::net::queue_overflow_policy> m_policy;
+  std::atomic_size_t                         m_high_water_mark;
+  std::atomic_size_t                         m_low_water_mark;
+  bool                                       m_above_high_water;
+
+  // conflation key function, only used within the run thread
+  chops::net::output_queue_key_func          m_key_func;
 
 public:
   using opt_queue_element = std::optional<queue_element>;
 
+  // result of adding an element, checked against the limits
+  enum class add_result { queued, conflated, dropped, overflow };
+  // water mark crossing since the last check
+  enum class water_mark_chg { none, high, low };
+
 public:
 
-  output_queue() noexcept : m_output_queue(), m_queue_size(0), m_current_num_bytes(0) { }
+  output_queue() noexcept : m_lanes(), m_queue_size(0), m_current_num_bytes(0),
+    m_bufs_dropped(0), m_total_bufs_sent(0), m_total_bytes_sent(0), m_peak_queue_size(0),
+    m_in_flight(),
+    m_max_bufs(0), m_max_bytes(0), 
+    m_policy(chops::net::queue_overflow_policy::reject),
+    m_high_water_mark(0), m_low_water_mark(0), m_above_high_water(false),
+    m_key_func() {
+    for (auto& c : m_dwell_counts) {
+      c.store(0u, std::memory_order_relaxed);
+    }
+  }
+
+  void set_limits(const chops::net::output_queue_limits& lim) noexcept {
+    m_max_bufs = lim.max_bufs;
+    m_max_bytes = lim.max_bytes;
+    m_policy = lim.policy;
+    m_high_water_mark = lim.high_water_mark;
+    m_low_water_mark = lim.low_water_mark;
+  }
+
+  // must be called before any elements are added (e.g. before start_io); an empty
+  // function object disables conflation
+  void set_key_func(chops::net::output_queue_key_func key_func) {
+    m_key_func = std::move(key_func);
+    for (auto& ln : m_lanes) {
+      ln.m_key_seqs.clear();
+    }
+  }
+
+  // can be called from any thread; pending bufs and bytes are those sent but not yet
+  // in the queue
+  bool reject(std::size_t pending_bufs, std::size_t pending_bytes) const noexcept {
+    return m_policy == chops::net::queue_overflow_policy::reject &&
+           !fits(m_queue_size + pending_bufs, m_current_num_bytes + pending_bytes);
+  }
+
+  void count_rejected() noexcept { ++m_bufs_dropped; }
+
+  water_mark_chg water_mark_check() noexcept {
+    std::size_t high = m_high_water_mark;
+    if (high == 0u) {
+      return water_mark_chg::none;
+    }
+    if (!m_above_high_water && m_current_num_bytes >= high) {
+      m_above_high_water = true;
+      return water_mark_chg::high;
+    }
+    if (m_above_high_water && m_current_num_bytes <= m_low_water_mark) {
+      m_above_high_water = false;
+      return water_mark_chg::low;
+    }
+    return water_mark_chg::none;
+  }
+
+  // io handlers call this method for a buf that is written without being queued, 
+  // the send time is when the application called send
+  void write_started(std::size_t num_bytes, time_point send_time) {
+    m_in_flight.push_back(in_flight_write { num_bytes, send_time });
+  }
+
+  // io handlers call this method when a write (single, gathered or batched) completes,
+  // recording every buf handed to the socket since the previous completion
+  void write_completed() noexcept {
+    auto now = clock_type::now();
+    for (const auto& w : m_in_flight) {
+      record_sent(w.m_num_bytes, w.m_send_time, now);
+    }
+    m_in_flight.clear();
+  }
 
   // io handlers call this method to get next buffer of data, can be empty
   opt_queue_element get_next_element() {
-    if (m_output_queue.empty()) {
+    auto* ln = next_lane();
+    if (!ln) {
       return opt_queue_element { };
     }
-    queue_element e = m_output_queue.front();
-    m_output_queue.pop();
+    auto& se = ln->m_elems.front();
+    write_started(se.m_elem.first.size(), se.m_enq_time);
+    queue_element e = std::move(se.m_elem);
+    pop_front(*ln, e.first.size());
     --m_queue_size;
     m_current_num_bytes -= e.first.size();
-    return opt_queue_element {e};
+    return opt_queue_element {std::move(e)};
+  }
+
+  // io handlers call this method to gather multiple buffers for a single write; at 
+  // least one buffer is appended (if available), then buffers are appended until 
+  // either limit is reached; a max_bytes of 0 means no byte limit; endpoints are not
+  // returned, so this is only useful for stream (TCP) output
+  std::size_t get_next_elements(std::vector<chops::const_shared_buffer>& bufs,
+                                std::size_t max_bufs, std::size_t max_bytes) {
+    std::size_t cnt = 0;
+    std::size_t num_bytes = 0;
+    lane* ln = nullptr;
+    while (cnt < max_bufs && (ln = next_lane())) {
+      auto& se = ln->m_elems.front();
+      auto& buf = se.m_elem.first;
+      auto sz = buf.size();
+      if (cnt != 0 && max_bytes != 0 && (num_bytes + sz) > max_bytes) {
+        break;
+      }
+      num_bytes += sz;
+      write_started(sz, se.m_enq_time);
+      bufs.push_back(std::move(buf));
+      pop_front(*ln, sz);
+      ++cnt;
+    }
+    m_queue_size -= cnt;
+    m_current_num_bytes -= num_bytes;
+    return cnt;
   }
 
-  void add_element(const chops::const_shared_buffer& buf) {
-    add_element(buf, opt_endpoint());
+  // io handlers call this method to gather multiple elements (with endpoints) for a
+  // batched datagram send
+  std::size_t get_next_elements(std::vector<queue_element>& elems, std::size_t max_elems) {
+    std::size_t cnt = 0;
+    std::size_t num_bytes = 0;
+    lane* ln = nullptr;
+    while (cnt < max_elems && (ln = next_lane())) {
+      auto& se = ln->m_elems.front();
+      auto sz = se.m_elem.first.size();
+      num_bytes += sz;
+      write_started(sz, se.m_enq_time);
+      elems.push_back(std::move(se.m_elem));
+      pop_front(*ln, sz);
+      ++cnt;
+    }
+    m_queue_size -= cnt;
+    m_current_num_bytes -= num_bytes;
+    return cnt;
+  }
+
+  add_result add_element(const chops::const_shared_buffer& buf) {
+    return add_element(buf, opt_endpoint(), clock_type::now(), 0u);
+  }
+
+  add_result add_element(const chops::const_shared_buffer& buf, const E& endp) {
+    return add_element(buf, opt_endpoint(endp), clock_type::now(), 0u);
   }
 
-  void add_element(const chops::const_shared_buffer& buf, const E& endp) {
-    add_element(buf, opt_endpoint(endp));
+  // a priority greater than the highest lane is placed in the highest lane
+  add_result add_element(queue_element&& e, time_point send_time, std::size_t priority = 0u) {
+    return add_element(e.first, std::move(e.second), send_time, priority);
   }
 
+  // cheap alternatives to get_queue_stats, which copies every histogram and lane counter
+  std::size_t queue_size() const noexcept { return m_queue_size; }
+
+  std::size_t num_bytes() const noexcept { return m_current_num_bytes; }
+
   chops::net::output_queue_stats get_queue_stats() const noexcept {
-    return chops::net::output_queue_stats { m_queue_size, m_current_num_bytes };
-    // return chops::net::output_queue_stats {
-    //   m_queue_size, m_current_num_bytes, m_total_bufs_sent, m_total_bytes_sent 
-    // };
+    chops::net::output_queue_stats qs { m_queue_size, m_current_num_bytes, 1u, 0u,
+                                        m_bufs_dropped, 
+                                        m_total_bufs_sent.load(std::memory_order_relaxed), 
+                                        m_total_bytes_sent.load(std::memory_order_relaxed),
+                                        m_peak_queue_size.load(std::memory_order_relaxed) };
+    for (std::size_t i = 0u; i < m_dwell_counts.size(); ++i) {
+      qs.dwell_time_ns.counts[i] = m_dwell_counts[i].load(std::memory_order_relaxed);
+    }
+    for (std::size_t i = 0u; i < m_lanes.size(); ++i) {
+      qs.lane_queue_size[i] = m_lanes[i].m_queue_size.load(std::memory_order_relaxed);
+      qs.lane_bytes_in_queue[i] = m_lanes[i].m_num_bytes.load(std::memory_order_relaxed);
+    }
+    return qs;
   }
 
 private:
 
-  void add_element(const chops::const_shared_buffer& buf, opt_endpoint&& opt_endp) {
-    m_output_queue.push(queue_element(buf, opt_endp));
-    ++m_queue_size;
+  // single writer, a load and store is cheaper than an atomic increment
+  static void relaxed_add(std::atomic_size_t& cnt, std::size_t val) noexcept {
+    cnt.store(cnt.load(std::memory_order_relaxed) + val, std::memory_order_relaxed);
+  }
+
+  void record_sent(std::size_t num_bytes, time_point send_time, time_point now) noexcept {
+    relaxed_add(m_total_bufs_sent, 1u);
+    relaxed_add(m_total_bytes_sent, num_bytes);
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - send_time).count();
+    relaxed_add(m_dwell_counts[dwell_histogram::bucket_index(ns < 0 ? 0u : 
+                                    static_cast<std::uint64_t>(ns))], 1u);
+  }
+
+  bool fits(std::size_t num_bufs, std::size_t num_bytes) const noexcept {
+    std::size_t max_bufs = m_max_bufs;
+    std::size_t max_bytes = m_max_bytes;
+    return (max_bufs == 0u || num_bufs <= max_bufs) && (max_bytes == 0u || num_bytes <= max_bytes);
+  }
+
+  static void relaxed_sub(std::atomic_size_t& cnt, std::size_t val) noexcept {
+    cnt.store(cnt.load(std::memory_order_relaxed) - val, std::memory_order_relaxed);
+  }
+
+  // highest priority lane with a queued element, if any
+  lane* next_lane() noexcept {
+    for (auto it = m_lanes.rbegin(); it != m_lanes.rend(); ++it) {
+      if (!it->m_elems.empty()) {
+        return &(*it);
+      }
+    }
+    return nullptr;
+  }
+
+  // lowest priority lane with a queued element, if any
+  lane* oldest_lane() noexcept {
+    for (auto& ln : m_lanes) {
+      if (!ln.m_elems.empty()) {
+        return &ln;
+      }
+    }
+    return nullptr;
+  }
+
+  // the caller updates the totals, the buf of the front element may have been moved
+  void pop_front(lane& ln, std::size_t num_bytes) {
+    if (m_key_func) {
+      auto it = ln.m_key_seqs.find(ln.m_elems.front().m_key);
+      if (it != ln.m_key_seqs.end() && it->second == ln.m_front_seq) {
+        ln.m_key_seqs.erase(it);
+      }
+    }
+    ln.m_elems.pop_front();
+    ++ln.m_front_seq;
+    relaxed_sub(ln.m_queue_size, 1u);
+    relaxed_sub(ln.m_num_bytes, num_bytes);
+  }
+
+  // the front element of the lane is dropped by an overflow policy
+  void drop_front(lane& ln) {
+    auto sz = ln.m_elems.front().m_elem.first.size();
+    --m_queue_size;
+    m_current_num_bytes -= sz;
+    pop_front(ln, sz);
+    ++m_bufs_dropped;
+  }
+
+  add_result add_element(const chops::const_shared_buffer& buf, opt_endpoint&& opt_endp,
+                         time_point send_time, std::size_t priority) {
+    auto& ln = m_lanes[priority < m_lanes.size() ? priority : m_lanes.size() - 1u];
+    std::size_t key = 0u;
+    if (m_key_func) {
+      key = m_key_func(buf);
+      auto it = ln.m_key_seqs.find(key);
+      if (it != ln.m_key_seqs.end()) {
+        std::size_t seq = it->second;
+        std::size_t old_sz = ln.m_elems[seq - ln.m_front_seq].m_elem.first.size();
+        auto replacement_fits = [this, old_sz, &buf] {
+          return fits(m_queue_size, m_current_num_bytes - old_sz + buf.size());
+        };
+        if (!replacement_fits()) { // a larger buf can exceed the byte limit
+          switch (m_policy.load()) {
+          case chops::net::queue_overflow_policy::drop_oldest:
+            // drop older elements until the replacement fits, unless the element being 
+            // replaced is the oldest, in which case it is dropped and the buf is added
+            // at the back of the lane
+            for (lane* old = oldest_lane(); !replacement_fits(); old = oldest_lane()) {
+              bool replaced_is_oldest = (old == &ln && ln.m_front_seq == seq);
+              drop_front(*old);
+              if (replaced_is_oldest) {
+                break;
+              }
+            }
+            it = ln.m_key_seqs.find(key);
+            break;
+          case chops::net::queue_overflow_policy::close:
+            return add_result::overflow;
+          default: // reject or drop_newest, the queued element is kept
+            ++m_bufs_dropped;
+            return add_result::dropped;
+          }
+        }
+        if (it != ln.m_key_seqs.end()) { // not dropped by the overflow policy
+          // replace the unsent element in place, keeping its position in the lane
+          auto& se = ln.m_elems[it->second - ln.m_front_seq];
+          m_current_num_bytes -= se.m_elem.first.size();
+          m_current_num_bytes += buf.size();
+          relaxed_sub(ln.m_num_bytes, se.m_elem.first.size());
+          relaxed_add(ln.m_num_bytes, buf.size());
+          se.m_elem = queue_element(buf, std::move(opt_endp));
+          se.m_enq_time = send_time;
+          ++m_bufs_dropped;
+          return add_result::conflated;
+        }
+      }
+    }
+    if (!fits(m_queue_size + 1u, m_current_num_bytes + buf.size())) {
+      switch (m_policy.load()) {
+      case chops::net::queue_overflow_policy::drop_oldest:
+        // lower priority lanes are dropped from first; a buf larger than the byte
+        // limit is still queued once the queue is empty
+        for (lane* old = oldest_lane(); old && 
+             !fits(m_queue_size + 1u, m_current_num_bytes + buf.size()); old = oldest_lane()) {
+          drop_front(*old);
+        }
+        break;
+      case chops::net::queue_overflow_policy::close:
+        return add_result::overflow;
+      default: // reject (approximate check by sending thread missed it) or drop_newest
+        ++m_bufs_dropped;
+        return add_result::dropped;
+      }
+    }
+    ln.m_elems.push_back(stamped_element { queue_element(buf, std::move(opt_endp)), send_time, key });
+    if (m_key_func) {
+      ln.m_key_seqs[key] = ln.m_front_seq + ln.m_elems.size() - 1u;
+    }
+    relaxed_add(ln.m_queue_size, 1u);
+    relaxed_add(ln.m_num_bytes, buf.size());
+    std::size_t sz = ++m_queue_size;
     m_current_num_bytes += buf.size(); // note - possible integer overflow
-    // ++m_total_bufs_sent;
-    // m_total_bytes_sent += buf.size();
+    if (sz > m_peak_queue_size.load(std::memory_order_relaxed)) {
+      m_peak_queue_size.store(sz, std::memory_order_relaxed);
+    }
+    return add_result::queued;
   }
 
 };
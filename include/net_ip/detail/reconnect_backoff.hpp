@@ -0,0 +1,90 @@
+/** @file
+ *
+ *  @ingroup net_ip_module
+ *
+ *  @brief Computes the reconnect intervals of a TCP connector from a
+ *  @c reconnect_policy.
+ *
+ *  @note For internal use only.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef RECONNECT_BACKOFF_HPP_INCLUDED
+#define RECONNECT_BACKOFF_HPP_INCLUDED
+
+#include <cstddef> // std::size_t
+#include <chrono>
+#include <optional>
+#include <random>
+#include <algorithm> // std::min, std::max
+
+#include "net_ip/reconnect_policy.hpp"
+
+namespace chops {
+namespace net {
+namespace detail {
+
+// not thread safe, the seed can be supplied for repeatable tests
+class reconnect_backoff {
+public:
+  using interval_type = std::chrono::milliseconds;
+
+private:
+  reconnect_policy  m_policy;
+  double            m_prev; // milliseconds
+  std::size_t       m_attempts;
+  std::mt19937      m_rng;
+
+public:
+  explicit reconnect_backoff(const reconnect_policy& policy) :
+    reconnect_backoff(policy, std::random_device{}()) { }
+
+  reconnect_backoff(const reconnect_policy& policy, unsigned int seed) :
+    m_policy(policy), m_prev(static_cast<double>(policy.initial_interval.count())), 
+    m_attempts(0u), m_rng(seed) { }
+
+  const reconnect_policy& get_policy() const noexcept { return m_policy; }
+
+  std::size_t attempts() const noexcept { return m_attempts; }
+
+  void reset() noexcept {
+    m_prev = static_cast<double>(m_policy.initial_interval.count());
+    m_attempts = 0u;
+  }
+
+  // interval to wait before the next reconnect attempt, empty if no reconnect is
+  // to be attempted
+  std::optional<interval_type> next_interval() {
+    if (m_policy.initial_interval <= interval_type::zero() ||
+        (m_policy.max_attempts != 0u && m_attempts >= m_policy.max_attempts)) {
+      return std::optional<interval_type> { };
+    }
+    auto base = static_cast<double>(m_policy.initial_interval.count());
+    auto cap = std::max(base, static_cast<double>(m_policy.max_interval.count()));
+    auto hi = std::min(cap, m_prev * std::max(m_policy.multiplier, 1.0));
+    double nxt = base;
+    if (m_policy.jitter) {
+      nxt = std::uniform_real_distribution<double>(base, hi)(m_rng);
+    }
+    else if (m_attempts != 0u) {
+      nxt = hi;
+    }
+    ++m_attempts;
+    m_prev = nxt;
+    return std::optional<interval_type> { interval_type(static_cast<interval_type::rep>(nxt)) };
+  }
+};
+
+} // end detail namespace
+} // end net namespace
+} // end chops namespace
+
+#endif
+
@@ -20,43 +20,91 @@
 
 #include "asio/ip/tcp.hpp"
 #include "asio/io_context.hpp"
+#include "asio/post.hpp"
+#include "asio/steady_timer.hpp"
+#include "asio/socket_base.hpp"
+#include "asio/detail/socket_option.hpp"
 
 #include <system_error>
 #include <memory>
 #include <vector>
-#include <utility> // std::move, std::forward
+#include <utility> // std::move, std::forward, std::exchange
 #include <cstddef> // for std::size_t
-#include <functional> // std::bind
+#include <mutex>
+#include <atomic>
 
 #include "net_ip/detail/tcp_io.hpp"
 #include "net_ip/detail/net_entity_common.hpp"
+#include "net_ip/detail/connection_registry.hpp"
+#include "net_ip/detail/token_bucket.hpp"
 
 #include "net_ip/io_interface.hpp"
-
-#include "utility/erase_where.hpp"
+#include "net_ip/io_context_distributor.hpp"
+#include "net_ip/accept_limits.hpp"
 
 namespace chops {
 namespace net {
 namespace detail {
 
+#if defined(SO_REUSEPORT)
+using reuse_port_option = asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+
 class tcp_acceptor : public std::enable_shared_from_this<tcp_acceptor> {
 public:
   using socket_type = asio::ip::tcp::acceptor;
   using endpoint_type = asio::ip::tcp::endpoint;
 
 private:
-  net_entity_common<tcp_io>  m_entity_common;
-  asio::io_context&          m_io_context;
-  socket_type                m_acceptor;
-  std::vector<tcp_io_ptr>    m_io_handlers;
-  endpoint_type              m_acceptor_endp;
-  bool                       m_reuse_addr;
+  net_entity_common<tcp_io>    m_entity_common;
+  asio::io_context&            m_io_context;
+  socket_type                  m_acceptor;
+  // accepted connections may run in other io_contexts (see io_context_distributor),
+  // notifying from their own threads
+  std::mutex                   m_mutex;
+  connection_registry<tcp_io>  m_io_handlers;
+  endpoint_type                m_acceptor_endp;
+  bool                         m_reuse_addr;
+  bool                         m_reuse_port;
+  io_context_distributor       m_distributor;
+
+  // admission control; the limits are set before start, and the token bucket and 
+  // timer are only used in the acceptor's io_context
+  accept_limits                m_accept_limits;
+  token_bucket                 m_accept_tokens;
+  asio::steady_timer           m_accept_timer;
+  bool                         m_paused_at_max; // protected by m_mutex
+  // accepted connections posted to another io_context but not yet added to the
+  // registry, counted against the connection limit; protected by m_mutex
+  std::size_t                  m_pending_handoffs;
+  std::atomic_size_t           m_total_accepted;
+  std::atomic_size_t           m_limit_pauses;
+  std::atomic_size_t           m_rate_pauses;
+  std::atomic_size_t           m_limit_rejects;
+  std::atomic_size_t           m_rate_rejects;
+  std::atomic_size_t           m_accept_wakeups;
+
+  // greater than 1 enables batch accepts, set before start
+  std::size_t                  m_accept_batch_size;
 
 public:
+  // reuse port allows multiple acceptors (typically each in a different io_context)
+  // to listen on the same endpoint, with the kernel distributing incoming connections
+  tcp_acceptor(asio::io_context& ioc, const endpoint_type& endp,
+               bool reuse_addr, bool reuse_port = false) :
+    m_entity_common(), m_io_context(ioc), m_acceptor(ioc), m_mutex(), m_io_handlers(), 
+    m_acceptor_endp(endp), m_reuse_addr(reuse_addr), m_reuse_port(reuse_port), 
+    m_distributor(), m_accept_limits(), m_accept_tokens(), m_accept_timer(ioc),
+    m_paused_at_max(false), m_pending_handoffs(0u), m_total_accepted(0u), m_limit_pauses(0u), m_rate_pauses(0u),
+    m_limit_rejects(0u), m_rate_rejects(0u), m_accept_wakeups(0u), m_accept_batch_size(1u) { }
+
+  // each accepted connection is associated with the io_context acquired from the
+  // distributor, and the io state change callback is invoked in that io_context
   tcp_acceptor(asio::io_context& ioc, const endpoint_type& endp,
-               bool reuse_addr) :
-    m_entity_common(), m_io_context(ioc), m_acceptor(ioc), m_io_handlers(), m_acceptor_endp(endp), 
-    m_reuse_addr(reuse_addr) { }
+               bool reuse_addr, const io_context_distributor& distributor) :
+    tcp_acceptor(ioc, endp, reuse_addr) {
+    m_distributor = distributor;
+  }
 
 private:
   // no copy or assignment semantics for this class
@@ -71,6 +119,37 @@ public:
 
   socket_type& get_socket() noexcept { return m_acceptor; }
 
+  bool set_accept_limits(const accept_limits& lim) {
+    if (is_started()) {
+      return false;
+    }
+    m_accept_limits = lim;
+    return true;
+  }
+
+  bool set_accept_batch_size(std::size_t batch_size) {
+    if (is_started()) {
+      return false;
+    }
+    m_accept_batch_size = (batch_size == 0u) ? 1u : batch_size;
+    return true;
+  }
+
+  accept_stats get_accept_stats() {
+    accept_stats st;
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      st.current_connections = m_io_handlers.size();
+    }
+    st.total_accepted = m_total_accepted.load(std::memory_order_relaxed);
+    st.connection_limit_pauses = m_limit_pauses.load(std::memory_order_relaxed);
+    st.rate_limit_pauses = m_rate_pauses.load(std::memory_order_relaxed);
+    st.connection_limit_rejects = m_limit_rejects.load(std::memory_order_relaxed);
+    st.rate_limit_rejects = m_rate_rejects.load(std::memory_order_relaxed);
+    st.accept_wakeups = m_accept_wakeups.load(std::memory_order_relaxed);
+    return st;
+  }
+
   template <typename F1, typename F2>
   bool start(F1&& io_state_chg, F2&& err_func) {
     if (!m_entity_common.start(std::forward<F1>(io_state_chg), std::forward<F2>(err_func))) {
@@ -78,13 +157,23 @@ public:
       return false;
     }
     try {
-      m_acceptor = socket_type(m_io_context, m_acceptor_endp, m_reuse_addr);
+      if (m_reuse_port) {
+        open_reuse_port();
+      }
+      else {
+        m_acceptor = socket_type(m_io_context, m_acceptor_endp, m_reuse_addr);
+      }
+      if (m_accept_batch_size > 1u) {
+        m_acceptor.non_blocking(true); // accept returns would_block when the backlog is empty
+      }
     }
     catch (const std::system_error& se) {
       m_entity_common.call_error_cb(tcp_io_ptr(), se.code());
       stop();
       return false;
     }
+    m_accept_tokens.reset(m_accept_limits.accept_rate, m_accept_limits.accept_burst,
+                          token_bucket::clock_type::now());
     start_accept();
     return true;
   }
@@ -93,7 +182,11 @@ public:
     if (!m_entity_common.stop()) {
       return false; // stop already called
     }
-    auto iohs = m_io_handlers;
+    std::vector<tcp_io_ptr> iohs;
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      iohs = m_io_handlers.snapshot();
+    }
     for (auto i : iohs) {
       i->stop_io();
     }
@@ -101,36 +194,259 @@ public:
     m_entity_common.call_error_cb(tcp_io_ptr(), std::make_error_code(net_ip_errc::tcp_acceptor_stopped));
     std::error_code ec;
     m_acceptor.close(ec);
+    // a rate limit pause may be waiting on the timer
+    asio::post(m_io_context, [self = shared_from_this()] { self->m_accept_timer.cancel(); } );
     return true;
   }
 
 private:
 
-  void start_accept() {
-    using namespace std::placeholders;
+  void open_reuse_port() {
+#if defined(SO_REUSEPORT)
+    m_acceptor = socket_type(m_io_context);
+    m_acceptor.open(m_acceptor_endp.protocol());
+    if (m_reuse_addr) {
+      m_acceptor.set_option(socket_type::reuse_address(true));
+    }
+    m_acceptor.set_option(reuse_port_option(true));
+    m_acceptor.bind(m_acceptor_endp);
+    m_acceptor.listen();
+#else
+    throw std::system_error(std::make_error_code(std::errc::operation_not_supported));
+#endif
+  }
 
+  void start_accept() {
+    if (!is_started() || !accept_admitted()) {
+      return;
+    }
+    if (m_accept_batch_size > 1u) {
+      start_accept_batch();
+      return;
+    }
+    if (m_distributor.acquire) {
+      start_distributed_accept();
+      return;
+    }
     auto self = shared_from_this();
     m_acceptor.async_accept( [this, self] 
             (const std::error_code& err, asio::ip::tcp::socket sock) mutable {
+        m_accept_wakeups.fetch_add(1u, std::memory_order_relaxed);
         if (err) {
           m_entity_common.call_error_cb(tcp_io_ptr(), err);
           stop(); // is this the right thing to do? what are possible causes of errors?
           return;
         }
-        tcp_io_ptr iop = std::make_shared<tcp_io>(std::move(sock), 
-          tcp_io::entity_notifier_cb(std::bind(&tcp_acceptor::notify_me, shared_from_this(), _1, _2)));
-        m_io_handlers.push_back(iop);
-        m_entity_common.call_io_state_chg_cb(iop, m_io_handlers.size(), true);
+        if (connection_admitted()) {
+          add_handler(make_handler(std::move(sock)));
+        }
+        else {
+          std::error_code ec;
+          sock.close(ec);
+        }
         start_accept();
       }
     );
   }
 
-  void notify_me(std::error_code err, tcp_io_ptr iop) {
+  // pause policy, checked before each accept; a pause at the connection limit is
+  // resumed when a connection closes, and a rate limit pause when the timer expires
+  bool accept_admitted() {
+    if (m_accept_limits.policy != accept_limit_policy::pause) {
+      return true;
+    }
+    if (m_accept_limits.max_connections != 0u) {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      if (m_io_handlers.size() + m_pending_handoffs >= m_accept_limits.max_connections) {
+        m_paused_at_max = true;
+        m_limit_pauses.fetch_add(1u, std::memory_order_relaxed);
+        return false;
+      }
+    }
+    auto now = token_bucket::clock_type::now();
+    if (m_accept_tokens.try_take(now)) {
+      return true;
+    }
+    m_rate_pauses.fetch_add(1u, std::memory_order_relaxed);
+    m_accept_timer.expires_after(m_accept_tokens.time_until_token(now));
+    auto self = shared_from_this();
+    m_accept_timer.async_wait( [this, self] (const std::error_code& err) {
+        if (!err) {
+          start_accept();
+        }
+      }
+    );
+    return false;
+  }
+
+  // close policy, checked after each accept
+  bool connection_admitted() {
+    if (m_accept_limits.policy != accept_limit_policy::close) {
+      return true;
+    }
+    if (m_accept_limits.max_connections != 0u) {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      if (m_io_handlers.size() + m_pending_handoffs >= m_accept_limits.max_connections) {
+        m_limit_rejects.fetch_add(1u, std::memory_order_relaxed);
+        return false;
+      }
+    }
+    if (!m_accept_tokens.try_take(token_bucket::clock_type::now())) {
+      m_rate_rejects.fetch_add(1u, std::memory_order_relaxed);
+      return false;
+    }
+    return true;
+  }
+
+  void start_distributed_accept() {
+    asio::io_context& ioc = m_distributor.acquire();
+    auto self = shared_from_this();
+    m_acceptor.async_accept(ioc, [this, self, &ioc] 
+            (const std::error_code& err, asio::ip::tcp::socket sock) mutable {
+        m_accept_wakeups.fetch_add(1u, std::memory_order_relaxed);
+        if (err) {
+          m_distributor.release(ioc);
+          m_entity_common.call_error_cb(tcp_io_ptr(), err);
+          stop();
+          return;
+        }
+        if (!connection_admitted()) {
+          std::error_code ec;
+          sock.close(ec);
+          m_distributor.release(ioc);
+          start_accept();
+          return;
+        }
+        hand_off(ioc, std::move(sock));
+        start_accept();
+      }
+    );
+  }
+
+  // batch accepts: wait for the acceptor to be readable, then accept from the backlog
+  // (non-blocking) until it is empty or the batch size is reached, which takes one
+  // reactor wake-up for a burst of connections rather than one per connection
+  void start_accept_batch() {
+    auto self = shared_from_this();
+    m_acceptor.async_wait(socket_type::wait_read, [this, self] (const std::error_code& err) {
+        m_accept_wakeups.fetch_add(1u, std::memory_order_relaxed);
+        if (err) {
+          m_entity_common.call_error_cb(tcp_io_ptr(), err);
+          stop();
+          return;
+        }
+        handle_accept_batch();
+      }
+    );
+  }
+
+  // the first accept of the batch has already been admitted by start_accept
+  void handle_accept_batch() {
+    for (std::size_t i = 0u; i < m_accept_batch_size; ++i) {
+      if (i != 0u && (!is_started() || !accept_admitted())) {
+        return;
+      }
+      asio::io_context& ioc = m_distributor.acquire ? m_distributor.acquire() : m_io_context;
+      asio::ip::tcp::socket sock(ioc);
+      std::error_code err;
+      m_acceptor.accept(sock, err);
+      if (err) {
+        if (m_distributor.release) {
+          m_distributor.release(ioc);
+        }
+        if (err == asio::error::would_block || err == asio::error::try_again) {
+          start_accept_batch(); // backlog drained, the admission carries over
+          return;
+        }
+        m_entity_common.call_error_cb(tcp_io_ptr(), err);
+        stop();
+        return;
+      }
+      if (!connection_admitted()) {
+        std::error_code ec;
+        sock.close(ec);
+        if (m_distributor.release) {
+          m_distributor.release(ioc);
+        }
+      }
+      else if (m_distributor.acquire) {
+        hand_off(ioc, std::move(sock));
+      }
+      else {
+        add_handler(make_handler(std::move(sock)));
+      }
+    }
+    start_accept(); // batch size reached, the wait completes immediately if more are pending
+  }
+
+  tcp_io_ptr make_handler(asio::ip::tcp::socket sock) {
+    return std::make_shared<tcp_io>(std::move(sock), 
+      tcp_io::entity_notifier_cb::bind<&tcp_acceptor::notify_me>(shared_from_this()));
+  }
+
+  // the connection is handed off to the thread running its io_context, and counts
+  // against the connection limit until it is added to the registry
+  void hand_off(asio::io_context& ioc, asio::ip::tcp::socket sock) {
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      ++m_pending_handoffs;
+    }
+    asio::post(ioc, [this, self = shared_from_this(), iop = make_handler(std::move(sock))] () mutable {
+        add_handler(iop, true);
+      }
+    );
+  }
+
+  void add_handler(tcp_io_ptr iop, bool handed_off = false) {
+    if (!is_started()) { // stopped while a distributed connection was being handed off
+      if (handed_off) {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        --m_pending_handoffs;
+      }
+      iop->close();
+      release_io_context(iop);
+      return;
+    }
+    std::size_t sz = 0u;
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      if (handed_off) {
+        --m_pending_handoffs;
+      }
+      sz = m_io_handlers.add(iop);
+    }
+    m_total_accepted.fetch_add(1u, std::memory_order_relaxed);
+    m_entity_common.call_io_state_chg_cb(iop, sz, true);
+  }
+
+  void release_io_context(const tcp_io_ptr& iop) {
+    if (m_distributor.release) {
+      m_distributor.release(static_cast<asio::io_context&>(iop->get_socket().get_executor().context()));
+    }
+  }
+
+  void notify_me(const std::error_code& err, const tcp_io_ptr& iop) {
+    if (is_output_queue_water_mark(err)) {
+      m_entity_common.call_error_cb(iop, err); // connection not affected
+      return;
+    }
+    std::size_t sz = 0u;
+    bool resume = false;
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      if (!m_io_handlers.remove(iop)) {
+        return; // already notified, e.g. an aborted read after stop_io
+      }
+      sz = m_io_handlers.size();
+      resume = std::exchange(m_paused_at_max, false);
+    }
+    if (resume) { // accepting was paused at the connection limit
+      asio::post(m_io_context, [self = shared_from_this()] { self->start_accept(); } );
+    }
     iop->close();
     m_entity_common.call_error_cb(iop, err);
-    chops::erase_where(m_io_handlers, iop);
-    m_entity_common.call_io_state_chg_cb(iop, m_io_handlers.size(), false);
+    m_entity_common.call_io_state_chg_cb(iop, sz, false);
+    release_io_context(iop);
   }
 
 };
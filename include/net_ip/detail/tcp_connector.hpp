@@ -23,6 +23,7 @@
 #include "asio/io_context.hpp"
 #include "asio/ip/basic_resolver.hpp"
 #include "asio/steady_timer.hpp"
+#include "asio/error.hpp"
 
 #include <system_error>
 #include <vector>
@@ -33,9 +34,11 @@
 
 #include "net_ip/detail/tcp_io.hpp"
 #include "net_ip/detail/net_entity_common.hpp"
+#include "net_ip/detail/reconnect_backoff.hpp"
 
 #include "net_ip/endpoints_resolver.hpp"
 #include "net_ip/io_interface.hpp"
+#include "net_ip/reconnect_policy.hpp"
 
 #include <cassert>
 
@@ -61,7 +64,8 @@ private:
   resolver_type                 m_resolver;
   endpoints                     m_endpoints;
   asio::steady_timer            m_timer;
-  std::chrono::milliseconds     m_reconn_time;
+  asio::steady_timer            m_connect_timer;
+  reconnect_backoff             m_backoff;
   std::string                   m_remote_host;
   std::string                   m_remote_port;
 
@@ -69,36 +73,56 @@ private:
   // handler can't connect or whether the operation is cancelled and it's
   // time to shutdown
   bool                                  m_shutting_down;
+  // set when the connect timer closes the socket, so the aborted connect is
+  // reported as a timeout
+  bool                                  m_connect_timed_out;
 
 public:
   template <typename Iter>
   tcp_connector(asio::io_context& ioc, 
-                Iter beg, Iter end, std::chrono::milliseconds reconn_time) :
+                Iter beg, Iter end, const reconnect_policy& policy) :
       m_entity_common(),
       m_socket(ioc),
       m_io_handler(),
       m_resolver(ioc),
       m_endpoints(beg, end),
       m_timer(ioc),
-      m_reconn_time(reconn_time),
+      m_connect_timer(ioc),
+      m_backoff(policy),
       m_remote_host(),
       m_remote_port(),
-      m_shutting_down(false)
+      m_shutting_down(false),
+      m_connect_timed_out(false)
     { }
 
   tcp_connector(asio::io_context& ioc,
                 std::string_view remote_port, std::string_view remote_host, 
-                std::chrono::milliseconds reconn_time) :
+                const reconnect_policy& policy) :
       m_entity_common(),
       m_socket(ioc),
       m_io_handler(),
       m_resolver(ioc),
       m_endpoints(),
       m_timer(ioc),
-      m_reconn_time(reconn_time),
+      m_connect_timer(ioc),
+      m_backoff(policy),
       m_remote_host(remote_host),
       m_remote_port(remote_port),
-      m_shutting_down(false)
+      m_shutting_down(false),
+      m_connect_timed_out(false)
+    { }
+
+  // fixed reconnect interval, no connect timeout
+  template <typename Iter>
+  tcp_connector(asio::io_context& ioc, 
+                Iter beg, Iter end, std::chrono::milliseconds reconn_time) :
+      tcp_connector(ioc, beg, end, reconnect_policy { reconn_time })
+    { }
+
+  tcp_connector(asio::io_context& ioc,
+                std::string_view remote_port, std::string_view remote_host, 
+                std::chrono::milliseconds reconn_time) :
+      tcp_connector(ioc, remote_port, remote_host, reconnect_policy { reconn_time })
     { }
 
 private:
@@ -121,6 +145,7 @@ public:
       return false;
     }
     m_shutting_down = false;
+    m_backoff.reset();
     // empty endpoints container is the flag that a resolve is needed
     if (m_endpoints.empty()) {
       auto self = shared_from_this();
@@ -173,6 +198,7 @@ private:
       // IO handler not created, may be waiting on timer
       // or in middle of an async connect
       m_timer.cancel();
+      m_connect_timer.cancel();
     }
     std::error_code ec;
     m_socket.close(ec);
@@ -181,6 +207,22 @@ private:
 
   void start_connect() {
     auto self = shared_from_this();
+    m_connect_timed_out = false;
+    auto timeout = m_backoff.get_policy().connect_timeout;
+    if (timeout > std::chrono::milliseconds::zero()) {
+      m_connect_timer.expires_after(timeout);
+      m_connect_timer.async_wait( [this, self] 
+                                  (const std::error_code& err) mutable {
+          if (err || !is_started()) {
+            return;
+          }
+          // aborts the async connect, including any remaining endpoints
+          m_connect_timed_out = true;
+          std::error_code ec;
+          m_socket.close(ec);
+        }
+      );
+    }
     asio::async_connect(m_socket, m_endpoints.cbegin(), m_endpoints.cend(),
           [this, self] 
                 (const std::error_code& err, endpoints_iter iter) mutable {
@@ -189,17 +231,26 @@ private:
     );
   }
 
-  void handle_connect (const std::error_code& err, endpoints_iter /* iter */) {
-    using namespace std::placeholders;
-
+  void handle_connect (std::error_code err, endpoints_iter /* iter */) {
+    m_connect_timer.cancel();
+    if (m_connect_timed_out && !m_shutting_down) {
+      // the timer may have closed the socket just after a successful connect
+      err = asio::error::make_error_code(asio::error::timed_out);
+    }
     if (err) {
       m_entity_common.call_error_cb(tcp_io_ptr(), err);
       if (!is_started() || m_shutting_down ) {
 //      if (!is_started() || err.value() == something) {
         return;
       }
+      auto interval = m_backoff.next_interval();
+      if (!interval) {
+        // no reconnects, or reconnect attempts exhausted
+        stop();
+        return;
+      }
       try {
-        m_timer.expires_after(m_reconn_time);
+        m_timer.expires_after(*interval);
       }
       catch (const std::system_error& se) {
         m_entity_common.call_error_cb(tcp_io_ptr(), se.code());
@@ -216,14 +267,19 @@ private:
       );
       return;
     }
+    m_backoff.reset();
     m_io_handler = std::make_shared<tcp_io>(std::move(m_socket), 
-      tcp_io::entity_notifier_cb(std::bind(&tcp_connector::notify_me, shared_from_this(), _1, _2)));
+      tcp_io::entity_notifier_cb::bind<&tcp_connector::notify_me>(shared_from_this()));
     m_entity_common.call_io_state_chg_cb(m_io_handler, 1, true);
   }
 
-  void notify_me(std::error_code err, tcp_io_ptr iop) {
+  void notify_me(const std::error_code& err, const tcp_io_ptr& iop) {
     assert (iop == m_io_handler);
 
+    if (is_output_queue_water_mark(err)) {
+      m_entity_common.call_error_cb(iop, err); // connection not affected
+      return;
+    }
     iop->close();
     m_entity_common.call_error_cb(iop, err);
     m_entity_common.call_io_state_chg_cb(iop, 0, false);
@@ -21,7 +21,6 @@
 #include "asio/io_context.hpp"
 #include "asio/executor.hpp"
 #include "asio/read.hpp"
-#include "asio/read_until.hpp"
 #include "asio/write.hpp"
 #include "asio/ip/tcp.hpp"
 #include "asio/buffer.hpp"
@@ -34,12 +33,20 @@
 #include <string>
 #include <string_view>
 #include <functional>
+#include <vector>
+#include <atomic>
+#include <algorithm> // std::copy
 
 #include "net_ip/detail/output_queue.hpp"
 #include "net_ip/detail/io_common.hpp"
+#include "net_ip/detail/delimiter_search.hpp"
+#include "net_ip/detail/handler_allocator.hpp"
+#include "net_ip/detail/entity_notifier.hpp"
+#include "net_ip/detail/connection_registry.hpp"
 #include "net_ip/queue_stats.hpp"
 #include "net_ip/net_ip_error.hpp"
 #include "net_ip/basic_io_interface.hpp"
+#include "net_ip/recv_buffer_pool.hpp"
 #include "marshall/shared_buffer.hpp"
 
 namespace chops {
@@ -48,14 +55,20 @@ namespace detail {
 
 std::size_t null_msg_frame (asio::mutable_buffer) noexcept;
 
+// initial read buffer size for delimiter processing, the buffer grows if a 
+// message does not fit
+constexpr std::size_t delim_read_buf_size = 4096u;
+
 class tcp_io : public std::enable_shared_from_this<tcp_io> {
 public:
   using socket_type = asio::ip::tcp::socket;
   using endpoint_type = asio::ip::tcp::endpoint;
-  using entity_notifier_cb = std::function<void (std::error_code, std::shared_ptr<tcp_io>)>;
+  using entity_notifier_cb = entity_notifier<tcp_io>;
 
 private:
   using byte_vec = chops::mutable_shared_buffer::byte_vec;
+  using buf_vec = io_common<tcp_io>::buf_vec;
+  using write_buf_seq = std::vector<asio::const_buffer>;
 
 private:
 
@@ -63,6 +76,18 @@ private:
   io_common<tcp_io>      m_io_common;
   entity_notifier_cb     m_notifier_cb;
   endpoint_type          m_remote_endp;
+  const std::size_t      m_conn_id;
+  // slot in the owning entity's connection registry, only accessed by the entity
+  std::size_t            m_registry_slot;
+  // recycled storage for the handlers of the asynchronous operations
+  handler_memory         m_handler_mem;
+
+  // write batch limits can be set from any thread; the batch containers are only
+  // used while a gathered write is in progress, keeping the buffers alive
+  std::atomic_size_t     m_max_write_batch_bufs;
+  std::atomic_size_t     m_max_write_batch_bytes;
+  buf_vec                m_write_bufs;
+  write_buf_seq          m_write_buf_seq;
 
   // the following members are only used for read processing; they could be 
   // passed through handlers, but are members for simplicity and to reduce 
@@ -70,13 +95,29 @@ private:
   byte_vec               m_byte_vec;
   std::size_t            m_read_size;
   std::string            m_delimiter;
+  delim_search_func      m_delim_search;
+
+  // read-ahead and delimiter processing: unconsumed bytes are in m_byte_vec from 
+  // m_rd_beg to m_rd_end, and the message being framed (or scanned for a delimiter)
+  // starts at m_rd_beg, with m_frame_size bytes of it already framed (or scanned)
+  std::size_t            m_rd_beg;
+  std::size_t            m_rd_end;
+  std::size_t            m_frame_size;
+  std::size_t            m_next_read_size;
+
+  // only used for message handlers taking a pooled_buffer, set on first use
+  recv_buffer_pool*      m_recv_pool;
 
 public:
 
-  tcp_io(socket_type sock, entity_notifier_cb cb) noexcept : 
+  tcp_io(socket_type sock, entity_notifier_cb cb) : 
     m_socket(std::move(sock)), m_io_common(), 
-    m_notifier_cb(cb), m_remote_endp(),
-    m_byte_vec(), m_read_size(0), m_delimiter() { }
+    m_notifier_cb(std::move(cb)), m_remote_endp(), 
+    m_conn_id(next_connection_id()), m_registry_slot(0u), m_handler_mem(),
+    m_max_write_batch_bufs(1), m_max_write_batch_bytes(0), 
+    m_write_bufs(), m_write_buf_seq(),
+    m_byte_vec(), m_read_size(0), m_delimiter(), m_delim_search(select_delim_search()),
+    m_rd_beg(0), m_rd_end(0), m_frame_size(0), m_next_read_size(0), m_recv_pool(nullptr) { }
 
 private:
   // no copy or assignment semantics for this class
@@ -90,11 +131,24 @@ public:
   socket_type& get_socket() noexcept { return m_socket; }
 
   output_queue_stats get_output_queue_stats() const noexcept {
-    return m_io_common.get_output_queue_stats();
+    auto qs = m_io_common.get_output_queue_stats();
+    qs.max_write_batch_bufs = m_max_write_batch_bufs;
+    qs.max_write_batch_bytes = m_max_write_batch_bytes;
+    return qs;
   }
 
+  std::size_t output_queue_size() const noexcept { return m_io_common.output_queue_size(); }
+
+  std::size_t bytes_in_output_queue() const noexcept { return m_io_common.bytes_in_output_queue(); }
+
   bool is_io_started() const noexcept { return m_io_common.is_io_started(); }
 
+  // a max_bufs of 0 or 1 disables batching, a max_bytes of 0 means no byte limit
+  void set_write_batch_limits(std::size_t max_bufs, std::size_t max_bytes) noexcept {
+    m_max_write_batch_bufs = (max_bufs == 0u ? 1u : max_bufs);
+    m_max_write_batch_bytes = max_bytes;
+  }
+
   template <typename MH, typename MF>
   bool start_io(std::size_t header_size, MH&& msg_handler, MF&& msg_frame) {
     if (!start_io_setup()) {
@@ -107,13 +161,34 @@ public:
     return true;
   }
 
+  template <typename MH, typename MF>
+  bool start_io(std::size_t header_size, MH&& msg_handler, MF&& msg_frame,
+                std::size_t read_ahead_size) {
+    // a 0 header size would never advance the frame logic over the read-ahead buffer
+    if (header_size == 0u || !start_io_setup()) {
+      return false;
+    }
+    m_read_size = header_size;
+    m_next_read_size = header_size;
+    m_frame_size = 0;
+    m_rd_beg = 0;
+    m_rd_end = 0;
+    m_byte_vec.resize(read_ahead_size < header_size ? header_size : read_ahead_size);
+    start_read_some(std::forward<MH>(msg_handler), std::forward<MF>(msg_frame));
+    return true;
+  }
+
   template <typename MH>
   bool start_io(std::string_view delimiter, MH&& msg_handler) {
-    if (!start_io_setup()) {
+    if (delimiter.empty() || !start_io_setup()) {
       return false;
     }
     m_delimiter = delimiter;
-    start_read_until(std::forward<MH>(msg_handler));
+    m_frame_size = 0;
+    m_rd_beg = 0;
+    m_rd_end = 0;
+    m_byte_vec.resize(delim_read_buf_size);
+    start_read_delim(std::forward<MH>(msg_handler));
     return true;
   }
 
@@ -143,23 +218,49 @@ public:
     return false;
   }
 
-  // use post for thread safety, multiple threads can call this method
-  void send(chops::const_shared_buffer buf) {
+  // multiple threads can call this method; bufs are pushed onto a lock-free queue
+  // and only the push that makes the queue non-empty posts to the run thread, which
+  // then drains all pending bufs at once
+  bool send(chops::const_shared_buffer buf, std::size_t priority = 0u) {
+    auto res = m_io_common.push_send(std::move(buf), priority);
+    if (res != io_common<tcp_io>::push_result::post_drain) {
+      return res != io_common<tcp_io>::push_result::rejected; // drain already posted
+    }
     auto self { shared_from_this() };
-    post(m_socket.get_executor(), [this, self, buf] {
-        if (!m_io_common.start_write_setup(buf)) {
-          return; // buf queued or shutdown happening
-        }
-        start_write(buf);
-      }
-    );
+    post_custom_alloc_handler(m_socket.get_executor(), m_handler_mem, 
+                              [this, self] { drain_sends(); } );
+    return true;
+  }
+
+  bool send(const chops::const_shared_buffer& buf, const endpoint_type&) {
+    return send(buf);
+  }
+
+  // only called from the thread running the io_context (e.g. a broadcast posted once
+  // per executor by send_to_all), so the drain is performed without a post
+  bool send_in_io_thread(chops::const_shared_buffer buf) {
+    auto res = m_io_common.push_send(std::move(buf));
+    if (res == io_common<tcp_io>::push_result::post_drain) {
+      drain_sends();
+    }
+    return res != io_common<tcp_io>::push_result::rejected;
   }
 
-  void send(const chops::const_shared_buffer& buf, const endpoint_type&) {
-    send(buf);
+  void set_output_queue_limits(const output_queue_limits& lim) noexcept {
+    m_io_common.set_output_queue_limits(lim);
   }
 
+  bool set_output_queue_conflation(output_queue_key_func key_func) {
+    return m_io_common.set_output_queue_key_func(std::move(key_func));
+  }
+
+  std::size_t connection_id() const noexcept { return m_conn_id; }
+
 public:
+  // the registry slot methods are only called by the owning net entity
+  std::size_t get_registry_slot() const noexcept { return m_registry_slot; }
+  void set_registry_slot(std::size_t slot) noexcept { m_registry_slot = slot; }
+
   // this method can only be called through a net entity, assumes all error codes have already
   // been reported back to the net entity
   void close() {
@@ -192,38 +293,97 @@ private:
     return true;
   }
 
+  recv_buffer_pool& recv_pool() {
+    if (!m_recv_pool) {
+      m_recv_pool = &asio::use_service<recv_buffer_pool>(m_socket.get_executor().context());
+    }
+    return *m_recv_pool;
+  }
+
+  // a message handler taking a pooled_buffer is given a copy of the message in a
+  // buffer from the pool, otherwise a view into the read buffer
+  template <typename MH>
+  bool invoke_msg_hdlr(MH& msg_hdlr, const std::byte* buf, std::size_t sz) {
+    using io_intf = basic_io_interface<tcp_io>;
+    if constexpr (is_pooled_msg_handler<MH, io_intf, endpoint_type>) {
+      return msg_hdlr(recv_pool().acquire(buf, sz), io_intf(weak_from_this()), m_remote_endp);
+    }
+    else {
+      return msg_hdlr(asio::const_buffer(buf, sz), io_intf(weak_from_this()), m_remote_endp);
+    }
+  }
+
   template <typename MH, typename MF>
   void start_read(asio::mutable_buffer mbuf, MH&& msg_hdlr, MF&& msg_frame) {
     // std::move in lambda instead of std::forward since an explicit copy or move of the function
     // object is desired so there are no dangling references
     auto self { shared_from_this() };
-    asio::async_read(m_socket, mbuf,
+    asio::async_read(m_socket, mbuf, make_custom_alloc_handler(m_handler_mem,
       [this, self, mbuf, mh = std::move(msg_hdlr), mf = std::move(msg_frame)]
             (const std::error_code& err, std::size_t nb) mutable {
         handle_read(mbuf, err, nb, std::move(mh), std::move(mf));
       }
-    );
+    ));
   }
 
   template <typename MH, typename MF>
   void handle_read(asio::mutable_buffer, 
                    const std::error_code&, std::size_t, MH&&, MF&&);
 
+  template <typename MH, typename MF>
+  void start_read_some(MH&& msg_hdlr, MF&& msg_frame) {
+    auto self { shared_from_this() };
+    m_socket.async_read_some(asio::mutable_buffer(m_byte_vec.data() + m_rd_end, 
+                                                  m_byte_vec.size() - m_rd_end),
+      make_custom_alloc_handler(m_handler_mem,
+        [this, self, mh = std::move(msg_hdlr), mf = std::move(msg_frame)]
+              (const std::error_code& err, std::size_t nb) mutable {
+          handle_read_some(err, nb, std::move(mh), std::move(mf));
+        }
+      )
+    );
+  }
+
+  template <typename MH, typename MF>
+  void handle_read_some(const std::error_code&, std::size_t, MH&&, MF&&);
+
+  void compact_read_buf(std::size_t);
+
   template <typename MH>
-  void start_read_until(MH&& msg_hdlr) {
+  void start_read_delim(MH&& msg_hdlr) {
     auto self { shared_from_this() };
-    asio::async_read_until(m_socket, asio::dynamic_buffer(m_byte_vec), m_delimiter,
-      [this, self, mh = std::move(msg_hdlr)] (const std::error_code& err, std::size_t nb) mutable {
-        handle_read_until(err, nb, std::move(mh));
-      }
+    m_socket.async_read_some(asio::mutable_buffer(m_byte_vec.data() + m_rd_end, 
+                                                  m_byte_vec.size() - m_rd_end),
+      make_custom_alloc_handler(m_handler_mem,
+        [this, self, mh = std::move(msg_hdlr)] (const std::error_code& err, std::size_t nb) mutable {
+          handle_read_delim(err, nb, std::move(mh));
+        }
+      )
     );
   }
 
   template <typename MH>
-  void handle_read_until(const std::error_code&, std::size_t, MH&&);
+  void handle_read_delim(const std::error_code&, std::size_t, MH&&);
+
+  void drain_sends() {
+    auto elem = m_io_common.drain_sends();
+    if (notify_output_queue_event()) {
+      return; // output queue overflow, connection closing
+    }
+    if (!elem) {
+      return; // bufs queued or shutdown happening
+    }
+    start_write(std::move(elem->first));
+  }
+
+  void msg_hdlr_terminated();
+
+  bool notify_output_queue_event();
 
   void start_write(chops::const_shared_buffer);
 
+  void start_write_batch();
+
   void handle_write(const std::error_code&, std::size_t);
 
 };
@@ -236,17 +396,27 @@ void tcp_io::handle_read(asio::mutable_buffer mbuf,
                          MH&& msg_hdlr, MF&& msg_frame) {
 
   if (err) {
-    m_notifier_cb(err, shared_from_this());
+    if (is_io_started()) { // otherwise already closed, e.g. an aborted read after stop_io
+      m_notifier_cb(err, shared_from_this());
+    }
     return;
   }
   // assert num_bytes == mbuf.size()
   std::size_t next_read_size = msg_frame(mbuf);
   if (next_read_size == 0) { // msg fully received, now invoke message handler
-    if (!msg_hdlr(asio::const_buffer(m_byte_vec.data(), m_byte_vec.size()), 
-                  basic_io_interface<tcp_io>(weak_from_this()), m_remote_endp)) {
+    bool ret;
+    using io_intf = basic_io_interface<tcp_io>;
+    if constexpr (is_pooled_msg_handler<MH, io_intf, endpoint_type>) {
+      // the message bytes are swapped into a pooled buffer, without a copy
+      ret = msg_hdlr(recv_pool().acquire(m_byte_vec), io_intf(weak_from_this()), m_remote_endp);
+    }
+    else {
+      ret = msg_hdlr(asio::const_buffer(m_byte_vec.data(), m_byte_vec.size()), 
+                     io_intf(weak_from_this()), m_remote_endp);
+    }
+    if (!ret) {
       // message handler not happy, tear everything down
-      m_notifier_cb(std::make_error_code(net_ip_errc::message_handler_terminated), 
-                    shared_from_this());
+      msg_hdlr_terminated();
       return;
     }
     m_byte_vec.resize(m_read_size);
@@ -260,41 +430,153 @@ void tcp_io::handle_read(asio::mutable_buffer mbuf,
   start_read(mbuf, std::forward<MH>(msg_hdlr), std::forward<MF>(msg_frame));
 }
 
-template <typename MH>
-void tcp_io::handle_read_until(const std::error_code& err, std::size_t num_bytes, MH&& msg_hdlr) {
+template <typename MH, typename MF>
+void tcp_io::handle_read_some(const std::error_code& err, std::size_t num_bytes,
+                              MH&& msg_hdlr, MF&& msg_frame) {
 
   if (err) {
-    m_notifier_cb(err, shared_from_this());
+    if (is_io_started()) { // otherwise already closed, e.g. an aborted read after stop_io
+      m_notifier_cb(err, shared_from_this());
+    }
     return;
   }
-  // beginning of m_byte_vec to num_bytes is buf, includes delimiter bytes
-  if (!msg_hdlr(asio::const_buffer(m_byte_vec.data(), num_bytes),
-                basic_io_interface<tcp_io>(weak_from_this()), m_remote_endp)) {
-      m_notifier_cb(std::make_error_code(net_ip_errc::message_handler_terminated), 
-                    shared_from_this());
+  m_rd_end += num_bytes;
+  // run the message frame logic over the bytes already read, invoking the message 
+  // handler for every complete message before another read is started
+  while ((m_rd_end - m_rd_beg - m_frame_size) >= m_next_read_size) {
+    std::size_t next_read_size = 
+        msg_frame(asio::mutable_buffer(m_byte_vec.data() + m_rd_beg + m_frame_size, 
+                                       m_next_read_size));
+    m_frame_size += m_next_read_size;
+    if (next_read_size != 0) {
+      m_next_read_size = next_read_size;
+      continue;
+    }
+    if (!invoke_msg_hdlr(msg_hdlr, m_byte_vec.data() + m_rd_beg, m_frame_size)) {
+      // message handler not happy, tear everything down
+      msg_hdlr_terminated();
+      return;
+    }
+    m_rd_beg += m_frame_size;
+    m_frame_size = 0;
+    m_next_read_size = m_read_size;
+  }
+  compact_read_buf(m_frame_size + m_next_read_size);
+  start_read_some(std::forward<MH>(msg_hdlr), std::forward<MF>(msg_frame));
+}
+
+// move the partial message (if any) to the front of the buffer, and make sure the
+// buffer is big enough for the rest of it
+inline void tcp_io::compact_read_buf(std::size_t min_size) {
+  if (m_rd_beg != 0) {
+    std::copy(m_byte_vec.begin() + m_rd_beg, m_byte_vec.begin() + m_rd_end, m_byte_vec.begin());
+    m_rd_end -= m_rd_beg;
+    m_rd_beg = 0;
+  }
+  if (m_byte_vec.size() < min_size) {
+    m_byte_vec.resize(min_size);
+  }
+}
+
+template <typename MH>
+void tcp_io::handle_read_delim(const std::error_code& err, std::size_t num_bytes, MH&& msg_hdlr) {
+
+  if (err) {
+    if (is_io_started()) { // otherwise already closed, e.g. an aborted read after stop_io
+      m_notifier_cb(err, shared_from_this());
+    }
     return;
   }
-  m_byte_vec.erase(m_byte_vec.begin(), m_byte_vec.begin() + num_bytes);
-  start_read_until(std::forward<MH>(msg_hdlr));
+  m_rd_end += num_bytes;
+  auto delim = reinterpret_cast<const std::byte*>(m_delimiter.data());
+  // invoke the message handler for every complete message in the buffer, consuming 
+  // each one by advancing the beginning offset
+  for (;;) {
+    auto scan_end = m_byte_vec.data() + m_rd_end;
+    auto iter = m_delim_search(m_byte_vec.data() + m_rd_beg + m_frame_size, scan_end,
+                               delim, m_delimiter.size());
+    if (iter == scan_end) {
+      // no delimiter, next scan starts where a partial delimiter could begin
+      std::size_t unscanned = m_rd_end - m_rd_beg;
+      m_frame_size = (unscanned < m_delimiter.size()) ? 0u : unscanned - m_delimiter.size() + 1u;
+      break;
+    }
+    std::size_t msg_end = (iter - m_byte_vec.data()) + m_delimiter.size();
+    // msg buf includes delimiter bytes
+    if (!invoke_msg_hdlr(msg_hdlr, m_byte_vec.data() + m_rd_beg, msg_end - m_rd_beg)) {
+      msg_hdlr_terminated();
+      return;
+    }
+    m_rd_beg = msg_end;
+    m_frame_size = 0;
+  }
+  // a buffer full of a partial message is doubled in size
+  std::size_t partial = m_rd_end - m_rd_beg;
+  compact_read_buf(partial < m_byte_vec.size() ? m_byte_vec.size() : 2u * partial);
+  start_read_delim(std::forward<MH>(msg_hdlr));
 }
 
+inline void tcp_io::msg_hdlr_terminated() {
+  m_notifier_cb(std::make_error_code(net_ip_errc::message_handler_terminated), 
+                shared_from_this());
+}
+
+// water mark notifications are informational, an overflow (with the close policy)
+// results in the connection being closed by the net entity
+inline bool tcp_io::notify_output_queue_event() {
+  auto err = m_io_common.output_queue_event();
+  if (!err) {
+    return false;
+  }
+  m_notifier_cb(err, shared_from_this());
+  return err == std::make_error_code(net_ip_errc::output_queue_overflow);
+}
 
+// the handler keeps the buf alive until the write completes
 inline void tcp_io::start_write(chops::const_shared_buffer buf) {
   auto self { shared_from_this() };
   asio::async_write(m_socket, asio::const_buffer(buf.data(), buf.size()),
-            [this, self] (const std::error_code& err, std::size_t nb) {
+            make_custom_alloc_handler(m_handler_mem, 
+                [this, self, buf] (const std::error_code& err, std::size_t nb) {
+      handle_write(err, nb);
+    }
+  ));
+}
+
+inline void tcp_io::start_write_batch() {
+  m_write_buf_seq.clear();
+  for (const auto& buf : m_write_bufs) {
+    m_write_buf_seq.push_back(asio::const_buffer(buf.data(), buf.size()));
+  }
+  auto self { shared_from_this() };
+  asio::async_write(m_socket, m_write_buf_seq,
+            make_custom_alloc_handler(m_handler_mem, 
+                [this, self] (const std::error_code& err, std::size_t nb) {
       handle_write(err, nb);
     }
-  );
+  ));
 }
 
 inline void tcp_io::handle_write(const std::error_code& err, std::size_t /* num_bytes */) {
+  m_write_bufs.clear(); // release any buffers from a completed batch write
   if (err) {
     // read pops first, so usually no error is needed in write handlers
     // m_notifier_cb(err, shared_from_this());
     return;
   }
+  m_io_common.write_completed();
+  std::size_t max_bufs = m_max_write_batch_bufs;
+  if (max_bufs > 1u) {
+    auto cnt = m_io_common.get_next_elements(m_write_bufs, max_bufs, m_max_write_batch_bytes);
+    notify_output_queue_event();
+    if (cnt == 0u) {
+      return;
+    }
+    start_write_batch();
+    return;
+  }
   auto elem = m_io_common.get_next_element();
+  notify_output_queue_event();
   if (!elem) {
     return;
   }
@@ -0,0 +1,99 @@
+/** @file
+ *
+ *  @ingroup net_ip_module
+ *
+ *  @brief A token bucket rate limiter.
+ *
+ *  Tokens are added continuously at the rate, up to the burst size, and each admitted
+ *  event takes a token. The time is passed in to each call, which allows the refill to
+ *  be tested without waiting.
+ *
+ *  @note For internal use only.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef TOKEN_BUCKET_HPP_INCLUDED
+#define TOKEN_BUCKET_HPP_INCLUDED
+
+#include <cstddef> // std::size_t
+#include <chrono>
+#include <algorithm> // std::min, std::max
+
+namespace chops {
+namespace net {
+namespace detail {
+
+// not thread safe
+class token_bucket {
+public:
+  using clock_type = std::chrono::steady_clock;
+  using time_point = clock_type::time_point;
+  using duration = clock_type::duration;
+
+private:
+  double      m_rate; // tokens per second, 0 means no limit
+  double      m_burst;
+  double      m_tokens;
+  time_point  m_last;
+
+public:
+  token_bucket() noexcept : m_rate(0.0), m_burst(1.0), m_tokens(1.0), m_last() { }
+
+  // the bucket starts full
+  void reset(double rate, std::size_t burst, time_point now) noexcept {
+    m_rate = rate;
+    m_burst = static_cast<double>(std::max(burst, std::size_t(1u)));
+    m_tokens = m_burst;
+    m_last = now;
+  }
+
+  bool is_limited() const noexcept { return m_rate > 0.0; }
+
+  bool try_take(time_point now) noexcept {
+    if (!is_limited()) {
+      return true;
+    }
+    refill(now);
+    if (m_tokens < 1.0) {
+      return false;
+    }
+    m_tokens -= 1.0;
+    return true;
+  }
+
+  // time until a token is available, rounded up so that a timer does not expire early
+  duration time_until_token(time_point now) noexcept {
+    if (!is_limited()) {
+      return duration::zero();
+    }
+    refill(now);
+    if (m_tokens >= 1.0) {
+      return duration::zero();
+    }
+    return std::chrono::ceil<duration>(std::chrono::duration<double>((1.0 - m_tokens) / m_rate));
+  }
+
+private:
+  void refill(time_point now) noexcept {
+    if (now <= m_last) {
+      return;
+    }
+    std::chrono::duration<double> elapsed = now - m_last;
+    m_tokens = std::min(m_burst, m_tokens + elapsed.count() * m_rate);
+    m_last = now;
+  }
+};
+
+} // end detail namespace
+} // end net namespace
+} // end chops namespace
+
+#endif
+
@@ -4,6 +4,11 @@
  *
  *  @brief Internal class that combines a UDP entity and UDP io handler.
  *
+ *  On Linux a batched mode is available, where @c recvmmsg fills an array of 
+ *  datagram slots and @c sendmmsg flushes queued output datagrams, reducing the
+ *  number of system calls per datagram. The socket readiness is still waited for 
+ *  through the @c io_context. On other platforms the batch size is ignored.
+ *
  *  @note For internal use only.
  *
  *  @author Cliff Green
@@ -21,6 +26,8 @@
 #include "asio/io_context.hpp"
 #include "asio/executor.hpp"
 #include "asio/ip/udp.hpp"
+#include "asio/ip/multicast.hpp"
+#include "asio/ip/address.hpp"
 #include "asio/buffer.hpp"
 
 #include <memory> // std::shared_ptr, std::enable_shared_from_this
@@ -28,20 +35,86 @@
 
 #include <cstddef> // std::size_t
 #include <utility> // std::forward, std::move
+#include <vector>
+#include <atomic>
+#include <optional>
+#include <cstring> // std::memcpy
+
+#if !defined(_WIN32)
+#include <netinet/in.h> // source-specific multicast socket options
+#include <cerrno>
+#endif
+
+#if defined(__linux__)
+#define CHOPS_NET_UDP_MMSG
+#include <sys/socket.h> // recvmmsg, sendmmsg
+#include <sys/uio.h> // iovec
+#include <cerrno>
+#endif
 
 #include "net_ip/detail/io_common.hpp"
 #include "net_ip/detail/net_entity_common.hpp"
 #include "net_ip/detail/output_queue.hpp"
+#include "net_ip/detail/handler_allocator.hpp"
+#include "net_ip/detail/connection_registry.hpp"
 
 #include "net_ip/queue_stats.hpp"
+#include "net_ip/multicast_options.hpp"
 #include "net_ip/net_ip_error.hpp"
 #include "net_ip/basic_io_interface.hpp"
+#include "net_ip/recv_buffer_pool.hpp"
 #include "marshall/shared_buffer.hpp"
 
 namespace chops {
 namespace net {
 namespace detail {
 
+// asio has no source-specific multicast socket options, so the native options are used
+inline std::error_code source_specific_membership(int fd, bool join, 
+                                                  const asio::ip::address& group,
+                                                  const asio::ip::address& source,
+                                                  const asio::ip::address_v4& intf_addr,
+                                                  unsigned int intf_idx) {
+#if defined(IP_ADD_SOURCE_MEMBERSHIP) && defined(MCAST_JOIN_SOURCE_GROUP)
+  if (group.is_v4()) {
+    if (!source.is_v4()) {
+      return std::make_error_code(std::errc::invalid_argument);
+    }
+    ip_mreq_source mreq { };
+    std::memcpy(&mreq.imr_multiaddr, group.to_v4().to_bytes().data(), 4);
+    std::memcpy(&mreq.imr_sourceaddr, source.to_v4().to_bytes().data(), 4);
+    std::memcpy(&mreq.imr_interface, intf_addr.to_bytes().data(), 4);
+    if (::setsockopt(fd, IPPROTO_IP, join ? IP_ADD_SOURCE_MEMBERSHIP : IP_DROP_SOURCE_MEMBERSHIP,
+                     &mreq, sizeof(mreq)) != 0) {
+      return std::error_code(errno, std::system_category());
+    }
+    return std::error_code();
+  }
+  if (!source.is_v6()) {
+    return std::make_error_code(std::errc::invalid_argument);
+  }
+  auto make_sockaddr = [] (const asio::ip::address& addr) {
+    sockaddr_in6 sa { };
+    sa.sin6_family = AF_INET6;
+    std::memcpy(&sa.sin6_addr, addr.to_v6().to_bytes().data(), 16);
+    return sa;
+  };
+  group_source_req gsr { };
+  gsr.gsr_interface = intf_idx;
+  auto grp_sa = make_sockaddr(group);
+  auto src_sa = make_sockaddr(source);
+  std::memcpy(&gsr.gsr_group, &grp_sa, sizeof(grp_sa));
+  std::memcpy(&gsr.gsr_source, &src_sa, sizeof(src_sa));
+  if (::setsockopt(fd, IPPROTO_IPV6, join ? MCAST_JOIN_SOURCE_GROUP : MCAST_LEAVE_SOURCE_GROUP,
+                   &gsr, sizeof(gsr)) != 0) {
+    return std::error_code(errno, std::system_category());
+  }
+  return std::error_code();
+#else
+  return std::make_error_code(std::errc::operation_not_supported);
+#endif
+}
+
 class udp_entity_io : public std::enable_shared_from_this<udp_entity_io> {
 public:
   using socket_type = asio::ip::udp::socket;
@@ -49,6 +122,7 @@ public:
 
 private:
   using byte_vec = chops::mutable_shared_buffer::byte_vec;
+  using outq_el = io_common<udp_entity_io>::outq_el;
 
 private:
 
@@ -58,20 +132,58 @@ private:
   socket_type                       m_socket;
   endpoint_type                     m_local_endp;
   endpoint_type                     m_default_dest_endp;
-  // TODO: multicast stuff
+  std::optional<multicast_options>  m_mcast_opts;
+  const std::size_t                 m_conn_id;
+  // recycled storage for the handlers of the asynchronous operations
+  handler_memory                    m_handler_mem;
 
   // following members could be passed through handler, but are members for 
   // simplicity and less copying
   byte_vec                          m_byte_vec;
   std::size_t                       m_max_size;
   endpoint_type                     m_sender_endp;
+  // only used for message handlers taking a pooled_buffer, set on first use
+  recv_buffer_pool*                 m_recv_pool;
+
+  // a batch size of 1 is one datagram per system call
+  std::atomic_size_t                m_batch_size;
+#ifdef CHOPS_NET_UDP_MMSG
+  // read slots, each pointing into m_byte_vec and an endpoint for the sender address
+  std::vector<mmsghdr>              m_rd_msgs;
+  std::vector<iovec>                m_rd_iovs;
+  std::vector<endpoint_type>        m_rd_endps;
+  // datagrams being sent, m_wr_idx is the first one not yet accepted by the socket
+  std::vector<outq_el>              m_wr_elems;
+  std::vector<mmsghdr>              m_wr_msgs;
+  std::vector<iovec>                m_wr_iovs;
+  std::vector<endpoint_type>        m_wr_endps;
+  std::size_t                       m_wr_idx;
+#endif
 
 public:
   udp_entity_io(asio::io_context& ioc, 
                 const endpoint_type& local_endp) noexcept : 
     m_io_common(), m_entity_common(), m_io_context(ioc),
-    m_socket(ioc), m_local_endp(local_endp), m_default_dest_endp(), 
-    m_byte_vec(), m_max_size(0), m_sender_endp() { }
+    m_socket(ioc), m_local_endp(local_endp), m_default_dest_endp(), m_mcast_opts(),
+    m_conn_id(next_connection_id()), m_handler_mem(),
+    m_byte_vec(), m_max_size(0), m_sender_endp(), m_recv_pool(nullptr), m_batch_size(1)
+#ifdef CHOPS_NET_UDP_MMSG
+    , m_rd_msgs(), m_rd_iovs(), m_rd_endps(), 
+    m_wr_elems(), m_wr_msgs(), m_wr_iovs(), m_wr_endps(), m_wr_idx(0)
+#endif
+    { }
+
+  // multicast receiver if the local endpoint is specified (the group is joined when
+  // started), otherwise a multicast sender; the default destination is used by sends
+  // without an endpoint until overridden by start_io
+  udp_entity_io(asio::io_context& ioc, 
+                const endpoint_type& local_endp,
+                const multicast_options& opts,
+                const endpoint_type& default_dest_endp) :
+    udp_entity_io(ioc, local_endp) {
+    m_mcast_opts = opts;
+    m_default_dest_endp = default_dest_endp;
+  }
 
 private:
   // no copy or assignment semantics for this class
@@ -89,12 +201,35 @@ public:
 
   bool is_io_started() const noexcept { return m_io_common.is_io_started(); }
 
+  std::size_t connection_id() const noexcept { return m_conn_id; }
+
   socket_type& get_socket() noexcept { return m_socket; }
 
   output_queue_stats get_output_queue_stats() const noexcept {
     return m_io_common.get_output_queue_stats();
   }
 
+  std::size_t output_queue_size() const noexcept { return m_io_common.output_queue_size(); }
+
+  std::size_t bytes_in_output_queue() const noexcept { return m_io_common.bytes_in_output_queue(); }
+
+  // the group membership methods are only valid after start is called
+  std::error_code join_multicast_group(const asio::ip::address& group, 
+                                       const asio::ip::address& source) {
+    return multicast_membership(true, group, source);
+  }
+
+  std::error_code leave_multicast_group(const asio::ip::address& group, 
+                                        const asio::ip::address& source) {
+    return multicast_membership(false, group, source);
+  }
+
+  // the read batch size is used when start_io is called, the write batch size takes 
+  // effect on the next write; 0 is treated as 1
+  void set_datagram_batch_size(std::size_t batch_size) noexcept {
+    m_batch_size = (batch_size == 0u ? 1u : batch_size);
+  }
+
   template <typename F1, typename F2>
   bool start(F1&& io_state_chg, F2&& err_cb) {
     if (!m_entity_common.start(std::forward<F1>(io_state_chg), std::forward<F2>(err_cb))) {
@@ -105,11 +240,22 @@ public:
       // assume default constructed endpoints compare equal
       if (m_local_endp == endpoint_type()) {
 // TODO: this needs to be changed, doesn't allow sending to an ipV6 endpoint
-        m_socket.open(asio::ip::udp::v4());
+        // (other than multicast, which uses the IP version of the group)
+        m_socket.open(m_mcast_opts ? endpoint_type(m_mcast_opts->group, 0).protocol() :
+                                     asio::ip::udp::v4());
+      }
+      else if (m_mcast_opts) {
+        // multiple receivers on a host can bind to the same multicast port
+        m_socket.open(m_local_endp.protocol());
+        m_socket.set_option(socket_type::reuse_address(true));
+        m_socket.bind(m_local_endp);
       }
       else {
         m_socket = socket_type(m_io_context, m_local_endp);
       }
+      if (m_mcast_opts) {
+        set_multicast_options();
+      }
     }
     catch (const std::system_error& se) {
       err_notify(se.code());
@@ -126,7 +272,7 @@ public:
       return false;
     }
     m_max_size = max_size;
-    start_read(std::forward<MH>(msg_handler));
+    start_read_io(std::forward<MH>(msg_handler));
     return true;
   }
 
@@ -137,7 +283,7 @@ public:
     }
     m_max_size = max_size;
     m_default_dest_endp = endp;
-    start_read(std::forward<MH>(msg_handler));
+    start_read_io(std::forward<MH>(msg_handler));
     return true;
   }
 
@@ -176,30 +322,113 @@ public:
     return true;
   }
 
-  void send(chops::const_shared_buffer buf) {
-    auto self { shared_from_this() };
-    post(m_socket.get_executor(), [this, self, buf] {
-        if (!m_io_common.start_write_setup(buf)) {
-          return; // buf queued or shutdown happening
-        }
-        start_write(buf, m_default_dest_endp);
-      }
-    );
+  // see tcp_io send comments, only the push that makes the pending sends non-empty
+  // posts a drain to the run thread
+  bool send(chops::const_shared_buffer buf, std::size_t priority = 0u) {
+    return post_drain_sends(m_io_common.push_send(std::move(buf), priority));
   }
 
-  void send(chops::const_shared_buffer buf, const endpoint_type& endp) {
-    auto self { shared_from_this() };
-    post(m_socket.get_executor(), [this, self, buf, endp] {
-        if (!m_io_common.start_write_setup(buf, endp)) {
-          return; // buf queued or shutdown happening
-        }
-        start_write(buf, endp);
-      }
-    );
+  bool send(chops::const_shared_buffer buf, const endpoint_type& endp) {
+    return post_drain_sends(m_io_common.push_send(std::move(buf), endp));
+  }
+
+  // only called from the thread running the io_context (e.g. a broadcast posted once
+  // per executor by send_to_all), so the drain is performed without a post
+  bool send_in_io_thread(chops::const_shared_buffer buf) {
+    auto res = m_io_common.push_send(std::move(buf));
+    if (res == io_common<udp_entity_io>::push_result::post_drain) {
+      drain_sends();
+    }
+    return res != io_common<udp_entity_io>::push_result::rejected;
+  }
+
+  void set_output_queue_limits(const output_queue_limits& lim) noexcept {
+    m_io_common.set_output_queue_limits(lim);
+  }
+
+  bool set_output_queue_conflation(output_queue_key_func key_func) {
+    return m_io_common.set_output_queue_key_func(std::move(key_func));
   }
 
 private:
 
+  void set_multicast_options() {
+    const auto& opts = *m_mcast_opts;
+    m_socket.set_option(asio::ip::multicast::hops(opts.ttl));
+    m_socket.set_option(asio::ip::multicast::enable_loopback(opts.loopback));
+    if (opts.group.is_v4() && !opts.interface_addr.is_unspecified()) {
+      m_socket.set_option(asio::ip::multicast::outbound_interface(opts.interface_addr.to_v4()));
+    }
+    else if (opts.group.is_v6() && opts.interface_index != 0u) {
+      m_socket.set_option(asio::ip::multicast::outbound_interface(opts.interface_index));
+    }
+    if (m_local_endp != endpoint_type()) { // receiver
+      auto ec = multicast_membership(true, opts.group, opts.source);
+      if (ec) {
+        throw std::system_error(ec);
+      }
+    }
+  }
+
+  std::error_code multicast_membership(bool join, const asio::ip::address& group,
+                                       const asio::ip::address& source) {
+    auto intf_addr = (m_mcast_opts && m_mcast_opts->interface_addr.is_v4()) ?
+                       m_mcast_opts->interface_addr.to_v4() : asio::ip::address_v4::any();
+    unsigned int intf_idx = m_mcast_opts ? m_mcast_opts->interface_index : 0u;
+    if (!source.is_unspecified()) {
+      return source_specific_membership(m_socket.native_handle(), join, group, source, 
+                                        intf_addr, intf_idx);
+    }
+    std::error_code ec;
+    if (group.is_v4()) {
+      join ? m_socket.set_option(asio::ip::multicast::join_group(group.to_v4(), intf_addr), ec) :
+             m_socket.set_option(asio::ip::multicast::leave_group(group.to_v4(), intf_addr), ec);
+    }
+    else {
+      join ? m_socket.set_option(asio::ip::multicast::join_group(group.to_v6(), intf_idx), ec) :
+             m_socket.set_option(asio::ip::multicast::leave_group(group.to_v6(), intf_idx), ec);
+    }
+    return ec;
+  }
+
+  std::size_t batch_size() const noexcept {
+#ifdef CHOPS_NET_UDP_MMSG
+    return m_batch_size;
+#else
+    return 1u;
+#endif
+  }
+
+  template <typename MH>
+  void start_read_io(MH&& msg_hdlr) {
+#ifdef CHOPS_NET_UDP_MMSG
+    if (batch_size() > 1u) {
+      setup_read_batch(batch_size());
+      start_read_batch(std::forward<MH>(msg_hdlr));
+      return;
+    }
+#endif
+    start_read(std::forward<MH>(msg_hdlr));
+  }
+
+  recv_buffer_pool& recv_pool() {
+    if (!m_recv_pool) {
+      m_recv_pool = &asio::use_service<recv_buffer_pool>(m_io_context);
+    }
+    return *m_recv_pool;
+  }
+
+  // a datagram filling at least half of the receive buffer is swapped into a pooled
+  // buffer, without a copy; a smaller one is copied, so that a pooled buffer doesn't
+  // keep max size capacity for a small datagram
+  pooled_buffer acquire_pooled(std::size_t num_bytes) {
+    if (num_bytes < m_max_size / 2u) {
+      return recv_pool().acquire(m_byte_vec.data(), num_bytes);
+    }
+    m_byte_vec.resize(num_bytes);
+    return recv_pool().acquire(m_byte_vec);
+  }
+
   template <typename MH>
   void start_read(MH&& msg_hdlr) {
     auto self { shared_from_this() };
@@ -207,11 +436,48 @@ private:
     m_socket.async_receive_from(
               asio::mutable_buffer(m_byte_vec.data(), m_byte_vec.size()),
               m_sender_endp,
+              make_custom_alloc_handler(m_handler_mem,
                 [this, self, mh = std::move(msg_hdlr)] 
                   (const std::error_code& err, std::size_t nb) mutable {
         handle_read(err, nb, mh);
       }
-    );
+    ));
+  }
+
+  bool post_drain_sends(io_common<udp_entity_io>::push_result res) {
+    if (res != io_common<udp_entity_io>::push_result::post_drain) {
+      return res != io_common<udp_entity_io>::push_result::rejected; // drain already posted
+    }
+    auto self { shared_from_this() };
+    post_custom_alloc_handler(m_socket.get_executor(), m_handler_mem, 
+                              [this, self] { drain_sends(); } );
+    return true;
+  }
+
+  void drain_sends() {
+    auto elem = m_io_common.drain_sends();
+    if (notify_output_queue_event()) {
+      return; // output queue overflow, entity stopped
+    }
+    if (!elem) {
+      return; // bufs queued or shutdown happening
+    }
+    start_write(elem->first, elem->second ? *(elem->second) : m_default_dest_endp);
+  }
+
+  // water mark notifications are informational, an overflow (with the close policy)
+  // stops the entity
+  bool notify_output_queue_event() {
+    auto err = m_io_common.output_queue_event();
+    if (!err) {
+      return false;
+    }
+    err_notify(err);
+    if (err == std::make_error_code(net_ip_errc::output_queue_overflow)) {
+      stop();
+      return true;
+    }
+    return false;
   }
 
   void err_notify (const std::error_code& err) {
@@ -225,6 +491,31 @@ private:
 
   void handle_write(const std::error_code&, std::size_t);
 
+#ifdef CHOPS_NET_UDP_MMSG
+
+  void setup_read_batch(std::size_t);
+
+  template <typename MH>
+  void start_read_batch(MH&& msg_hdlr) {
+    auto self { shared_from_this() };
+    m_socket.async_wait(socket_type::wait_read, make_custom_alloc_handler(m_handler_mem,
+                [this, self, mh = std::move(msg_hdlr)] (const std::error_code& err) mutable {
+        handle_read_batch(err, mh);
+      }
+    ));
+  }
+
+  template <typename MH>
+  void handle_read_batch(const std::error_code&, MH&&);
+
+  void setup_write_batch();
+
+  void start_write_batch();
+
+  void handle_write_batch(const std::error_code&);
+
+#endif
+
 };
 
 // method implementations, just to make the class declaration a little more readable
@@ -237,8 +528,16 @@ void udp_entity_io::handle_read(const std::error_code& err, std::size_t num_byte
     stop();
     return;
   }
-  if (!msg_hdlr(asio::const_buffer(m_byte_vec.data(), num_bytes), 
-                basic_io_interface<udp_entity_io>(weak_from_this()), m_sender_endp)) {
+  bool ret;
+  using io_intf = basic_io_interface<udp_entity_io>;
+  if constexpr (is_pooled_msg_handler<MH, io_intf, endpoint_type>) {
+    ret = msg_hdlr(acquire_pooled(num_bytes), io_intf(weak_from_this()), m_sender_endp);
+  }
+  else {
+    ret = msg_hdlr(asio::const_buffer(m_byte_vec.data(), num_bytes), 
+                   io_intf(weak_from_this()), m_sender_endp);
+  }
+  if (!ret) {
     // message handler not happy, tear everything down
     err_notify(std::make_error_code(net_ip_errc::message_handler_terminated));
     stop();
@@ -247,13 +546,15 @@ void udp_entity_io::handle_read(const std::error_code& err, std::size_t num_byte
   start_read(std::forward<MH>(msg_hdlr));
 }
 
+// the handler keeps the buf alive until the send completes
 inline void udp_entity_io::start_write(chops::const_shared_buffer buf, const endpoint_type& endp) {
   auto self { shared_from_this() };
   m_socket.async_send_to(asio::const_buffer(buf.data(), buf.size()), endp,
-            [this, self] (const std::error_code& err, std::size_t nb) {
+            make_custom_alloc_handler(m_handler_mem, 
+                [this, self, buf] (const std::error_code& err, std::size_t nb) {
       handle_write(err, nb);
     }
-  );
+  ));
 }
 
 inline void udp_entity_io::handle_write(const std::error_code& err, std::size_t /* num_bytes */) {
@@ -262,13 +563,145 @@ inline void udp_entity_io::handle_write(const std::error_code& err, std::size_t
     stop();
     return;
   }
+  m_io_common.write_completed();
+#ifdef CHOPS_NET_UDP_MMSG
+  if (batch_size() > 1u) {
+    auto cnt = m_io_common.get_next_elements(m_wr_elems, batch_size());
+    notify_output_queue_event();
+    if (cnt == 0u) {
+      return;
+    }
+    setup_write_batch();
+    start_write_batch();
+    return;
+  }
+#endif
   auto elem = m_io_common.get_next_element();
+  notify_output_queue_event();
   if (!elem) {
     return;
   }
   start_write(elem->first, elem->second ? *(elem->second) : m_default_dest_endp);
 }
 
+#ifdef CHOPS_NET_UDP_MMSG
+
+// all slots share one contiguous buffer, the sender endpoints are used directly as 
+// socket address storage
+inline void udp_entity_io::setup_read_batch(std::size_t batch) {
+  m_byte_vec.resize(batch * m_max_size);
+  m_rd_msgs.assign(batch, mmsghdr { });
+  m_rd_iovs.resize(batch);
+  m_rd_endps.assign(batch, endpoint_type());
+  for (std::size_t i = 0u; i < batch; ++i) {
+    m_rd_iovs[i].iov_base = m_byte_vec.data() + i * m_max_size;
+    m_rd_iovs[i].iov_len = m_max_size;
+    m_rd_msgs[i].msg_hdr.msg_iov = &m_rd_iovs[i];
+    m_rd_msgs[i].msg_hdr.msg_iovlen = 1;
+    m_rd_msgs[i].msg_hdr.msg_name = m_rd_endps[i].data();
+  }
+}
+
+template <typename MH>
+void udp_entity_io::handle_read_batch(const std::error_code& err, MH&& msg_hdlr) {
+
+  if (err) {
+    err_notify(err);
+    stop();
+    return;
+  }
+  for (std::size_t i = 0u; i < m_rd_msgs.size(); ++i) {
+    m_rd_msgs[i].msg_hdr.msg_namelen = static_cast<socklen_t>(m_rd_endps[i].capacity());
+  }
+  int num = ::recvmmsg(m_socket.native_handle(), m_rd_msgs.data(), 
+                       static_cast<unsigned int>(m_rd_msgs.size()), MSG_DONTWAIT, nullptr);
+  if (num < 0) {
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+      err_notify(std::error_code(errno, std::system_category()));
+      stop();
+      return;
+    }
+    num = 0; // spurious wakeup
+  }
+  // the message handler is invoked once per datagram
+  for (int i = 0; i < num && m_io_common.is_io_started(); ++i) {
+    m_rd_endps[i].resize(m_rd_msgs[i].msg_hdr.msg_namelen);
+    bool ret;
+    using io_intf = basic_io_interface<udp_entity_io>;
+    if constexpr (is_pooled_msg_handler<MH, io_intf, endpoint_type>) {
+      // the slots share one buffer, so each datagram is copied into a pooled buffer
+      ret = msg_hdlr(recv_pool().acquire(static_cast<const std::byte*>(m_rd_iovs[i].iov_base), 
+                                         m_rd_msgs[i].msg_len),
+                     io_intf(weak_from_this()), m_rd_endps[i]);
+    }
+    else {
+      ret = msg_hdlr(asio::const_buffer(m_rd_iovs[i].iov_base, m_rd_msgs[i].msg_len), 
+                     io_intf(weak_from_this()), m_rd_endps[i]);
+    }
+    if (!ret) {
+      // message handler not happy, tear everything down
+      err_notify(std::make_error_code(net_ip_errc::message_handler_terminated));
+      stop();
+      return;
+    }
+  }
+  start_read_batch(std::forward<MH>(msg_hdlr));
+}
+
+inline void udp_entity_io::setup_write_batch() {
+  auto num = m_wr_elems.size();
+  m_wr_msgs.assign(num, mmsghdr { });
+  m_wr_iovs.resize(num);
+  m_wr_endps.resize(num);
+  for (std::size_t i = 0u; i < num; ++i) {
+    auto& buf = m_wr_elems[i].first;
+    m_wr_endps[i] = m_wr_elems[i].second ? *(m_wr_elems[i].second) : m_default_dest_endp;
+    m_wr_iovs[i].iov_base = const_cast<std::byte*>(buf.data());
+    m_wr_iovs[i].iov_len = buf.size();
+    m_wr_msgs[i].msg_hdr.msg_iov = &m_wr_iovs[i];
+    m_wr_msgs[i].msg_hdr.msg_iovlen = 1;
+    m_wr_msgs[i].msg_hdr.msg_name = m_wr_endps[i].data();
+    m_wr_msgs[i].msg_hdr.msg_namelen = static_cast<socklen_t>(m_wr_endps[i].size());
+  }
+  m_wr_idx = 0u;
+}
+
+inline void udp_entity_io::start_write_batch() {
+  auto self { shared_from_this() };
+  m_socket.async_wait(socket_type::wait_write, make_custom_alloc_handler(m_handler_mem,
+            [this, self] (const std::error_code& err) {
+      handle_write_batch(err);
+    }
+  ));
+}
+
+inline void udp_entity_io::handle_write_batch(const std::error_code& err) {
+  if (err) {
+    m_wr_elems.clear();
+    handle_write(err, 0u);
+    return;
+  }
+  int num = ::sendmmsg(m_socket.native_handle(), m_wr_msgs.data() + m_wr_idx,
+                       static_cast<unsigned int>(m_wr_msgs.size() - m_wr_idx), MSG_DONTWAIT);
+  if (num < 0) {
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+      m_wr_elems.clear();
+      handle_write(std::error_code(errno, std::system_category()), 0u);
+      return;
+    }
+    num = 0;
+  }
+  m_wr_idx += static_cast<std::size_t>(num);
+  if (m_wr_idx < m_wr_msgs.size()) { // socket send buffer full, wait and send the rest
+    start_write_batch();
+    return;
+  }
+  m_wr_elems.clear(); // release the bufs
+  handle_write(std::error_code(), 0u);
+}
+
+#endif
+
 using udp_entity_io_ptr = std::shared_ptr<udp_entity_io>;
 
 } // end detail namespace
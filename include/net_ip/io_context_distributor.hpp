@@ -0,0 +1,50 @@
+/** @file
+ *
+ *  @ingroup net_ip_module
+ *
+ *  @brief Function objects used by a TCP acceptor to distribute accepted connections
+ *  across multiple @c io_context objects.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef IO_CONTEXT_DISTRIBUTOR_HPP_INCLUDED
+#define IO_CONTEXT_DISTRIBUTOR_HPP_INCLUDED
+
+#include <functional> // std::function
+
+#include "asio/io_context.hpp"
+
+namespace chops {
+namespace net {
+
+/**
+ *  @brief An @c io_context_distributor selects the @c io_context for each accepted
+ *  TCP connection, and is told when the connection is closed.
+ *
+ *  The @c acquire function object is called before each accept, and the accepted
+ *  socket (and all of its reads and writes) is associated with the returned
+ *  @c io_context. The @c release function object is called with the same @c io_context
+ *  when the connection is closed (or the accept fails), allowing load to be tracked
+ *  (an @c io_context is acquired for the pending accept, so the load includes it).
+ *  Both function objects may be called from multiple threads.
+ *
+ *  The @c worker_pool component provides round-robin and least-loaded distributors.
+ */
+struct io_context_distributor {
+
+  std::function<asio::io_context& ()>       acquire;
+  std::function<void (asio::io_context&)>   release;
+};
+
+} // end net namespace
+} // end chops namespace
+
+#endif
+
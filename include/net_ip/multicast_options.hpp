@@ -0,0 +1,53 @@
+/** @file
+ *
+ *  @ingroup net_ip_module
+ *
+ *  @brief Configuration for UDP multicast receivers and senders.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef MULTICAST_OPTIONS_HPP_INCLUDED
+#define MULTICAST_OPTIONS_HPP_INCLUDED
+
+#include "asio/ip/address.hpp"
+
+namespace chops {
+namespace net {
+
+/**
+ *  @brief @c multicast_options specify the multicast group, interface and socket
+ *  options applied when a UDP multicast @c net_entity is started.
+ *
+ *  For a receiver the group is joined, for a sender the group (and port) is the
+ *  default destination. The IP version of the socket is determined by the group
+ *  address.
+ *
+ *  If a source address is specified, a source-specific multicast (SSM) join is
+ *  performed, and only datagrams from that source are received.
+ *
+ *  The interface is specified by address for IPv4 and by index for IPv6 (an
+ *  unspecified address or a 0 index means the system default interface), and is
+ *  used both for the join and for outbound multicast datagrams.
+ */
+struct multicast_options {
+
+  asio::ip::address group;
+  asio::ip::address source; // unspecified means any source
+  asio::ip::address interface_addr; // IPv4 interface, unspecified means default
+  unsigned int      interface_index = 0; // IPv6 interface, 0 means default
+  int               ttl = 1; // time to live (hop limit) of sent datagrams
+  bool              loopback = true; // sent datagrams are received on the local host
+};
+
+} // end net namespace
+} // end chops namespace
+
+#endif
+
@@ -34,6 +34,9 @@
 #include "net_ip/net_ip_error.hpp"
 #include "net_ip/net_entity.hpp"
 #include "net_ip/endpoints_resolver.hpp"
+#include "net_ip/multicast_options.hpp"
+#include "net_ip/reconnect_policy.hpp"
+#include "net_ip/io_context_distributor.hpp"
 
 #include "net_ip/detail/tcp_connector.hpp"
 #include "net_ip/detail/tcp_acceptor.hpp"
@@ -202,6 +205,37 @@ public:
     return tcp_acceptor_net_entity(p);
   }
 
+/**
+ *  @brief Create a TCP acceptor @c net_entity that distributes accepted connections
+ *  across multiple @c io_context objects.
+ *
+ *  Accepts are performed in the @c io_context of this @c net_ip object, while each 
+ *  accepted connection is associated with the @c io_context returned from the 
+ *  distributor (e.g. from a @c worker_pool, round-robin or least-loaded). The reads, 
+ *  writes, and IO state change callback of a connection are all performed in the 
+ *  thread running its @c io_context, so the callbacks may be invoked concurrently for
+ *  different connections.
+ *
+ *  @param endp A @c asio::ip::tcp::endpoint that the acceptor uses for the local
+ *  bind (when @c start is called).
+ *
+ *  @param distributor Function objects selecting the @c io_context for each connection.
+ *
+ *  @param reuse_addr If @c true (default), the @c reuse_address socket option is set upon 
+ *  socket open.
+ *
+ *  @return @c tcp_acceptor_net_entity object.
+ *
+ */
+  tcp_acceptor_net_entity make_tcp_acceptor (const asio::ip::tcp::endpoint& endp,
+                                             const io_context_distributor& distributor,
+                                             bool reuse_addr = true) {
+    auto p = std::make_shared<detail::tcp_acceptor>(m_ioc, endp, reuse_addr, distributor);
+    lg g(m_mutex);
+    m_acceptors.push_back(p);
+    return tcp_acceptor_net_entity(p);
+  }
+
 /**
  *  @brief Create a TCP connector @c net_entity, which will perform an active TCP
  *  connect to the specified host and port (once started).
@@ -234,9 +268,34 @@ public:
                                                std::string_view remote_host,
                                                std::chrono::milliseconds reconn_time = 
                                                  std::chrono::milliseconds { } ) {
+    return make_tcp_connector(remote_port_or_service, remote_host, 
+                              reconnect_policy { reconn_time });
+  }
+
+/**
+ *  @brief Create a TCP connector @c net_entity with a reconnect policy, which will perform 
+ *  an active TCP connect to the specified host and port (once started).
+ *
+ *  The reconnect policy provides exponential backoff (with optional jitter) between
+ *  connect attempts, a maximum number of reconnect attempts, and a timeout for each
+ *  connect attempt. See @c reconnect_policy for details. Otherwise this is the same as
+ *  the @c make_tcp_connector method taking a reconnect time.
+ *
+ *  @param remote_port_or_service Port number or service name on remote host.
+ *
+ *  @param remote_host Remote host name or IP address.
+ *
+ *  @param policy Reconnect and connect timeout policy.
+ *
+ *  @return @c tcp_connector_net_entity object.
+ *
+ */
+  tcp_connector_net_entity make_tcp_connector (std::string_view remote_port_or_service,
+                                               std::string_view remote_host,
+                                               const reconnect_policy& policy) {
 
     auto p = std::make_shared<detail::tcp_connector>(m_ioc, remote_port_or_service, 
-                                                                  remote_host, reconn_time);
+                                                                  remote_host, policy);
 //    asio::post(m_ioc.get_executor(), [p, this] () { m_connectors.push_back(p); } );
     lg g(m_mutex);
     m_connectors.push_back(p);
@@ -253,6 +312,14 @@ public:
                               reconn_time);
   }
 
+  tcp_connector_net_entity make_tcp_connector (const char* remote_port_or_service,
+                                               const char* remote_host,
+                                               const reconnect_policy& policy) {
+    return make_tcp_connector(std::string_view(remote_port_or_service),
+                              std::string_view(remote_host),
+                              policy);
+  }
+
 /**
  *  @brief Create a TCP connector @c net_entity, using an already created sequence of 
  *  endpoints.
@@ -274,7 +341,27 @@ public:
   tcp_connector_net_entity make_tcp_connector (Iter beg, Iter end,
                                                std::chrono::milliseconds reconn_time = 
                                                  std::chrono::milliseconds { } ) {
-    auto p = std::make_shared<detail::tcp_connector>(m_ioc, beg, end, reconn_time);
+    return make_tcp_connector(beg, end, reconnect_policy { reconn_time });
+  }
+
+/**
+ *  @brief Create a TCP connector @c net_entity with a reconnect policy, using an already 
+ *  created sequence of endpoints.
+ *
+ *  @param beg A begin iterator to a sequence of remote @c asio::ip::tcp::endpoint
+ *  objects.
+ *
+ *  @param end An end iterator to the sequence of endpoints.
+ *
+ *  @param policy Reconnect and connect timeout policy, see @c reconnect_policy.
+ *
+ *  @return @c tcp_connector_net_entity object.
+ *
+ */
+  template <typename Iter>
+  tcp_connector_net_entity make_tcp_connector (Iter beg, Iter end,
+                                               const reconnect_policy& policy) {
+    auto p = std::make_shared<detail::tcp_connector>(m_ioc, beg, end, policy);
 //    asio::post(m_ioc.get_executor(), [p, this] () { m_connectors.push_back(p); } );
     lg g(m_mutex);
     m_connectors.push_back(p);
@@ -300,6 +387,24 @@ public:
     return make_tcp_connector(vec.cbegin(), vec.cend(), reconn_time);
   }
 
+/**
+ *  @brief Create a TCP connector @c net_entity with a reconnect policy, using a single 
+ *  remote endpoint.
+ *
+ *  @param endp Remote @c asio::ip::tcp::endpoint to use for the connect
+ *  attempt.
+ *
+ *  @param policy Reconnect and connect timeout policy, see @c reconnect_policy.
+ *
+ *  @return @c tcp_connector_net_entity object.
+ *
+ */
+  tcp_connector_net_entity make_tcp_connector (const asio::ip::tcp::endpoint& endp, 
+                                               const reconnect_policy& policy) {
+    std::vector<asio::ip::tcp::endpoint> vec { endp };
+    return make_tcp_connector(vec.cbegin(), vec.cend(), policy);
+  }
+
 /**
  *  @brief Create a UDP unicast @c net_entity that allows receiving as well as sending.
  *
@@ -365,7 +470,79 @@ public:
     return make_udp_unicast(asio::ip::udp::endpoint());
   }
 
-// TODO: multicast make methods 
+/**
+ *  @brief Create a UDP multicast receiver @c net_entity, which joins the multicast group 
+ *  when started.
+ *
+ *  The local bind is to the "any address" (of the same IP version as the group) and the 
+ *  given port, with the socket reuse flag set so that multiple receivers on a host can
+ *  share the port. The group is joined on the interface specified in the 
+ *  @c multicast_options, and if a source address is specified the join is
+ *  source-specific (SSM). Additional groups can be joined or left through the 
+ *  @c net_entity @c join_multicast_group and @c leave_multicast_group methods.
+ *
+ *  A multicast receiver can also send, which requires a destination endpoint in each
+ *  send (or in the @c io_interface @c start_io method call).
+ *
+ *  @param local_port_or_service Port number or service name for local binding.
+ *
+ *  @param opts Multicast group, interface, and socket options.
+ *
+ *  @return @c udp_net_entity object.
+ *
+ *  @throw @c std::system_error if there is a name lookup failure.
+ *
+ */
+  udp_net_entity make_udp_multicast_receiver (std::string_view local_port_or_service,
+                                              const multicast_options& opts) {
+    auto port = resolve_udp_port(local_port_or_service);
+    auto any = opts.group.is_v6() ? asio::ip::address(asio::ip::address_v6::any()) :
+                                    asio::ip::address(asio::ip::address_v4::any());
+    return make_udp_multicast(asio::ip::udp::endpoint(any, port), opts, asio::ip::udp::endpoint());
+  }
+
+/**
+ *  @brief Create a UDP multicast sender @c net_entity (no local bind is performed).
+ *
+ *  The multicast group and port are the default destination for sends, so the
+ *  @c io_interface @c send methods without an endpoint send to the group. The 
+ *  "time to live", loopback, and outbound interface are set from the
+ *  @c multicast_options when started.
+ *
+ *  @param dest_port_or_service Port number or service name of the multicast group.
+ *
+ *  @param opts Multicast group, interface, and socket options.
+ *
+ *  @return @c udp_net_entity object.
+ *
+ *  @throw @c std::system_error if there is a name lookup failure.
+ *
+ */
+  udp_net_entity make_udp_multicast_sender (std::string_view dest_port_or_service,
+                                            const multicast_options& opts) {
+    auto port = resolve_udp_port(dest_port_or_service);
+    return make_udp_multicast(asio::ip::udp::endpoint(), opts, 
+                              asio::ip::udp::endpoint(opts.group, port));
+  }
+
+private:
+
+  unsigned short resolve_udp_port (std::string_view port_or_service) {
+    endpoints_resolver<asio::ip::udp> resolver(m_ioc);
+    auto results = resolver.make_endpoints(true, "", port_or_service);
+    return results.cbegin()->endpoint().port();
+  }
+
+  udp_net_entity make_udp_multicast (const asio::ip::udp::endpoint& local_endp,
+                                     const multicast_options& opts,
+                                     const asio::ip::udp::endpoint& dest_endp) {
+    auto p = std::make_shared<detail::udp_entity_io>(m_ioc, local_endp, opts, dest_endp);
+    asio::post(m_ioc.get_executor(), [p, this] () { m_udp_entities.push_back(p); } );
+    return udp_net_entity(p);
+  }
+
+public:
+
 
 /**
  *  @brief Remove a TCP acceptor @c net_entity from the internal list of TCP 
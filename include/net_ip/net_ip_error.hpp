@@ -35,6 +35,9 @@ enum class net_ip_errc {
   tcp_acceptor_stopped = 5,
   tcp_connector_stopped = 6,
   udp_entity_stopped = 7,
+  output_queue_overflow = 8,
+  output_queue_high_water_mark = 9,
+  output_queue_low_water_mark = 10,
 };
 
 namespace detail {
@@ -59,6 +62,12 @@ struct net_ip_err_category : public std::error_category {
       return "tcp connector stopped";
     case net_ip_errc::udp_entity_stopped:
       return "udp entity stopped";
+    case net_ip_errc::output_queue_overflow:
+      return "output queue overflow";
+    case net_ip_errc::output_queue_high_water_mark:
+      return "output queue high water mark";
+    case net_ip_errc::output_queue_low_water_mark:
+      return "output queue low water mark";
     }
     return "(unknown error)";
   }
@@ -88,7 +97,14 @@ inline error_code make_error_code(chops::net::net_ip_errc e) noexcept {
 namespace chops {
 namespace net {
 
-
+/**
+ *  @brief Return @c true if the error code is an output queue water mark notification,
+ *  which does not affect the connection.
+ */
+inline bool is_output_queue_water_mark(const std::error_code& err) noexcept {
+  return err == std::make_error_code(net_ip_errc::output_queue_high_water_mark) || 
+         err == std::make_error_code(net_ip_errc::output_queue_low_water_mark);
+}
 
 /**
  *  @brief General @c net_ip exception class.
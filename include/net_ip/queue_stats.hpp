@@ -17,23 +17,183 @@
 #define QUEUE_STATS_HPP_INCLUDED
 
 #include <cstddef> // std::size_t 
+#include <cstdint> // std::uint64_t
+#include <array>
+#include <functional> // std::function
+
+#include "marshall/shared_buffer.hpp"
 
 namespace chops {
 namespace net {
 
+/**
+ *  @brief Histogram of the time buffers spend in an output queue, in nanoseconds.
+ *
+ *  The bucket layout follows HDR histograms: values below 4 have their own bucket, 
+ *  then every power of 2 range is divided into 4 linear sub-buckets, so any value is
+ *  recorded with a relative error of at most 25%. Values up to about 18 minutes
+ *  (2^40 nanoseconds) are distinguished, larger values are counted in the last bucket.
+ */
+struct queue_dwell_histogram {
+
+  static constexpr std::size_t sub_bucket_bits = 2u;
+  static constexpr std::size_t sub_buckets = 1u << sub_bucket_bits;
+  static constexpr std::size_t max_value_bits = 40u;
+  static constexpr std::size_t num_buckets = 
+      sub_buckets + (max_value_bits - sub_bucket_bits) * sub_buckets;
+
+  std::array<std::size_t, num_buckets> counts { };
+
+  static constexpr std::size_t bucket_index(std::uint64_t ns) noexcept {
+    if (ns < sub_buckets) {
+      return static_cast<std::size_t>(ns);
+    }
+    std::size_t msb = 0u;
+    for (auto v = ns; v > 1u; v >>= 1u) {
+      ++msb;
+    }
+    if (msb >= max_value_bits) {
+      return num_buckets - 1u;
+    }
+    std::size_t shift = msb - sub_bucket_bits;
+    return sub_buckets + shift * sub_buckets + 
+           static_cast<std::size_t>((ns >> shift) & (sub_buckets - 1u));
+  }
+
+  // lowest value recorded in a bucket
+  static constexpr std::uint64_t bucket_lower_bound(std::size_t idx) noexcept {
+    if (idx < sub_buckets) {
+      return idx;
+    }
+    std::size_t shift = (idx - sub_buckets) / sub_buckets;
+    std::uint64_t sub = (idx - sub_buckets) % sub_buckets;
+    return (sub_buckets + sub) << shift;
+  }
+
+  std::size_t total_count() const noexcept {
+    std::size_t tot = 0u;
+    for (auto c : counts) {
+      tot += c;
+    }
+    return tot;
+  }
+
+  // upper bound (exclusive) of the bucket containing the given percentile (0.0 
+  // to 100.0), or 0 if there are no values recorded
+  std::uint64_t value_at_percentile(double pct) const noexcept {
+    auto tot = total_count();
+    if (tot == 0u) {
+      return 0u;
+    }
+    auto target = static_cast<std::size_t>((pct / 100.0) * static_cast<double>(tot) + 0.5);
+    std::size_t sum = 0u;
+    for (std::size_t i = 0u; i < num_buckets; ++i) {
+      sum += counts[i];
+      if (sum >= target && sum != 0u) {
+        return bucket_lower_bound(i + 1u);
+      }
+    }
+    return bucket_lower_bound(num_buckets);
+  }
+};
+
+/**
+ *  @brief Number of priority lanes in an output queue.
+ *
+ *  A buffer sent with a priority is queued in the lane for that priority, from 0 
+ *  (the default, lowest) to @c num_send_priorities @c - @c 1 (highest). Queued 
+ *  buffers are always written from the highest priority non-empty lane, and are 
+ *  in send order within a lane, so a control or heartbeat message does not wait 
+ *  behind a bulk transfer.
+ */
+inline constexpr std::size_t num_send_priorities = 4u;
+
 /**
  *  @brief @c output_queue_stats provides information on the internal output 
  *  queue.
+ *
+ *  The write batch values are the limits used when the IO handler gathers multiple
+ *  queued buffers into a single write (TCP only). A buffer limit of 1 means that
+ *  each buffer is written individually, and a byte limit of 0 means there is no 
+ *  byte limit on a batch.
+ *
+ *  The cumulative counts include every buffer whose write has completed, whether it
+ *  waited in the queue or was written immediately. The dwell time histogram records
+ *  the time from a @c send call until the write of the buffer completes; for a
+ *  gathered TCP write or a batched UDP send, every buffer in the write is recorded
+ *  when the whole write completes. The counters are updated with relaxed atomic 
+ *  operations by the IO handler thread, so they are cheap to leave enabled.
+ *
+ *  The lane values break down the queue size and bytes by send priority (the
+ *  lane index is the priority).
  */
 
 struct output_queue_stats {
 
   std::size_t output_queue_size = 0;
   std::size_t bytes_in_output_queue = 0;
-  // std::size_t total_bufs_sent;
-  // std::size_t total_bytes_sent;
+  std::size_t max_write_batch_bufs = 1;
+  std::size_t max_write_batch_bytes = 0;
+  std::size_t bufs_dropped = 0; // rejected or dropped due to output queue limits
+  std::size_t total_bufs_sent = 0;
+  std::size_t total_bytes_sent = 0;
+  std::size_t peak_output_queue_size = 0;
+  queue_dwell_histogram dwell_time_ns { };
+  std::array<std::size_t, num_send_priorities> lane_queue_size { };
+  std::array<std::size_t, num_send_priorities> lane_bytes_in_queue { };
 };
 
+/**
+ *  @brief Policy applied when a buffer is sent while the output queue is at one of
+ *  its limits.
+ *
+ *  @c reject causes @c send to return @c false (the check is made by the sending
+ *  thread, so it is approximate when multiple threads are sending). @c drop_oldest
+ *  discards queued buffers from the front of the queue to make room, @c drop_newest
+ *  discards the buffer being sent, and @c close closes the connection (or stops the
+ *  UDP entity), reporting an @c output_queue_overflow error.
+ */
+enum class queue_overflow_policy {
+  reject,
+  drop_oldest,
+  drop_newest,
+  close
+};
+
+/**
+ *  @brief @c output_queue_limits bound the internal output queue and define the 
+ *  backpressure water marks.
+ *
+ *  A limit of 0 means no limit. Limits apply to buffers waiting in the queue, not to
+ *  a buffer currently being written.
+ *
+ *  When the bytes in the output queue reach the high water mark an 
+ *  @c output_queue_high_water_mark error code is delivered to the net entity error 
+ *  callback, and when they later fall to the low water mark an 
+ *  @c output_queue_low_water_mark error code is delivered. These are notifications 
+ *  only, the connection is not affected. A high water mark of 0 disables the 
+ *  notifications.
+ */
+struct output_queue_limits {
+
+  std::size_t max_bufs = 0;
+  std::size_t max_bytes = 0;
+  queue_overflow_policy policy = queue_overflow_policy::reject;
+  std::size_t high_water_mark = 0; // in bytes
+  std::size_t low_water_mark = 0; // in bytes
+};
+
+/**
+ *  @brief Function object type returning the conflation key of a buffer (e.g. a symbol 
+ *  or instrument id), used by a conflating output queue.
+ *
+ *  When a buffer is sent and an unsent buffer with the same key is already in the 
+ *  output queue, the queued buffer is replaced in place by the new one, so the queue 
+ *  holds at most one buffer per key and a slow consumer only receives the latest
+ *  update for each key. Replaced buffers are counted as dropped.
+ */
+using output_queue_key_func = std::function<std::size_t (const chops::const_shared_buffer&)>;
+
 } // end net namespace
 } // end chops namespace
 
@@ -0,0 +1,63 @@
+/** @file
+ *
+ *  @ingroup net_ip_module
+ *
+ *  @brief Reconnect and connect timeout configuration for TCP connectors.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef RECONNECT_POLICY_HPP_INCLUDED
+#define RECONNECT_POLICY_HPP_INCLUDED
+
+#include <cstddef> // std::size_t
+#include <chrono>
+
+namespace chops {
+namespace net {
+
+/**
+ *  @brief @c reconnect_policy controls the wait between the connect attempts of a TCP
+ *  connector, and the time allowed for each attempt.
+ *
+ *  An @c initial_interval of 0 means no reconnects are attempted. After each failed
+ *  attempt the interval is multiplied by @c multiplier, up to @c max_interval. A
+ *  @c max_interval less than the initial interval (including the default of 0) keeps
+ *  the interval fixed at the initial interval, which is the behavior of a plain
+ *  reconnect time.
+ *
+ *  With @c jitter each interval is a random value between the initial interval and
+ *  @c multiplier times the previous interval (capped at @c max_interval), known as
+ *  decorrelated jitter. This spreads out the reconnects of many connectors that lost
+ *  their connections at the same time (e.g. a server restart).
+ *
+ *  A @c connect_timeout of 0 means each attempt takes as long as the OS allows, otherwise
+ *  an attempt (over all of the remote endpoints) that is not complete within the timeout
+ *  is abandoned with a @c timed_out error. A @c max_attempts of 0 means reconnects
+ *  continue until a connect succeeds or the connector is stopped, otherwise the
+ *  connector stops after that many reconnect attempts have failed.
+ *
+ *  The interval and attempt count are reset when a connect succeeds or the connector
+ *  is started.
+ */
+struct reconnect_policy {
+
+  std::chrono::milliseconds initial_interval { };
+  std::chrono::milliseconds max_interval { };
+  double multiplier = 2.0;
+  bool jitter = false;
+  std::chrono::milliseconds connect_timeout { };
+  std::size_t max_attempts = 0; // reconnect attempts, not counting the first connect
+};
+
+} // end net namespace
+} // end chops namespace
+
+#endif
+
@@ -0,0 +1,290 @@
+/** @file
+ *
+ *  @ingroup net_ip_module
+ *
+ *  @brief A per @c io_context pool of receive buffers, and the owning, reference
+ *  counted buffer handed to message handlers that take a @c pooled_buffer.
+ *
+ *  A message handler that takes an @c asio::const_buffer is given a view into the
+ *  IO handler's internal buffer, which is only valid during the handler call, so a
+ *  message retained past the handler must be copied into a newly allocated buffer.
+ *  A message handler that takes a @c pooled_buffer instead is given ownership (shared
+ *  by any copies) of a buffer from the @c recv_buffer_pool of the @c io_context. When
+ *  the last copy is destroyed, in any thread, the buffer (and its capacity) returns to
+ *  the pool. Once the pool is warmed up, messages can be handed to other threads
+ *  without copies or allocations.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef RECV_BUFFER_POOL_HPP_INCLUDED
+#define RECV_BUFFER_POOL_HPP_INCLUDED
+
+#include <cstddef> // std::size_t, std::byte
+#include <vector>
+#include <memory> // std::shared_ptr, std::make_shared
+#include <mutex>
+#include <atomic>
+#include <utility> // std::swap
+#include <type_traits> // std::is_invocable_v
+
+#include "asio/execution_context.hpp"
+#include "asio/buffer.hpp"
+
+namespace chops {
+namespace net {
+
+class pooled_buffer;
+class recv_buffer_pool;
+
+namespace detail {
+
+struct buffer_pool_state;
+
+// free buffers beyond this count are deleted when released, rather than pooled
+constexpr std::size_t default_max_free_buffers = 1024u;
+
+struct buffer_pool_node {
+  std::vector<std::byte>              m_bytes;
+  std::atomic_size_t                  m_refs { 0u };
+  std::shared_ptr<buffer_pool_state>  m_pool; // set while handed out, keeps the pool alive
+  buffer_pool_node*                   m_next = nullptr;
+};
+
+// buffers are acquired in the io_context thread, but may be released from any thread
+struct buffer_pool_state {
+  std::mutex          m_mutex;
+  buffer_pool_node*   m_free = nullptr;
+  std::size_t         m_num_free = 0u;
+  std::size_t         m_num_allocated = 0u;
+  std::size_t         m_max_free = default_max_free_buffers;
+
+  buffer_pool_state() = default;
+  buffer_pool_state(const buffer_pool_state&) = delete;
+  buffer_pool_state& operator=(const buffer_pool_state&) = delete;
+
+  ~buffer_pool_state() {
+    while (m_free) {
+      auto next = m_free->m_next;
+      delete m_free;
+      m_free = next;
+    }
+  }
+
+  buffer_pool_node* take() {
+    {
+      std::lock_guard<std::mutex> gd { m_mutex };
+      if (m_free) {
+        auto node = m_free;
+        m_free = node->m_next;
+        --m_num_free;
+        return node;
+      }
+      ++m_num_allocated;
+    }
+    return new buffer_pool_node;
+  }
+
+  void give_back(buffer_pool_node* node) noexcept {
+    {
+      std::lock_guard<std::mutex> gd { m_mutex };
+      if (m_num_free < m_max_free) {
+        node->m_next = m_free;
+        m_free = node;
+        ++m_num_free;
+        return;
+      }
+    }
+    delete node;
+  }
+
+  void set_max_free(std::size_t max_free) {
+    buffer_pool_node* excess = nullptr;
+    {
+      std::lock_guard<std::mutex> gd { m_mutex };
+      m_max_free = max_free;
+      while (m_num_free > m_max_free) {
+        auto node = m_free;
+        m_free = node->m_next;
+        --m_num_free;
+        node->m_next = excess;
+        excess = node;
+      }
+    }
+    while (excess) {
+      auto next = excess->m_next;
+      delete excess;
+      excess = next;
+    }
+  }
+};
+
+// a message handler taking a pooled_buffer (and not an asio::const_buffer) is given
+// an owning buffer
+template <typename MH, typename IOI, typename E>
+inline constexpr bool is_pooled_msg_handler =
+    std::is_invocable_v<MH&, pooled_buffer, IOI, E> &&
+    !std::is_invocable_v<MH&, asio::const_buffer, IOI, E>;
+
+} // end detail namespace
+
+/**
+ *  @brief An owning, reference counted, immutable buffer from a @c recv_buffer_pool.
+ *
+ *  Copies share the same bytes (copying only increments a reference count), and the
+ *  buffer returns to its pool when the last copy is destroyed. Copies can be passed to
+ *  and destroyed in any thread. A default constructed @c pooled_buffer is empty.
+ */
+class pooled_buffer {
+private:
+  detail::buffer_pool_node*  m_node;
+
+  friend class recv_buffer_pool;
+
+  explicit pooled_buffer(detail::buffer_pool_node* node) noexcept : m_node(node) { }
+
+public:
+  pooled_buffer() noexcept : m_node(nullptr) { }
+
+  pooled_buffer(const pooled_buffer& rhs) noexcept : m_node(rhs.m_node) {
+    if (m_node) {
+      m_node->m_refs.fetch_add(1u, std::memory_order_relaxed);
+    }
+  }
+
+  pooled_buffer(pooled_buffer&& rhs) noexcept : m_node(rhs.m_node) { rhs.m_node = nullptr; }
+
+  pooled_buffer& operator=(pooled_buffer rhs) noexcept {
+    std::swap(m_node, rhs.m_node);
+    return *this;
+  }
+
+  ~pooled_buffer() { release(); }
+
+  const std::byte* data() const noexcept { return m_node ? m_node->m_bytes.data() : nullptr; }
+  std::size_t size() const noexcept { return m_node ? m_node->m_bytes.size() : 0u; }
+  bool empty() const noexcept { return size() == 0u; }
+
+/**
+ *  @brief Return the number of copies sharing the buffer, 0 for an empty @c pooled_buffer.
+ */
+  std::size_t use_count() const noexcept {
+    return m_node ? m_node->m_refs.load(std::memory_order_relaxed) : 0u;
+  }
+
+/**
+ *  @brief Release the buffer, leaving this object empty.
+ */
+  void release() noexcept {
+    if (m_node && m_node->m_refs.fetch_sub(1u, std::memory_order_acq_rel) == 1u) {
+      auto pool = std::move(m_node->m_pool); // the pool may be destroyed after give_back
+      pool->give_back(m_node);
+    }
+    m_node = nullptr;
+  }
+};
+
+/**
+ *  @brief A pool of receive buffers, one per @c io_context (implemented as an @c asio
+ *  service), used by the IO handlers for message handlers that take a @c pooled_buffer.
+ *
+ *  Retrieve the pool of an @c io_context with @c asio::use_service<recv_buffer_pool>.
+ *  A free buffer keeps its capacity, so after the pool is warmed up acquiring a buffer
+ *  does not allocate. At most @c max_free buffers are kept in the pool, a buffer released
+ *  when the pool is full is freed. Buffers that are still in use when the @c io_context
+ *  is destroyed are freed when released.
+ */
+class recv_buffer_pool : public asio::execution_context::service {
+private:
+  std::shared_ptr<detail::buffer_pool_state>  m_state;
+
+public:
+  using key_type = recv_buffer_pool;
+
+  inline static asio::execution_context::id id;
+
+  explicit recv_buffer_pool(asio::execution_context& ctx) :
+    asio::execution_context::service(ctx),
+    m_state(std::make_shared<detail::buffer_pool_state>()) { }
+
+/**
+ *  @brief Acquire a buffer from the pool, containing a copy of the bytes.
+ */
+  pooled_buffer acquire(const std::byte* buf, std::size_t sz) {
+    auto node = take();
+    node->m_bytes.assign(buf, buf + sz);
+    return pooled_buffer(node);
+  }
+
+/**
+ *  @brief Acquire a buffer from the pool by swapping in the contents of a byte
+ *  vector, without copying.
+ *
+ *  @param bv Byte vector whose contents become the buffer contents; on return it holds
+ *  the (empty) storage of a recycled buffer.
+ */
+  pooled_buffer acquire(std::vector<std::byte>& bv) {
+    auto node = take();
+    node->m_bytes.swap(bv);
+    bv.clear();
+    return pooled_buffer(node);
+  }
+
+/**
+ *  @brief Return the number of buffers that have been allocated by the pool.
+ */
+  std::size_t num_allocated() const {
+    std::lock_guard<std::mutex> gd { m_state->m_mutex };
+    return m_state->m_num_allocated;
+  }
+
+/**
+ *  @brief Return the number of buffers in the pool that are not in use.
+ */
+  std::size_t num_free() const {
+    std::lock_guard<std::mutex> gd { m_state->m_mutex };
+    return m_state->m_num_free;
+  }
+
+/**
+ *  @brief Return the maximum number of buffers kept in the pool when not in use.
+ */
+  std::size_t max_free() const {
+    std::lock_guard<std::mutex> gd { m_state->m_mutex };
+    return m_state->m_max_free;
+  }
+
+/**
+ *  @brief Set the maximum number of buffers kept in the pool when not in use, freeing
+ *  any free buffers beyond it.
+ *
+ *  @param max_free Maximum number of free buffers, initially 
+ *  @c detail::default_max_free_buffers.
+ */
+  void set_max_free(std::size_t max_free) {
+    m_state->set_max_free(max_free);
+  }
+
+private:
+
+  void shutdown() override { }
+
+  detail::buffer_pool_node* take() {
+    auto node = m_state->take();
+    node->m_pool = m_state;
+    node->m_refs.store(1u, std::memory_order_relaxed);
+    return node;
+  }
+};
+
+} // end net namespace
+} // end chops namespace
+
+#endif
+
@@ -160,6 +160,16 @@ inline bool tcp_start_io (chops::net::tcp_io_interface io, bool reply,
   return io.start_io(delim, tcp_msg_hdlr(reply, cnt));
 }
 
+inline bool tcp_start_io (chops::net::tcp_io_interface io, bool reply, 
+                   std::string_view delim, test_counter& cnt, std::size_t read_ahead_size) {
+  if (delim.empty() && read_ahead_size != 0) {
+    return io.start_io(2, tcp_msg_hdlr(reply, cnt), 
+                       chops::net::make_simple_variable_len_msg_frame(decode_variable_len_msg_hdr),
+                       read_ahead_size);
+  }
+  return tcp_start_io(io, reply, delim, cnt);
+}
+
 constexpr int udp_max_buf_size = 65507;
 
 inline bool udp_start_io (chops::net::udp_io_interface io, bool reply, test_counter& cnt) {
@@ -184,16 +194,34 @@ struct io_handler_mock {
 
   bool is_io_started() const { return started; }
 
+  constexpr static std::size_t conn_id = 77;
+  std::size_t connection_id() const { return conn_id; }
+
   socket_type& get_socket() { return sock; }
 
   chops::net::output_queue_stats get_output_queue_stats() const { 
     return chops::net::output_queue_stats { qs_base, qs_base +1 };
   }
 
+  std::size_t output_queue_size() const { return qs_base; }
+  std::size_t bytes_in_output_queue() const { return qs_base + 1; }
+
+  std::size_t batch_bufs = 1;
+
+  void set_write_batch_limits(std::size_t max_bufs, std::size_t) { batch_bufs = max_bufs; }
+
+  std::size_t datagram_batch = 1;
+
+  void set_datagram_batch_size(std::size_t batch_size) { datagram_batch = batch_size; }
+
   bool send_called = false;
 
-  void send(chops::const_shared_buffer) { send_called = true; }
-  void send(chops::const_shared_buffer, const endpoint_type&) { send_called = true; }
+  bool send(chops::const_shared_buffer) { return send_called = true; }
+  bool send(chops::const_shared_buffer, const endpoint_type&) { return send_called = true; }
+  bool send(chops::const_shared_buffer, std::size_t) { return send_called = true; }
+
+  chops::net::output_queue_limits outq_limits;
+  void set_output_queue_limits(const chops::net::output_queue_limits& lim) { outq_limits = lim; }
 
   bool mf_sio_called = false;
   bool delim_sio_called = false;
@@ -207,6 +235,11 @@ struct io_handler_mock {
     return started ? false : started = true, mf_sio_called = true, true;
   }
 
+  template <typename MH, typename MF>
+  bool start_io(std::size_t, MH&&, MF&&, std::size_t) {
+    return started ? false : started = true, mf_sio_called = true, true;
+  }
+
   template <typename MH>
   bool start_io(std::string_view, MH&&) {
     return started ? false : started = true, delim_sio_called = true, true;
@@ -287,6 +320,18 @@ struct net_entity_mock {
 
   void join_thr() { thr.join(); }
 
+  asio::ip::address mcast_group;
+
+  std::error_code join_multicast_group(const asio::ip::address& group, const asio::ip::address&) {
+    mcast_group = group;
+    return std::error_code();
+  }
+
+  std::error_code leave_multicast_group(const asio::ip::address& group, const asio::ip::address&) {
+    return group == mcast_group ? (mcast_group = asio::ip::address(), std::error_code()) :
+                                  std::make_error_code(std::errc::invalid_argument);
+  }
+
 };
 
 inline void io_state_chg_mock(io_interface_mock, std::size_t, bool) { }
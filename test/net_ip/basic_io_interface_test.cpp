@@ -45,17 +45,25 @@ void basic_io_interface_test_default_constructed() {
         using endp_t = typename IOT::endpoint_type;
 
         REQUIRE_THROWS (io_intf.is_io_started());
+        REQUIRE_THROWS (io_intf.connection_id());
         REQUIRE_THROWS (io_intf.get_socket());
         REQUIRE_THROWS (io_intf.get_output_queue_stats());
+        REQUIRE_THROWS (io_intf.output_queue_size());
+        REQUIRE_THROWS (io_intf.bytes_in_output_queue());
+        REQUIRE_THROWS (io_intf.set_write_batch_limits(8));
+        REQUIRE_THROWS (io_intf.set_datagram_batch_size(8));
+        REQUIRE_THROWS (io_intf.set_output_queue_limits(chops::net::output_queue_limits()));
 
         REQUIRE_THROWS (io_intf.send(nullptr, 0));
         REQUIRE_THROWS (io_intf.send(buf));
+        REQUIRE_THROWS (io_intf.send(buf, 1u));
         REQUIRE_THROWS (io_intf.send(chops::mutable_shared_buffer()));
         REQUIRE_THROWS (io_intf.send(nullptr, 0, endp_t()));
         REQUIRE_THROWS (io_intf.send(buf, endp_t()));
         REQUIRE_THROWS (io_intf.send(chops::mutable_shared_buffer(), endp_t()));
 
         REQUIRE_THROWS (io_intf.start_io(0, [] { }, [] { }));
+        REQUIRE_THROWS (io_intf.start_io(0, [] { }, [] { }, 0));
         REQUIRE_THROWS (io_intf.start_io("testing, hah!", [] { }));
         REQUIRE_THROWS (io_intf.start_io(0, [] { }));
         REQUIRE_THROWS (io_intf.start_io(endp_t(), 0, [] { }));
@@ -83,12 +91,37 @@ void basic_io_interface_test_methods() {
         REQUIRE (io_intf.is_valid());
       }
     }
-    AND_WHEN ("is_io_started or get_output_queue_stats is called") {
+    AND_WHEN ("is_io_started, connection_id or get_output_queue_stats is called") {
       THEN ("correct values are returned") {
         REQUIRE_FALSE (io_intf.is_io_started());
+        REQUIRE (io_intf.connection_id() == chops::test::io_handler_mock::conn_id);
         chops::net::output_queue_stats s = io_intf.get_output_queue_stats();
         REQUIRE (s.output_queue_size == chops::test::io_handler_mock::qs_base);
         REQUIRE (s.bytes_in_output_queue == (chops::test::io_handler_mock::qs_base + 1));
+        REQUIRE (io_intf.output_queue_size() == chops::test::io_handler_mock::qs_base);
+        REQUIRE (io_intf.bytes_in_output_queue() == (chops::test::io_handler_mock::qs_base + 1));
+      }
+    }
+    AND_WHEN ("set_write_batch_limits is called") {
+      io_intf.set_write_batch_limits(16, 4096);
+      THEN ("the limits are passed through to the io handler") {
+        REQUIRE (ioh->batch_bufs == 16);
+      }
+    }
+    AND_WHEN ("set_datagram_batch_size is called") {
+      io_intf.set_datagram_batch_size(32);
+      THEN ("the batch size is passed through to the io handler") {
+        REQUIRE (ioh->datagram_batch == 32);
+      }
+    }
+    AND_WHEN ("set_output_queue_limits is called") {
+      chops::net::output_queue_limits lim;
+      lim.max_bufs = 100;
+      lim.policy = chops::net::queue_overflow_policy::drop_oldest;
+      io_intf.set_output_queue_limits(lim);
+      THEN ("the limits are passed through to the io handler") {
+        REQUIRE (ioh->outq_limits.max_bufs == 100);
+        REQUIRE (ioh->outq_limits.policy == chops::net::queue_overflow_policy::drop_oldest);
       }
     }
     AND_WHEN ("send or start_io or stop_io is called") {
@@ -101,6 +134,7 @@ void basic_io_interface_test_methods() {
 
         io_intf.send(nullptr, 0);
         io_intf.send(buf);
+        io_intf.send(buf, 1u);
         io_intf.send(chops::mutable_shared_buffer());
         io_intf.send(nullptr, 0, endp_t());
         io_intf.send(buf, endp_t());
@@ -110,6 +144,9 @@ void basic_io_interface_test_methods() {
         REQUIRE (io_intf.start_io(0, [] { }, [] { }));
         REQUIRE (io_intf.is_io_started());
         REQUIRE (io_intf.stop_io());
+        REQUIRE (io_intf.start_io(0, [] { }, [] { }, 0));
+        REQUIRE (io_intf.is_io_started());
+        REQUIRE (io_intf.stop_io());
         REQUIRE_FALSE (io_intf.is_io_started());
         REQUIRE (io_intf.start_io("testing, hah!", [] { }));
         REQUIRE (io_intf.is_io_started());
@@ -41,6 +41,7 @@ void basic_net_entity_test_default_constructed() {
         REQUIRE_THROWS (net_ent.is_started());
         REQUIRE_THROWS (net_ent.start(chops::test::io_state_chg_mock, chops::test::err_func_mock));
         REQUIRE_THROWS (net_ent.stop());
+        REQUIRE_THROWS (net_ent.join_multicast_group(asio::ip::make_address("239.255.0.1")));
       }
     }
   } // end given
@@ -79,6 +80,15 @@ void basic_net_entity_test_methods() {
         REQUIRE (net_ent.get_socket() == chops::test::net_entity_mock::special_val);
       }
     }
+    AND_WHEN ("join_multicast_group and leave_multicast_group are called") {
+      THEN ("the calls are forwarded to the io handler") {
+        auto grp = asio::ip::make_address("239.255.0.1");
+        REQUIRE_FALSE (net_ent.join_multicast_group(grp));
+        REQUIRE (e->mcast_group == grp);
+        REQUIRE_FALSE (net_ent.leave_multicast_group(grp));
+        REQUIRE (net_ent.leave_multicast_group(grp));
+      }
+    }
   } // end given
 
 }
@@ -0,0 +1,132 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for @c delimiter_scanner and the underlying delimiter
+ *  search functions.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch.hpp"
+
+#include "asio/buffer.hpp"
+
+#include <cstddef> // std::size_t, std::byte
+#include <string>
+#include <string_view>
+#include <vector>
+#include <system_error>
+
+#include "net_ip/component/delimiter_scanner.hpp"
+#include "net_ip/detail/delimiter_search.hpp"
+
+using namespace chops::net::detail;
+
+// every offset of the delimiter from the beginning of the buffer, so the vectorized
+// block loops and the scalar tails are all exercised
+void delim_search_test(delim_search_func func, std::string_view delim) {
+
+  auto d = reinterpret_cast<const std::byte*>(delim.data());
+
+  for (std::size_t sz = 0u; sz < 100u; ++sz) {
+    for (std::size_t pos = 0u; pos + delim.size() <= sz; ++pos) {
+      // partial delimiters before the real one must not match
+      std::string str(sz, 'a');
+      for (std::size_t i = 0u; i + delim.size() - 1u < pos; i += delim.size()) {
+        str.replace(i, delim.size() - 1u, delim.substr(0u, delim.size() - 1u));
+      }
+      str.replace(pos, delim.size(), delim);
+      auto beg = reinterpret_cast<const std::byte*>(str.data());
+      auto p = func(beg, beg + str.size(), d, delim.size());
+      REQUIRE (p == (beg + pos));
+    }
+    std::string str(sz, 'a');
+    auto beg = reinterpret_cast<const std::byte*>(str.data());
+    REQUIRE (func(beg, beg + str.size(), d, delim.size()) == (beg + str.size()));
+  }
+}
+
+void delim_search_funcs_test(std::string_view delim) {
+  delim_search_test(delim_search_scalar, delim);
+  delim_search_test(select_delim_search(), delim);
+#ifdef CHOPS_NET_X86_SIMD
+  delim_search_test(delim_search_sse2, delim);
+  if (__builtin_cpu_supports("avx2")) {
+    delim_search_test(delim_search_avx2, delim);
+  }
+#endif
+}
+
+SCENARIO ( "Delimiter search functions test",
+           "[delimiter_scanner]" ) {
+
+  GIVEN ("A single byte delimiter") {
+    THEN ("every search function finds the first delimiter") {
+      delim_search_funcs_test("\n");
+    }
+  }
+  GIVEN ("A two byte delimiter") {
+    THEN ("every search function finds the first complete delimiter") {
+      delim_search_funcs_test("\r\n");
+    }
+  }
+  GIVEN ("A long delimiter") {
+    THEN ("every search function finds the first complete delimiter") {
+      delim_search_funcs_test("--boundary--");
+    }
+  }
+}
+
+SCENARIO ( "Delimiter scanner test",
+           "[delimiter_scanner]" ) {
+
+  chops::net::delimiter_scanner scanner("\r\n");
+  REQUIRE (scanner.delimiter() == "\r\n");
+
+  GIVEN ("A message arriving one byte at a time") {
+    std::string msg("Hello, world!\r\n");
+    WHEN ("scan is called for each partial message") {
+      THEN ("zero is returned until the delimiter is complete, then the message size") {
+        for (std::size_t i = 1u; i < msg.size(); ++i) {
+          REQUIRE (scanner.scan(asio::buffer(msg.data(), i)) == 0u);
+          REQUIRE (scanner.scan_position() == (i < 2u ? 0u : i - 1u));
+        }
+        REQUIRE (scanner.scan(asio::buffer(msg)) == msg.size());
+        REQUIRE (scanner.scan_position() == 0u);
+      }
+    }
+  }
+  GIVEN ("Several messages in one buffer") {
+    std::string msgs("abc\r\n\r\ndefghij\r\nklm");
+    WHEN ("scan is called after consuming each message") {
+      THEN ("each message size is returned, then zero for the trailing partial message") {
+        std::vector<std::size_t> sizes;
+        std::size_t beg = 0u;
+        std::size_t sz = 0u;
+        while ((sz = scanner.scan(asio::buffer(msgs.data() + beg, msgs.size() - beg))) != 0u) {
+          sizes.push_back(sz);
+          beg += sz;
+        }
+        REQUIRE (sizes == std::vector<std::size_t> { 5u, 2u, 9u });
+        REQUIRE (beg == msgs.size() - 3u);
+        REQUIRE (scanner.scan_position() == 2u);
+        scanner.reset();
+        REQUIRE (scanner.scan_position() == 0u);
+      }
+    }
+  }
+  GIVEN ("An empty delimiter") {
+    THEN ("construction is rejected") {
+      REQUIRE_THROWS_AS (chops::net::delimiter_scanner(std::string_view()), std::system_error);
+      REQUIRE_THROWS_AS (chops::net::delimiter_scanner(""), std::system_error);
+    }
+  }
+}
+
@@ -15,17 +15,43 @@
 
 #include "catch2/catch.hpp"
 
+#include "asio/ip/tcp.hpp"
+#include "asio/io_context.hpp"
+#include "asio/buffer.hpp"
+#include "asio/read.hpp"
+#include "asio/executor_work_guard.hpp"
+
 #include <cstddef> // std::size_t
+#include <string>
+#include <chrono>
+#include <mutex>
+#include <system_error>
 
 #include <memory> // std::make_shared
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <future>
+#include <algorithm> // std::fill, std::find
 
 #include "net_ip/component/send_to_all.hpp"
+#include "net_ip/component/worker.hpp"
+#include "net_ip/component/worker_pool.hpp"
+#include "net_ip/detail/tcp_acceptor.hpp"
+#include "net_ip/detail/tcp_io.hpp"
+#include "net_ip/net_entity.hpp"
+#include "net_ip/io_interface.hpp"
 
 #include "net_ip/queue_stats.hpp"
 #include "marshall/shared_buffer.hpp"
 
 #include "net_ip/shared_utility_test.hpp"
 
+// the TCP and UDP IO handlers must be broadcast to with one post per executor
+static_assert(chops::net::detail::has_send_in_io_thread<chops::net::detail::tcp_io>::value);
+static_assert(chops::net::detail::has_send_in_io_thread<chops::net::detail::udp_entity_io>::value);
+static_assert(!chops::net::detail::has_send_in_io_thread<chops::test::io_handler_mock>::value);
+
 SCENARIO ( "Testing send_to_all class",
            "[send_to_all]" ) {
 
@@ -89,5 +115,293 @@ SCENARIO ( "Testing send_to_all class",
   } // end given
 }
 
+SCENARIO ( "Testing send_to_all with concurrent sends and membership changes",
+           "[send_to_all]" ) {
+
+  using namespace chops::test;
+
+  constexpr int num_ioh = 200;
+
+  chops::net::send_to_all<io_handler_mock> sta { };
+
+  GIVEN ("A send_to_all object with a set of io handlers") {
+    std::vector<io_handler_mock_ptr> iohs;
+    for (int i = 0; i < num_ioh; ++i) {
+      iohs.push_back(std::make_shared<io_handler_mock>());
+    }
+    for (int i = 0; i < num_ioh / 2; ++i) {
+      sta.add_io_interface(io_interface_mock(iohs[i]));
+    }
+    WHEN ("one thread broadcasts while another adds and removes io handlers") {
+      std::byte b(static_cast<std::byte>(0xFE));
+      chops::const_shared_buffer buf(&b, 1);
+      std::atomic_bool done(false);
+      std::thread sender([&sta, &buf, &done] () {
+          while (!done) {
+            sta.send(buf);
+          }
+        }
+      );
+      for (int i = num_ioh / 2; i < num_ioh; ++i) {
+        sta.add_io_interface(io_interface_mock(iohs[i]));
+        sta.remove_io_interface(io_interface_mock(iohs[i - num_ioh / 2]));
+      }
+      done = true;
+      sender.join();
+      THEN ("the final membership is correct and the broadcasts reached the members") {
+        REQUIRE (sta.size() == num_ioh / 2);
+        sta.send(buf);
+        for (int i = num_ioh / 2; i < num_ioh; ++i) {
+          REQUIRE (iohs[i]->send_called);
+        }
+      }
+    }
+  } // end given
+}
+
+SCENARIO ( "Testing send_to_all slow member policies",
+           "[send_to_all] [slow_member]" ) {
 
+  using namespace chops::test;
+  using chops::net::slow_member_policy;
+
+  // the mock output queue always holds qs_base + 1 bytes
+  constexpr std::size_t below = io_handler_mock::qs_base;
+  constexpr std::size_t above = io_handler_mock::qs_base + 10u;
+
+  chops::net::send_to_all<io_handler_mock> sta { };
+  auto ioh = std::make_shared<io_handler_mock>();
+  ioh->started = true;
+  sta.add_io_interface(io_interface_mock(ioh));
+
+  std::byte b1(static_cast<std::byte>(0x01));
+  std::byte b2(static_cast<std::byte>(0x02));
 
+  GIVEN ("A send_to_all object with one member") {
+    WHEN ("the skip policy is set with a threshold above the queued bytes") {
+      sta.set_slow_member_policy(slow_member_policy::skip, above);
+      sta.send(&b1, 1u);
+      THEN ("the buffer is sent") {
+        REQUIRE (ioh->send_called);
+        REQUIRE (sta.dropped_count(io_interface_mock(ioh)) == 0u);
+      }
+    }
+    AND_WHEN ("the skip policy is set with a threshold below the queued bytes") {
+      sta.set_slow_member_policy(slow_member_policy::skip, below);
+      sta.send(&b1, 1u);
+      sta.send(&b2, 1u);
+      THEN ("the buffers are not sent and are counted as dropped") {
+        REQUIRE_FALSE (ioh->send_called);
+        REQUIRE (sta.dropped_count(io_interface_mock(ioh)) == 2u);
+        REQUIRE (ioh->started);
+      }
+    }
+    AND_WHEN ("the disconnect policy is set with a threshold below the queued bytes") {
+      sta.set_slow_member_policy(slow_member_policy::disconnect, below);
+      sta.send(&b1, 1u);
+      THEN ("the member is stopped and the buffer is counted as dropped") {
+        REQUIRE_FALSE (ioh->send_called);
+        REQUIRE_FALSE (ioh->started);
+        REQUIRE (sta.dropped_count(io_interface_mock(ioh)) == 1u);
+      }
+    }
+    AND_WHEN ("the conflate policy is set with a key function and the member is slow") {
+      sta.set_slow_member_policy(slow_member_policy::conflate, below,
+          [] (const chops::const_shared_buffer& buf) { return static_cast<std::size_t>(buf.data()[0]); } );
+      sta.send(&b1, 1u);
+      sta.send(&b2, 1u);
+      sta.send(&b1, 1u);
+      sta.send(&b1, 1u);
+      THEN ("only the latest buffer per key is kept, and is sent when the member catches up") {
+        REQUIRE_FALSE (ioh->send_called);
+        REQUIRE (sta.dropped_count(io_interface_mock(ioh)) == 2u);
+        sta.set_slow_member_policy(slow_member_policy::conflate, above);
+        sta.send(&b2, 1u);
+        REQUIRE (ioh->send_called);
+        REQUIRE (sta.dropped_count(io_interface_mock(ioh)) == 2u);
+      }
+    }
+    AND_WHEN ("the conflate policy is set, the member is slow, then no more buffers are sent") {
+      sta.set_slow_member_policy(slow_member_policy::conflate, below);
+      sta.send(&b1, 1u);
+      sta.send(&b2, 1u);
+      THEN ("the latest buffer is sent by flush once the member catches up") {
+        sta.flush();
+        REQUIRE_FALSE (ioh->send_called);
+        sta.set_slow_member_policy(slow_member_policy::conflate, above);
+        sta.flush();
+        REQUIRE (ioh->send_called);
+        REQUIRE (sta.dropped_count(io_interface_mock(ioh)) == 1u);
+      }
+    }
+    AND_WHEN ("dropped_count is called for an object not in the collection") {
+      auto other = std::make_shared<io_handler_mock>();
+      THEN ("zero is returned") {
+        REQUIRE (sta.dropped_count(io_interface_mock(other)) == 0u);
+      }
+    }
+  } // end given
+}
+
+SCENARIO ( "Testing send_to_all broadcasts to TCP connections in multiple io_contexts",
+           "[send_to_all] [tcp_io]" ) {
+
+  constexpr std::size_t num_conns = 8u;
+  constexpr unsigned short test_port = 30453;
+
+  chops::net::worker wk;
+  wk.start();
+  chops::net::worker_pool pool(2u);
+  pool.start();
+
+  GIVEN ("TCP connections distributed across two io_contexts and a send_to_all object") {
+
+    asio::ip::tcp::endpoint endp(asio::ip::address_v4::loopback(), test_port);
+    auto acc_ptr = std::make_shared<chops::net::detail::tcp_acceptor>(wk.get_io_context(),
+                                                   endp, true, pool.get_distributor());
+    chops::net::tcp_acceptor_net_entity acc(acc_ptr);
+    chops::net::send_to_all<chops::net::detail::tcp_io> sta { };
+
+    std::mutex mut;
+    std::vector<chops::net::tcp_io_interface> ios;
+
+    acc.start( [&] (chops::net::tcp_io_interface io, std::size_t, bool starting) {
+        if (starting) {
+          io.start_io("\n", [] (asio::const_buffer, chops::net::tcp_io_interface,
+                                asio::ip::tcp::endpoint) { return true; } );
+          std::lock_guard<std::mutex> lk(mut);
+          ios.push_back(io);
+        }
+        sta(io, 0u, starting);
+      },
+      [] (chops::net::tcp_io_interface, std::error_code) { }
+    );
+
+    asio::io_context ioc;
+    std::vector<asio::ip::tcp::socket> socks;
+    for (std::size_t i = 0u; i < num_conns; ++i) {
+      socks.emplace_back(ioc);
+      socks.back().connect(endp);
+    }
+    for (int i = 0; i < 200 && sta.size() != num_conns; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    REQUIRE (sta.size() == num_conns);
+
+    WHEN ("messages are broadcast, one excluding the first connection") {
+      chops::net::tcp_io_interface first_io;
+      {
+        std::lock_guard<std::mutex> lk(mut);
+        auto port = socks[0].local_endpoint().port();
+        for (auto io : ios) {
+          if (io.get_socket().remote_endpoint().port() == port) {
+            first_io = io;
+          }
+        }
+      }
+      REQUIRE (first_io.is_valid());
+      std::string msg1("First broadcast\n");
+      std::string msg2("Not to the first\n");
+      std::string msg3("Last broadcast\n");
+      sta.send(msg1.data(), msg1.size());
+      sta.send(msg2.data(), msg2.size(), first_io);
+      sta.send(msg3.data(), msg3.size());
+
+      THEN ("every connection receives the messages in order") {
+        for (std::size_t i = 0u; i < num_conns; ++i) {
+          std::string expected = (i == 0u) ? msg1 + msg3 : msg1 + msg2 + msg3;
+          std::string recv(expected.size(), ' ');
+          asio::read(socks[i], asio::buffer(recv));
+          REQUIRE (recv == expected);
+        }
+      }
+    }
+    acc.stop();
+  } // end given
+
+  pool.reset();
+  wk.reset();
+}
+
+
+SCENARIO ( "Testing send_to_all conflate policy with a slow TCP member and no further broadcasts",
+           "[send_to_all] [slow_member] [tcp_io]" ) {
+
+  using tcp_io = chops::net::detail::tcp_io;
+  using chops::net::slow_member_policy;
+
+  constexpr std::size_t filler_size = 8u * 1024u * 1024u;
+  constexpr int num_fillers = 8;
+
+  asio::io_context ioc;
+  auto wg = asio::make_work_guard(ioc);
+  std::thread run_thr([&ioc] () { ioc.run(); } );
+  // a failed REQUIRE unwinds with the thread still running, which would otherwise
+  // terminate the test run; the outstanding handlers are abandoned in that case
+  struct join_guard {
+    asio::io_context& m_ioc;
+    std::thread&      m_thr;
+    ~join_guard() {
+      if (m_thr.joinable()) {
+        m_ioc.stop();
+        m_thr.join();
+      }
+    }
+  } run_guard { ioc, run_thr };
+
+  GIVEN ("A TCP member whose peer is not reading, and a conflating send_to_all object") {
+
+    asio::ip::tcp::acceptor acc(ioc, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0));
+    asio::ip::tcp::socket peer(ioc);
+    peer.connect(acc.local_endpoint());
+    auto ioh = std::make_shared<tcp_io>(acc.accept(), 
+                   [] (std::error_code, std::shared_ptr<tcp_io> p) { p->close(); } );
+    ioh->start_io();
+
+    chops::net::send_to_all<tcp_io> sta { };
+    sta.set_slow_member_policy(slow_member_policy::conflate, 0u,
+        [] (const chops::const_shared_buffer& buf) { return static_cast<std::size_t>(buf.data()[0]); } );
+    sta.add_io_interface(chops::net::tcp_io_interface(ioh));
+
+    WHEN ("large buffers then a final buffer are broadcast, then the peer starts reading") {
+      for (int i = 0; i < num_fillers; ++i) {
+        chops::mutable_shared_buffer filler(filler_size);
+        std::fill(filler.data(), filler.data() + filler.size(), std::byte('A'));
+        sta.send(std::move(filler));
+      }
+      std::string last("Z");
+      sta.send(last.data(), last.size());
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+      auto rd_fut = std::async(std::launch::async, [&peer] () {
+          std::vector<char> rbuf(64u * 1024u);
+          std::error_code ec;
+          for (;;) {
+            auto n = peer.read_some(asio::buffer(rbuf), ec);
+            if (ec) {
+              return false;
+            }
+            if (std::find(rbuf.begin(), rbuf.begin() + n, 'Z') != rbuf.begin() + n) {
+              return true;
+            }
+          }
+        }
+      );
+      auto status = rd_fut.wait_for(std::chrono::seconds(10));
+      if (status != std::future_status::ready) {
+        ioh->close();
+      }
+
+      THEN ("the conflated buffers are sent once the member catches up") {
+        REQUIRE (status == std::future_status::ready);
+        REQUIRE (rd_fut.get());
+        REQUIRE (sta.dropped_count(chops::net::tcp_io_interface(ioh)) > 0u);
+      }
+    }
+    ioh->close();
+    std::error_code ec;
+    peer.close(ec);
+  } // end given
+  wg.reset();
+  run_thr.join();
+}
@@ -0,0 +1,170 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for @c tcp_acceptor_group.
+ *
+ *  The acceptors in the group each run in a separate @c worker, and blocking Asio
+ *  connects and io are used for the connecting side.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch.hpp"
+
+#include "asio/ip/tcp.hpp"
+#include "asio/io_context.hpp"
+#include "asio/buffer.hpp"
+#include "asio/write.hpp"
+#include "asio/read_until.hpp"
+
+#include <system_error> // std::error_code
+#include <cstddef> // std::size_t
+#include <string>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <functional> // std::reference_wrapper
+#include <atomic>
+#include <set>
+#include <mutex>
+
+#include "net_ip/component/tcp_acceptor_group.hpp"
+#include "net_ip/component/worker.hpp"
+
+#include "net_ip/io_interface.hpp"
+
+constexpr unsigned short test_port = 30449;
+constexpr int num_workers = 3;
+constexpr int num_conns = 60;
+
+bool wait_for_count(const chops::net::tcp_acceptor_group& grp, std::size_t cnt) {
+  for (int i = 0; i < 200 && grp.connection_count() != cnt; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return grp.connection_count() == cnt;
+}
+
+SCENARIO ( "Tcp acceptor group test, connections spread across io_contexts",
+           "[tcp_acceptor_group]" ) {
+
+  std::vector<chops::net::worker> workers(num_workers);
+  std::vector<std::reference_wrapper<asio::io_context>> iocs;
+  for (auto& wk : workers) {
+    wk.start();
+    iocs.push_back(std::ref(wk.get_io_context()));
+  }
+
+  GIVEN ("An acceptor group, one acceptor per worker") {
+
+    asio::ip::tcp::endpoint endp(asio::ip::address_v4::loopback(), test_port);
+    chops::net::tcp_acceptor_group grp(iocs.begin(), iocs.end(), endp);
+    REQUIRE (grp.size() == num_workers);
+    REQUIRE_FALSE (grp.is_started());
+
+    std::mutex mut;
+    std::set<std::thread::id> thr_ids;
+    std::atomic_size_t max_cnt(0u);
+
+    REQUIRE (grp.start( [&] (chops::net::tcp_io_interface io, std::size_t cnt, bool starting) {
+        if (!starting) {
+          return;
+        }
+        if (cnt > max_cnt) {
+          max_cnt = cnt;
+        }
+        {
+          std::lock_guard<std::mutex> lk(mut);
+          thr_ids.insert(std::this_thread::get_id());
+        }
+        io.start_io("\n", [] (asio::const_buffer buf, chops::net::tcp_io_interface io,
+                              asio::ip::tcp::endpoint) {
+            io.send(buf.data(), buf.size()); // echo
+            return true;
+          }
+        );
+      },
+      [] (chops::net::tcp_io_interface, std::error_code) { }
+    ) == static_cast<std::size_t>(num_workers));
+    REQUIRE (grp.is_started());
+    REQUIRE_FALSE (grp.start([] (chops::net::tcp_io_interface, std::size_t, bool) { },
+                             [] (chops::net::tcp_io_interface, std::error_code) { }));
+
+    WHEN ("multiple connections are made and messages are echoed") {
+      THEN ("the aggregated connection count includes every connection") {
+
+        asio::io_context ioc;
+        std::vector<asio::ip::tcp::socket> socks;
+        for (int i = 0; i < num_conns; ++i) {
+          socks.emplace_back(ioc);
+          socks.back().connect(endp);
+        }
+        REQUIRE (wait_for_count(grp, num_conns));
+        REQUIRE (max_cnt == num_conns);
+
+        std::string msg("Hello, acceptor group!\n");
+        for (auto& sock : socks) {
+          asio::write(sock, asio::buffer(msg));
+          std::string reply;
+          auto sz = asio::read_until(sock, asio::dynamic_buffer(reply), "\n");
+          REQUIRE (sz == msg.size());
+          REQUIRE (reply == msg);
+        }
+        {
+          std::lock_guard<std::mutex> lk(mut);
+          INFO ("Number of threads handling connections: " << thr_ids.size());
+          REQUIRE (thr_ids.size() > 1u);
+          REQUIRE (thr_ids.size() <= static_cast<std::size_t>(num_workers));
+        }
+
+        REQUIRE (grp.stop());
+        REQUIRE_FALSE (grp.stop());
+        REQUIRE (wait_for_count(grp, 0u));
+      }
+    }
+
+    // the callbacks reference the locals above, so the workers must finish
+    // before the locals and the group go out of scope
+    for (auto& wk : workers) {
+      wk.reset();
+    }
+  } // end given
+
+  GIVEN ("An acceptor group whose port is held by a listener without SO_REUSEPORT") {
+
+    asio::io_context ioc;
+    asio::ip::tcp::endpoint endp(asio::ip::address_v4::loopback(), test_port);
+    asio::ip::tcp::acceptor blocker(ioc, endp);
+    chops::net::tcp_acceptor_group grp(iocs.begin(), iocs.end(), endp);
+
+    std::atomic_int bind_errs(0);
+
+    WHEN ("the group is started") {
+      auto num_started = grp.start( [] (chops::net::tcp_io_interface, std::size_t, bool) { },
+        [&bind_errs] (chops::net::tcp_io_interface, std::error_code err) {
+          // each failed acceptor also reports that it is stopped
+          if (err != std::make_error_code(chops::net::net_ip_errc::tcp_acceptor_stopped)) {
+            ++bind_errs;
+          }
+        }
+      );
+      THEN ("no acceptor starts and each reports the bind error") {
+        REQUIRE (num_started == 0u);
+        REQUIRE_FALSE (grp.is_started());
+        REQUIRE (bind_errs == num_workers);
+      }
+    }
+
+    for (auto& wk : workers) {
+      wk.reset();
+    }
+  } // end given
+
+}
+
@@ -0,0 +1,276 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for @c topic_router class template.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch.hpp"
+
+#include <cstddef> // std::size_t, std::byte
+#include <memory> // std::make_shared
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <string_view>
+
+#include "asio/ip/tcp.hpp"
+#include "asio/io_context.hpp"
+#include "asio/executor_work_guard.hpp"
+
+#include "net_ip/component/topic_router.hpp"
+#include "net_ip/detail/tcp_io.hpp"
+#include "net_ip/io_interface.hpp"
+
+#include "marshall/shared_buffer.hpp"
+
+#include "net_ip/shared_utility_test.hpp"
+
+// the tcp_io subscribers must be published to with one post per executor
+static_assert(chops::net::detail::has_send_in_io_thread<chops::net::detail::tcp_io>::value);
+
+bool wait_for_count(const std::atomic_size_t& cnt, std::size_t expected) {
+  for (int i = 0; i < 200 && cnt != expected; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return cnt == expected;
+}
+
+SCENARIO ( "Testing topic_router class",
+           "[topic_router]" ) {
+
+  using namespace chops::test;
+
+  chops::net::topic_router<io_handler_mock> rtr { };
+  REQUIRE (rtr.topic_count() == 0u);
+
+  std::byte b(static_cast<std::byte>(0xFE));
+  chops::const_shared_buffer buf(&b, 1);
+
+  auto ioh1 = std::make_shared<io_handler_mock>();
+  auto ioh2 = std::make_shared<io_handler_mock>();
+  auto ioh3 = std::make_shared<io_handler_mock>();
+
+  GIVEN ("A default constructed topic_router object") {
+    WHEN ("subscribe is called for multiple topics") {
+      REQUIRE (rtr.subscribe("MSFT", io_interface_mock(ioh1)));
+      REQUIRE (rtr.subscribe("IBM", io_interface_mock(ioh1)));
+      REQUIRE (rtr.subscribe("MSFT", io_interface_mock(ioh2)));
+      REQUIRE (rtr.subscribe("AAPL", io_interface_mock(ioh3)));
+      REQUIRE_FALSE (rtr.subscribe("MSFT", io_interface_mock(ioh2)));
+      THEN ("the topic and subscriber counts are correct") {
+        REQUIRE (rtr.topic_count() == 3u);
+        REQUIRE (rtr.subscriber_count("MSFT") == 2u);
+        REQUIRE (rtr.subscriber_count("IBM") == 1u);
+        REQUIRE (rtr.subscriber_count("AAPL") == 1u);
+        REQUIRE (rtr.subscriber_count("GOOG") == 0u);
+      }
+    }
+    AND_WHEN ("publish is called") {
+      rtr.subscribe("MSFT", io_interface_mock(ioh1));
+      rtr.subscribe("MSFT", io_interface_mock(ioh2));
+      rtr.subscribe("AAPL", io_interface_mock(ioh3));
+      THEN ("only the subscribers to the topic are sent to") {
+        REQUIRE (rtr.publish("GOOG", buf) == 0u);
+        REQUIRE (rtr.publish("MSFT", buf) == 2u);
+        REQUIRE (ioh1->send_called);
+        REQUIRE (ioh2->send_called);
+        REQUIRE_FALSE (ioh3->send_called);
+        REQUIRE (rtr.publish("AAPL", &b, 1u) == 1u);
+        REQUIRE (ioh3->send_called);
+      }
+    }
+    AND_WHEN ("a subscriber's io handler is destroyed before a publish") {
+      auto ioh4 = std::make_shared<io_handler_mock>();
+      rtr.subscribe("MSFT", io_interface_mock(ioh4));
+      rtr.subscribe("MSFT", io_interface_mock(ioh1));
+      ioh4.reset();
+      THEN ("the closed subscriber is skipped and not counted, then removed") {
+        REQUIRE (rtr.publish("MSFT", buf) == 1u);
+        REQUIRE (ioh1->send_called);
+        REQUIRE (rtr.subscriber_count("MSFT") == 2u);
+        REQUIRE (rtr.unsubscribe_all(io_interface_mock()) == 1u);
+        REQUIRE (rtr.subscriber_count("MSFT") == 1u);
+        REQUIRE (rtr.unsubscribe_all(io_interface_mock()) == 0u);
+      }
+    }
+    AND_WHEN ("several subscribers' io handlers are destroyed before unsubscribe_all") {
+      auto ioh4 = std::make_shared<io_handler_mock>();
+      auto ioh5 = std::make_shared<io_handler_mock>();
+      rtr.subscribe("MSFT", io_interface_mock(ioh4));
+      rtr.subscribe("IBM", io_interface_mock(ioh4));
+      rtr.subscribe("MSFT", io_interface_mock(ioh5));
+      rtr.subscribe("IBM", io_interface_mock(ioh5));
+      rtr.subscribe("MSFT", io_interface_mock(ioh1));
+      ioh4.reset();
+      ioh5.reset();
+      THEN ("each closed subscriber is removed from each of its topics and counted") {
+        REQUIRE (rtr.unsubscribe_all(io_interface_mock()) == 4u);
+        REQUIRE (rtr.subscriber_count("MSFT") == 1u);
+        REQUIRE (rtr.subscriber_count("IBM") == 0u);
+        REQUIRE (rtr.topic_count() == 1u);
+      }
+    }
+    AND_WHEN ("unsubscribe and unsubscribe_all are called") {
+      rtr.subscribe("MSFT", io_interface_mock(ioh1));
+      rtr.subscribe("IBM", io_interface_mock(ioh1));
+      rtr.subscribe("MSFT", io_interface_mock(ioh2));
+      THEN ("the subscriptions are removed, and topics without subscribers are removed") {
+        REQUIRE (rtr.unsubscribe("MSFT", io_interface_mock(ioh2)));
+        REQUIRE_FALSE (rtr.unsubscribe("MSFT", io_interface_mock(ioh2)));
+        REQUIRE_FALSE (rtr.unsubscribe("GOOG", io_interface_mock(ioh2)));
+        REQUIRE (rtr.subscriber_count("MSFT") == 1u);
+        REQUIRE (rtr.unsubscribe_all(io_interface_mock(ioh1)) == 2u);
+        REQUIRE (rtr.topic_count() == 0u);
+      }
+    }
+  } // end given
+
+  GIVEN ("A topic_router object with initial topics") {
+    chops::net::topic_router<io_handler_mock> init_rtr { std::vector<std::string> { "A", "B" } };
+    WHEN ("the function call operator is called for starting and stopping") {
+      init_rtr(io_interface_mock(ioh1), 1u, true);
+      init_rtr(io_interface_mock(ioh2), 2u, true);
+      THEN ("the io handlers are subscribed to the initial topics, then unsubscribed from all") {
+        REQUIRE (init_rtr.subscriber_count("A") == 2u);
+        REQUIRE (init_rtr.subscriber_count("B") == 2u);
+        REQUIRE (init_rtr.subscribe("C", io_interface_mock(ioh1)));
+        init_rtr(io_interface_mock(ioh1), 1u, false);
+        REQUIRE (init_rtr.subscriber_count("A") == 1u);
+        REQUIRE (init_rtr.topic_count() == 2u);
+        init_rtr(io_interface_mock(ioh2), 0u, false);
+        REQUIRE (init_rtr.topic_count() == 0u);
+      }
+    }
+  } // end given
+}
+
+SCENARIO ( "Testing topic_router with concurrent publishes and subscription changes",
+           "[topic_router]" ) {
+
+  using namespace chops::test;
+
+  constexpr int num_ioh = 100;
+
+  chops::net::topic_router<io_handler_mock> rtr { };
+
+  GIVEN ("A set of io handlers subscribing to and unsubscribing from topics") {
+    std::vector<io_handler_mock_ptr> iohs;
+    for (int i = 0; i < num_ioh; ++i) {
+      iohs.push_back(std::make_shared<io_handler_mock>());
+    }
+    WHEN ("one thread publishes while subscriptions change") {
+      std::byte b(static_cast<std::byte>(0xFE));
+      chops::const_shared_buffer buf(&b, 1);
+      std::atomic_bool done(false);
+      std::thread publisher([&rtr, &buf, &done] () {
+          while (!done) {
+            rtr.publish("even", buf);
+            rtr.publish("odd", buf);
+          }
+        }
+      );
+      for (int i = 0; i < num_ioh; ++i) {
+        rtr.subscribe(std::to_string(i), io_interface_mock(iohs[i]));
+        rtr.subscribe((i % 2 == 0) ? "even" : "odd", io_interface_mock(iohs[i]));
+      }
+      for (int i = 0; i < num_ioh; ++i) {
+        rtr.unsubscribe(std::to_string(i), io_interface_mock(iohs[i]));
+      }
+      done = true;
+      publisher.join();
+      THEN ("the final subscriptions are correct") {
+        REQUIRE (rtr.topic_count() == 2u);
+        REQUIRE (rtr.subscriber_count("even") == num_ioh / 2);
+        REQUIRE (rtr.subscriber_count("odd") == num_ioh / 2);
+      }
+    }
+  } // end given
+}
+
+
+SCENARIO ( "Testing topic_router with tcp_io subscribers, one post per executor",
+           "[topic_router] [tcp_io]" ) {
+
+  using tcp_io = chops::net::detail::tcp_io;
+
+  asio::io_context ioc;
+  auto wg = asio::make_work_guard(ioc);
+  std::thread run_thr([&ioc] () { ioc.run(); } );
+  // a failed REQUIRE unwinds with the thread still running, which would otherwise
+  // terminate the test run; the outstanding handlers are abandoned in that case
+  struct join_guard {
+    asio::io_context& m_ioc;
+    std::thread&      m_thr;
+    ~join_guard() {
+      if (m_thr.joinable()) {
+        m_ioc.stop();
+        m_thr.join();
+      }
+    }
+  } run_guard { ioc, run_thr };
+
+  GIVEN ("Two connected pairs of tcp_io objects, the receiving side subscribed to a topic") {
+
+    asio::ip::tcp::acceptor acc(ioc, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0));
+    auto notify = [] (std::error_code, std::shared_ptr<tcp_io> p) { p->close(); };
+    std::vector<std::shared_ptr<tcp_io>> pubs;
+    std::vector<std::shared_ptr<tcp_io>> rcvrs;
+    std::atomic_size_t rcv_cnt { 0u };
+    for (int i = 0; i < 2; ++i) {
+      asio::ip::tcp::socket sock(ioc);
+      sock.connect(acc.local_endpoint());
+      pubs.push_back(std::make_shared<tcp_io>(acc.accept(), notify));
+      rcvrs.push_back(std::make_shared<tcp_io>(std::move(sock), notify));
+      pubs.back()->start_io();
+      rcvrs.back()->start_io(1u, [&rcv_cnt] (asio::const_buffer, chops::net::tcp_io_interface,
+                                             asio::ip::tcp::endpoint) {
+          ++rcv_cnt;
+          return true;
+        }
+      );
+    }
+
+    chops::net::topic_router<tcp_io> rtr { };
+    rtr.subscribe("IBM", chops::net::tcp_io_interface(pubs[0]));
+    rtr.subscribe("IBM", chops::net::tcp_io_interface(pubs[1]));
+
+    std::byte b(static_cast<std::byte>(0xFE));
+    chops::const_shared_buffer buf(&b, 1);
+
+    WHEN ("a buffer is published, then one subscriber is closed and destroyed") {
+      auto first_cnt = rtr.publish("IBM", buf);
+      bool first_rcvd = wait_for_count(rcv_cnt, 2u);
+      pubs[1]->close();
+      pubs[1].reset();
+      auto second_cnt = rtr.publish("IBM", buf);
+      bool second_rcvd = wait_for_count(rcv_cnt, 3u);
+      THEN ("the buffer is sent to every open subscriber, and the closed one is skipped") {
+        REQUIRE (first_cnt == 2u);
+        REQUIRE (first_rcvd);
+        REQUIRE (second_cnt == 1u);
+        REQUIRE (second_rcvd);
+      }
+    }
+    for (auto& p : pubs) {
+      if (p) {
+        p->close();
+      }
+    }
+    for (auto& p : rcvrs) {
+      p->close();
+    }
+  } // end given
+  wg.reset();
+  run_thr.join();
+}
@@ -0,0 +1,157 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for @c tuned_worker.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch.hpp"
+
+#include "asio/post.hpp"
+#include "asio/steady_timer.hpp"
+
+#include <atomic>
+#include <future>
+#include <chrono>
+#include <system_error>
+
+#if defined(__linux__)
+#include <sched.h> // sched_getcpu, sched_getscheduler, sched_getaffinity, CPU_SETSIZE
+#include <pthread.h>
+#include <thread>
+#include <cerrno>
+#endif
+
+#include "net_ip/component/tuned_worker.hpp"
+
+constexpr int num_handlers = 10000;
+
+void post_handlers_test(const chops::net::worker_options& opts) {
+
+  chops::net::tuned_worker wk(opts);
+  auto err = wk.start();
+  INFO ("Thread tuning error, if any: " << err.message());
+
+  std::atomic_int cnt(0);
+  std::promise<void> prom;
+  auto fut = prom.get_future();
+  for (int i = 0; i < num_handlers; ++i) {
+    asio::post(wk.get_io_context(), [&cnt, &prom] () {
+        if (++cnt == num_handlers) {
+          prom.set_value();
+        }
+      }
+    );
+  }
+  REQUIRE (fut.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+
+  // a timer completes after the threads have fallen back to blocking
+  asio::steady_timer tmr(wk.get_io_context(), std::chrono::milliseconds(50));
+  std::promise<std::error_code> tmr_prom;
+  auto tmr_fut = tmr_prom.get_future();
+  tmr.async_wait([&tmr_prom] (const std::error_code& e) { tmr_prom.set_value(e); } );
+  REQUIRE (tmr_fut.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+  REQUIRE_FALSE (tmr_fut.get());
+
+  wk.reset(); // threads exit once all work is complete
+  REQUIRE (cnt == num_handlers);
+}
+
+SCENARIO ( "Tuned worker test, blocking and spin run modes", "[tuned_worker]" ) {
+
+  chops::net::worker_options opts;
+
+  GIVEN ("A tuned worker with default options") {
+    THEN ("posted handlers are invoked and reset joins the thread") {
+      post_handlers_test(opts);
+    }
+  }
+  GIVEN ("A tuned worker with multiple threads spinning") {
+    opts.num_threads = 2u;
+    opts.spin_budget = std::chrono::microseconds(200);
+    THEN ("posted handlers are invoked and reset joins the threads") {
+      post_handlers_test(opts);
+    }
+  }
+  GIVEN ("A tuned worker with a FIFO priority, which may not be permitted") {
+    opts.fifo_priority = 10;
+    opts.spin_budget = std::chrono::microseconds(100);
+    THEN ("posted handlers are invoked whether or not the priority is set") {
+      post_handlers_test(opts);
+    }
+  }
+}
+
+#if defined(__linux__)
+
+SCENARIO ( "Tuned worker test, CPU affinity", "[tuned_worker]" ) {
+
+  // the first CPU of the process affinity mask, since a container cpuset may not
+  // include CPU 0
+  cpu_set_t proc_set;
+  CPU_ZERO(&proc_set);
+  REQUIRE (sched_getaffinity(0, sizeof(proc_set), &proc_set) == 0);
+  int first_cpu = 0;
+  while (first_cpu < CPU_SETSIZE && !CPU_ISSET(first_cpu, &proc_set)) {
+    ++first_cpu;
+  }
+  REQUIRE (first_cpu < CPU_SETSIZE);
+
+  GIVEN ("A tuned worker pinned to the first CPU of the process affinity mask") {
+    chops::net::worker_options opts;
+    opts.cpus.push_back(first_cpu);
+    chops::net::tuned_worker wk(opts);
+    REQUIRE_FALSE (wk.start());
+
+    WHEN ("a handler is posted") {
+      std::promise<int> prom;
+      auto fut = prom.get_future();
+      asio::post(wk.get_io_context(), [&prom] () { prom.set_value(sched_getcpu()); } );
+      THEN ("the handler runs on the pinned CPU") {
+        REQUIRE (fut.get() == first_cpu);
+      }
+    }
+    wk.reset();
+  }
+
+  GIVEN ("A tuned worker with an invalid CPU and a FIFO priority") {
+    chops::net::worker_options opts;
+    opts.cpus.push_back(CPU_SETSIZE - 1);
+    opts.fifo_priority = 10;
+    chops::net::tuned_worker wk(opts);
+    auto err = wk.start();
+
+    WHEN ("a handler is posted") {
+      std::promise<int> prom;
+      auto fut = prom.get_future();
+      asio::post(wk.get_io_context(), [&prom] () { prom.set_value(sched_getscheduler(0)); } );
+      THEN ("the affinity error is returned and the priority is still applied if permitted") {
+        REQUIRE (err == std::error_code(EINVAL, std::system_category()));
+        bool fifo_permitted = false;
+        std::thread probe([&fifo_permitted] () {
+            sched_param param { };
+            param.sched_priority = 10;
+            fifo_permitted = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+          }
+        );
+        probe.join();
+        auto policy = fut.get();
+        if (fifo_permitted) {
+          REQUIRE (policy == SCHED_FIFO);
+        }
+      }
+    }
+    wk.reset();
+  }
+}
+
+#endif
+
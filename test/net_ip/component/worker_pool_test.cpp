@@ -0,0 +1,176 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for @c worker_pool and distribution of accepted TCP
+ *  connections across the pool.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch.hpp"
+
+#include "asio/ip/tcp.hpp"
+#include "asio/io_context.hpp"
+#include "asio/buffer.hpp"
+#include "asio/write.hpp"
+#include "asio/read_until.hpp"
+
+#include <system_error> // std::error_code
+#include <cstddef> // std::size_t
+#include <string>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <memory> // std::make_shared
+#include <set>
+#include <mutex>
+
+#include "net_ip/component/worker_pool.hpp"
+#include "net_ip/component/worker.hpp"
+#include "net_ip/detail/tcp_acceptor.hpp"
+
+#include "net_ip/net_entity.hpp"
+#include "net_ip/io_interface.hpp"
+
+constexpr unsigned short test_port = 30451;
+constexpr std::size_t pool_size = 3u;
+constexpr std::size_t conns_per_worker = 4u;
+
+bool wait_for_total_load(const chops::net::worker_pool& pool, std::size_t total) {
+  auto sum = [&pool] () {
+    std::size_t s = 0u;
+    for (std::size_t i = 0u; i < pool.size(); ++i) {
+      s += pool.load(i);
+    }
+    return s;
+  };
+  for (int i = 0; i < 200 && sum() != total; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return sum() == total;
+}
+
+SCENARIO ( "Worker pool distribution policy test", "[worker_pool]" ) {
+
+  GIVEN ("A round-robin worker pool") {
+    chops::net::worker_pool pool(pool_size);
+    REQUIRE (pool.size() == pool_size);
+    WHEN ("io_contexts are acquired") {
+      THEN ("each worker is selected in turn") {
+        for (std::size_t i = 0u; i < 2u * pool_size; ++i) {
+          REQUIRE (&pool.acquire_io_context() == &pool.get_io_context(i % pool_size));
+        }
+        for (std::size_t i = 0u; i < pool_size; ++i) {
+          REQUIRE (pool.load(i) == 2u);
+        }
+        pool.release_io_context(pool.get_io_context(1u));
+        REQUIRE (pool.load(1u) == 1u);
+      }
+    }
+  } // end given
+
+  GIVEN ("A least-loaded worker pool") {
+    chops::net::worker_pool pool(pool_size, chops::net::distribution_policy::least_loaded);
+    WHEN ("io_contexts are acquired and one is released") {
+      THEN ("the worker with the fewest connections is selected") {
+        for (std::size_t i = 0u; i < pool_size; ++i) {
+          pool.acquire_io_context();
+        }
+        pool.release_io_context(pool.get_io_context(2u));
+        REQUIRE (&pool.acquire_io_context() == &pool.get_io_context(2u));
+        pool.release_io_context(pool.get_io_context(0u));
+        pool.release_io_context(pool.get_io_context(1u));
+        REQUIRE (&pool.acquire_io_context() == &pool.get_io_context(0u));
+        REQUIRE (&pool.acquire_io_context() == &pool.get_io_context(1u));
+      }
+    }
+  } // end given
+}
+
+SCENARIO ( "Worker pool test, accepted connections distributed round-robin",
+           "[worker_pool] [tcp_acceptor]" ) {
+
+  chops::net::worker wk;
+  wk.start();
+  chops::net::worker_pool pool(pool_size);
+  pool.start();
+
+  GIVEN ("A TCP acceptor with a worker pool distributor") {
+
+    asio::ip::tcp::endpoint endp(asio::ip::address_v4::loopback(), test_port);
+    auto acc_ptr = std::make_shared<chops::net::detail::tcp_acceptor>(wk.get_io_context(),
+                                                   endp, true, pool.get_distributor());
+    chops::net::tcp_acceptor_net_entity acc(acc_ptr);
+
+    std::mutex mut;
+    std::set<std::thread::id> thr_ids;
+    std::size_t conn_cnt = 0u;
+
+    acc.start( [&] (chops::net::tcp_io_interface io, std::size_t cnt, bool starting) {
+        {
+          std::lock_guard<std::mutex> lk(mut);
+          conn_cnt = cnt;
+          if (starting) {
+            thr_ids.insert(std::this_thread::get_id());
+          }
+        }
+        if (starting) {
+          io.start_io("\n", [] (asio::const_buffer buf, chops::net::tcp_io_interface io,
+                                asio::ip::tcp::endpoint) {
+              io.send(buf.data(), buf.size()); // echo
+              return true;
+            }
+          );
+        }
+      },
+      [] (chops::net::tcp_io_interface, std::error_code) { }
+    );
+
+    WHEN ("multiple connections are made and messages are echoed") {
+      THEN ("the connections are spread evenly across the pool threads") {
+
+        asio::io_context ioc;
+        std::vector<asio::ip::tcp::socket> socks;
+        std::string msg("Hello, worker pool!\n");
+        for (std::size_t i = 0u; i < pool_size * conns_per_worker; ++i) {
+          socks.emplace_back(ioc);
+          socks.back().connect(endp);
+          asio::write(socks.back(), asio::buffer(msg));
+          std::string reply;
+          REQUIRE (asio::read_until(socks.back(), asio::dynamic_buffer(reply), "\n") == msg.size());
+          REQUIRE (reply == msg);
+        }
+        // the io_context for the next (pending) accept is also acquired
+        REQUIRE (wait_for_total_load(pool, pool_size * conns_per_worker + 1u));
+        REQUIRE (pool.load(0u) == conns_per_worker + 1u);
+        for (std::size_t i = 1u; i < pool_size; ++i) {
+          REQUIRE (pool.load(i) == conns_per_worker);
+        }
+        {
+          std::lock_guard<std::mutex> lk(mut);
+          REQUIRE (conn_cnt == pool_size * conns_per_worker);
+          REQUIRE (thr_ids.size() == pool_size);
+        }
+
+        acc.stop();
+        REQUIRE (wait_for_total_load(pool, 0u));
+        for (std::size_t i = 0u; i < pool_size; ++i) {
+          REQUIRE (pool.load(i) == 0u);
+        }
+        std::lock_guard<std::mutex> lk(mut);
+        REQUIRE (conn_cnt == 0u);
+      }
+    }
+  } // end given
+
+  pool.reset();
+  wk.reset();
+}
+
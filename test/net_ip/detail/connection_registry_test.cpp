@@ -0,0 +1,99 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for @c connection_registry class template and connection ids.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch.hpp"
+
+#include <cstddef> // std::size_t
+#include <memory> // std::make_shared
+#include <vector>
+#include <set>
+
+#include "net_ip/detail/connection_registry.hpp"
+
+struct io_handler_stub {
+  std::size_t m_slot = 0u;
+  std::size_t get_registry_slot() const noexcept { return m_slot; }
+  void set_registry_slot(std::size_t slot) noexcept { m_slot = slot; }
+};
+
+using io_ptr = std::shared_ptr<io_handler_stub>;
+
+SCENARIO ( "Connection registry test", "[connection_registry]" ) {
+
+  chops::net::detail::connection_registry<io_handler_stub> reg;
+  REQUIRE (reg.empty());
+
+  std::vector<io_ptr> iohs;
+  for (int i = 0; i < 5; ++i) {
+    iohs.push_back(std::make_shared<io_handler_stub>());
+  }
+
+  GIVEN ("A registry with IO handlers added") {
+    for (std::size_t i = 0u; i < iohs.size(); ++i) {
+      REQUIRE (reg.add(iohs[i]) == (i + 1u));
+    }
+    WHEN ("IO handlers are removed") {
+      REQUIRE (reg.remove(iohs[1]));
+      REQUIRE (reg.remove(iohs[3]));
+      THEN ("they are no longer contained, a second remove fails, and the others are unaffected") {
+        REQUIRE (reg.size() == 3u);
+        REQUIRE_FALSE (reg.contains(iohs[1]));
+        REQUIRE_FALSE (reg.remove(iohs[1]));
+        REQUIRE (reg.contains(iohs[0]));
+        REQUIRE (reg.contains(iohs[4]));
+        auto snap = reg.snapshot();
+        REQUIRE (snap.size() == 3u);
+        REQUIRE (iohs[1].use_count() == 1);
+      }
+    }
+    AND_WHEN ("IO handlers are removed and new ones added") {
+      auto slot = iohs[2]->get_registry_slot();
+      reg.remove(iohs[2]);
+      auto p = std::make_shared<io_handler_stub>();
+      reg.add(p);
+      THEN ("the freed slot is reused, and the removed IO handler is not confused with the new one") {
+        REQUIRE (p->get_registry_slot() == slot);
+        REQUIRE (reg.size() == iohs.size());
+        REQUIRE_FALSE (reg.contains(iohs[2]));
+        REQUIRE_FALSE (reg.remove(iohs[2]));
+        REQUIRE (reg.contains(p));
+      }
+    }
+    AND_WHEN ("all IO handlers are removed") {
+      for (const auto& p : iohs) {
+        REQUIRE (reg.remove(p));
+      }
+      THEN ("the registry is empty") {
+        REQUIRE (reg.empty());
+        REQUIRE (reg.snapshot().empty());
+      }
+    }
+  } // end given
+}
+
+SCENARIO ( "Connection id test", "[connection_registry]" ) {
+
+  GIVEN ("A number of connection ids") {
+    std::set<std::size_t> ids;
+    for (int i = 0; i < 100; ++i) {
+      ids.insert(chops::net::detail::next_connection_id());
+    }
+    THEN ("they are unique and not 0") {
+      REQUIRE (ids.size() == 100u);
+      REQUIRE (ids.count(0u) == 0u);
+    }
+  } // end given
+}
+
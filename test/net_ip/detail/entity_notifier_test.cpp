@@ -0,0 +1,97 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for @c entity_notifier class template.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch.hpp"
+
+#include <memory> // std::make_shared
+#include <system_error>
+
+#include "net_ip/detail/entity_notifier.hpp"
+#include "net_ip/net_ip_error.hpp"
+
+struct io_handler_stub { };
+
+using notifier = chops::net::detail::entity_notifier<io_handler_stub>;
+
+class entity_stub {
+public:
+  int                               m_cnt = 0;
+  std::error_code                   m_err;
+  std::shared_ptr<io_handler_stub>  m_iop;
+
+private:
+  void notify_me(const std::error_code& err, const std::shared_ptr<io_handler_stub>& iop) {
+    ++m_cnt;
+    m_err = err;
+    m_iop = iop;
+  }
+
+public:
+  notifier make_notifier(const std::shared_ptr<entity_stub>& self) {
+    return notifier::bind<&entity_stub::notify_me>(self);
+  }
+};
+
+SCENARIO ( "Entity notifier test", "[entity_notifier]" ) {
+
+  auto iop = std::make_shared<io_handler_stub>();
+  auto err = std::make_error_code(chops::net::net_ip_errc::tcp_io_handler_stopped);
+
+  GIVEN ("An entity with a private notification member function") {
+    auto ent = std::make_shared<entity_stub>();
+    WHEN ("a notifier is bound to the entity and called") {
+      auto nf = ent->make_notifier(ent);
+      nf(err, iop);
+      THEN ("the member function is called and the entity is kept alive by the notifier") {
+        REQUIRE (nf);
+        REQUIRE (ent->m_cnt == 1);
+        REQUIRE (ent->m_err == err);
+        REQUIRE (ent->m_iop == iop);
+        REQUIRE (ent.use_count() == 2);
+        std::weak_ptr<entity_stub> wp(ent);
+        ent.reset();
+        REQUIRE_FALSE (wp.expired());
+        nf = notifier();
+        REQUIRE (wp.expired());
+      }
+    }
+  } // end given
+
+  GIVEN ("A callable object") {
+    int cnt = 0;
+    notifier nf ( [&cnt, iop] (std::error_code e, std::shared_ptr<io_handler_stub> p) {
+        if (e && p == iop) {
+          ++cnt;
+        }
+      }
+    );
+    WHEN ("the notifier is copied and both are called") {
+      auto nf2 = nf;
+      nf(err, iop);
+      nf2(err, iop);
+      THEN ("the callable is called for each") {
+        REQUIRE (cnt == 2);
+      }
+    }
+  } // end given
+
+  GIVEN ("A default constructed notifier") {
+    notifier nf;
+    THEN ("it is empty") {
+      REQUIRE_FALSE (nf);
+    }
+  } // end given
+}
+
@@ -0,0 +1,253 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for the handler allocator, including an allocation counting
+ *  test of steady state TCP and UDP sends and receives.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch.hpp"
+
+#include "asio/ip/tcp.hpp"
+#include "asio/ip/udp.hpp"
+#include "asio/io_context.hpp"
+#include "asio/executor_work_guard.hpp"
+
+#include <cstddef> // std::size_t
+#include <cstdlib> // std::malloc, std::free
+#include <new> // std::bad_alloc
+#include <atomic>
+#include <thread>
+#include <memory> // std::make_shared
+#include <system_error>
+
+#include "net_ip/detail/handler_allocator.hpp"
+#include "net_ip/detail/tcp_io.hpp"
+#include "net_ip/detail/udp_entity_io.hpp"
+#include "net_ip/io_interface.hpp"
+
+#include "marshall/shared_buffer.hpp"
+
+// every global allocation in this test executable is counted
+namespace {
+std::atomic_size_t alloc_cnt { 0u };
+}
+
+// GCC flags the free in the replacement delete once it is inlined next to a new
+// expression, although the replacement pair is consistent
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t sz) {
+  alloc_cnt.fetch_add(1u, std::memory_order_relaxed);
+  if (void* p = std::malloc(sz == 0u ? 1u : sz)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+SCENARIO ( "Handler memory test", "[handler_allocator]" ) {
+
+  using chops::net::detail::handler_memory;
+
+  GIVEN ("A handler memory object") {
+    handler_memory mem;
+    WHEN ("allocations fit in the slots") {
+      void* ptrs[handler_memory::num_slots];
+      for (auto& p : ptrs) {
+        p = mem.allocate(handler_memory::slot_size);
+      }
+      THEN ("the slots are used, then the heap is used, and a freed slot is reused") {
+        REQUIRE (mem.heap_allocs() == 0u);
+        void* extra = mem.allocate(8u);
+        REQUIRE (mem.heap_allocs() == 1u);
+        mem.deallocate(extra);
+        mem.deallocate(ptrs[1]);
+        REQUIRE (mem.allocate(8u) == ptrs[1]);
+        REQUIRE (mem.heap_allocs() == 1u);
+        for (auto p : ptrs) {
+          mem.deallocate(p);
+        }
+      }
+    }
+    AND_WHEN ("an allocation is larger than a slot") {
+      void* p = mem.allocate(handler_memory::slot_size + 1u);
+      THEN ("the heap is used") {
+        REQUIRE (mem.heap_allocs() == 1u);
+        mem.deallocate(p);
+      }
+    }
+  } // end given
+}
+
+struct alloc_counts {
+  std::size_t num_rcvd = 0u;
+  std::size_t num_allocs = 0u;
+};
+
+// each message is sent after the previous one is received, the allocations are
+// counted after a warm up
+alloc_counts tcp_send_recv_allocs(std::size_t msg_size, std::size_t warm_up_msgs, 
+                                  std::size_t num_msgs) {
+
+  using tcp_io = chops::net::detail::tcp_io;
+
+  asio::io_context ioc;
+  auto wg = asio::make_work_guard(ioc);
+  std::thread run_thr([&ioc] () { ioc.run(); } );
+
+  asio::ip::tcp::acceptor acc(ioc, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0));
+  asio::ip::tcp::socket cli_sock(ioc);
+  cli_sock.connect(acc.local_endpoint());
+  asio::ip::tcp::socket srv_sock(ioc);
+  acc.accept(srv_sock);
+
+  auto notify = [] (std::error_code, std::shared_ptr<tcp_io>) { };
+  auto srv = std::make_shared<tcp_io>(std::move(srv_sock), notify);
+  auto cli = std::make_shared<tcp_io>(std::move(cli_sock), notify);
+
+  std::atomic_size_t rcv_cnt { 0u };
+  srv->start_io(msg_size, [&rcv_cnt] (asio::const_buffer, chops::net::tcp_io_interface,
+                                      asio::ip::tcp::endpoint) {
+      rcv_cnt.fetch_add(1u, std::memory_order_release);
+      return true;
+    } );
+  cli->start_io();
+
+  chops::mutable_shared_buffer mb(msg_size);
+  chops::const_shared_buffer buf(std::move(mb));
+
+  auto send_msgs = [&cli, &buf, &rcv_cnt] (std::size_t n) {
+    for (std::size_t i = 0u; i < n; ++i) {
+      auto target = rcv_cnt.load(std::memory_order_acquire) + 1u;
+      cli->send(buf);
+      while (rcv_cnt.load(std::memory_order_acquire) != target) {
+        std::this_thread::yield();
+      }
+    }
+  };
+
+  send_msgs(warm_up_msgs);
+  auto before = alloc_cnt.load();
+  send_msgs(num_msgs);
+  alloc_counts cnts { rcv_cnt.load(), alloc_cnt.load() - before };
+
+  srv->close();
+  cli->close();
+  wg.reset();
+  srv.reset();
+  cli.reset();
+  run_thr.join();
+  return cnts;
+}
+
+// each datagram is sent after the previous one is received, the allocations are
+// counted after a warm up
+alloc_counts udp_send_recv_allocs(std::size_t msg_size, std::size_t warm_up_msgs, 
+                                  std::size_t num_msgs) {
+
+  using udp_entity_io = chops::net::detail::udp_entity_io;
+
+  asio::io_context ioc;
+  auto wg = asio::make_work_guard(ioc);
+  std::thread run_thr([&ioc] () { ioc.run(); } );
+
+  auto srv = std::make_shared<udp_entity_io>(ioc, 
+                     asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 0));
+  auto cli = std::make_shared<udp_entity_io>(ioc, asio::ip::udp::endpoint());
+
+  std::atomic_size_t rcv_cnt { 0u };
+  auto err_cb = [] (chops::net::udp_io_interface, std::error_code) { };
+  srv->start([&rcv_cnt, msg_size] (chops::net::udp_io_interface io, std::size_t, bool starting) {
+      if (starting) {
+        io.start_io(msg_size, [&rcv_cnt] (asio::const_buffer, chops::net::udp_io_interface,
+                                          asio::ip::udp::endpoint) {
+            rcv_cnt.fetch_add(1u, std::memory_order_release);
+            return true;
+          } );
+      }
+    }, err_cb);
+  auto dest = srv->get_socket().local_endpoint();
+  cli->start([dest] (chops::net::udp_io_interface io, std::size_t, bool starting) {
+      if (starting) {
+        io.start_io(dest);
+      }
+    }, err_cb);
+
+  chops::mutable_shared_buffer mb(msg_size);
+  chops::const_shared_buffer buf(std::move(mb));
+
+  auto send_msgs = [&cli, &buf, &rcv_cnt] (std::size_t n) {
+    for (std::size_t i = 0u; i < n; ++i) {
+      auto target = rcv_cnt.load(std::memory_order_acquire) + 1u;
+      cli->send(buf);
+      while (rcv_cnt.load(std::memory_order_acquire) != target) {
+        std::this_thread::yield();
+      }
+    }
+  };
+
+  send_msgs(warm_up_msgs);
+  auto before = alloc_cnt.load();
+  send_msgs(num_msgs);
+  alloc_counts cnts { rcv_cnt.load(), alloc_cnt.load() - before };
+
+  srv->stop();
+  cli->stop();
+  wg.reset();
+  srv.reset();
+  cli.reset();
+  run_thr.join();
+  return cnts;
+}
+
+SCENARIO ( "Handler allocator test, steady state TCP send and receive allocations",
+           "[handler_allocator] [tcp_io]" ) {
+
+  constexpr std::size_t warm_up_msgs = 200u;
+  constexpr std::size_t num_msgs = 2000u;
+
+  GIVEN ("A connected pair of tcp_io objects, one receiving fixed size messages") {
+    WHEN ("messages are sent and received after a warm up") {
+      auto cnts = tcp_send_recv_allocs(32u, warm_up_msgs, num_msgs);
+      THEN ("there are no heap allocations") {
+        REQUIRE (cnts.num_rcvd == (warm_up_msgs + num_msgs));
+        REQUIRE (cnts.num_allocs == 0u);
+      }
+    }
+  } // end given
+}
+
+SCENARIO ( "Handler allocator test, steady state UDP send and receive allocations",
+           "[handler_allocator] [udp_io]" ) {
+
+  constexpr std::size_t warm_up_msgs = 200u;
+  constexpr std::size_t num_msgs = 2000u;
+
+  GIVEN ("A pair of udp_entity_io objects on the loopback interface, one receiving") {
+    WHEN ("datagrams are sent and received after a warm up") {
+      auto cnts = udp_send_recv_allocs(32u, warm_up_msgs, num_msgs);
+      THEN ("there are no heap allocations") {
+        REQUIRE (cnts.num_rcvd == (warm_up_msgs + num_msgs));
+        REQUIRE (cnts.num_allocs == 0u);
+      }
+    }
+  } // end given
+}
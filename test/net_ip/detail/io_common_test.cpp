@@ -20,6 +20,14 @@
 #include <memory> // std::shared_ptr
 #include <system_error> // std::error_code
 #include <utility> // std::move
+#include <thread>
+#include <vector>
+#include <array>
+#include <atomic>
+#include <algorithm> // std::sort
+#include <numeric> // std::iota
+#include <cstring> // std::memcpy
+#include <cstddef> // std::byte
 
 #include "net_ip/detail/output_queue.hpp"
 #include "net_ip/detail/io_common.hpp"
@@ -33,6 +41,7 @@ void io_common_test(chops::const_shared_buffer buf, int num_bufs,
                     typename IOT::endpoint_type endp) {
 
   using namespace std::placeholders;
+  using push_result = typename chops::net::detail::io_common<IOT>::push_result;
 
   REQUIRE (num_bufs > 1);
 
@@ -123,6 +132,8 @@ void io_common_test(chops::const_shared_buffer buf, int num_bufs,
         auto qs = iocommon.get_output_queue_stats();
         REQUIRE (qs.output_queue_size == 1);
         REQUIRE (qs.bytes_in_output_queue == buf.size());
+        REQUIRE (iocommon.output_queue_size() == 1);
+        REQUIRE (iocommon.bytes_in_output_queue() == buf.size());
 
         auto e = iocommon.get_next_element();
 
@@ -143,6 +154,237 @@ void io_common_test(chops::const_shared_buffer buf, int num_bufs,
       }
     }
 
+    AND_WHEN ("Start_write_setup is called many times and get_next_elements gathers the queue") {
+      bool ret = iocommon.set_io_started();
+      REQUIRE (ret);
+      chops::repeat(num_bufs, [&iocommon, &buf] () { 
+          iocommon.start_write_setup(buf);
+        }
+      );
+      typename chops::net::detail::io_common<IOT>::buf_vec bufs;
+      auto cnt = iocommon.get_next_elements(bufs, num_bufs, 0);
+      THEN ("all queued bufs are returned, and write_in_progress is false after the next call") {
+        REQUIRE (cnt == (num_bufs-1));
+        REQUIRE (bufs.size() == cnt);
+        REQUIRE (iocommon.is_write_in_progress());
+        REQUIRE (iocommon.get_output_queue_stats().output_queue_size == 0);
+        REQUIRE (iocommon.get_next_elements(bufs, num_bufs, 0) == 0);
+        REQUIRE_FALSE (iocommon.is_write_in_progress());
+      }
+    }
+
+    AND_WHEN ("Push_send is called many times and drain_sends is called") {
+      bool ret = iocommon.set_io_started();
+      REQUIRE (ret);
+      REQUIRE (iocommon.push_send(buf) == push_result::post_drain);
+      chops::repeat((num_bufs - 1), [&iocommon, &buf, &endp] () { 
+          REQUIRE (iocommon.push_send(buf, endp) == push_result::pending);
+        }
+      );
+      auto e = iocommon.drain_sends();
+      THEN ("the first buf is returned and the rest are queued in order") {
+        REQUIRE (e);
+        REQUIRE (e->first == buf);
+        REQUIRE_FALSE (e->second);
+        REQUIRE (iocommon.is_write_in_progress());
+        REQUIRE (iocommon.get_output_queue_stats().output_queue_size == (num_bufs-1));
+        auto e2 = iocommon.get_next_element();
+        REQUIRE (e2);
+        REQUIRE (e2->second == endp);
+        REQUIRE_FALSE (iocommon.drain_sends());
+        REQUIRE (iocommon.push_send(buf) == push_result::post_drain);
+      }
+    }
+
+    AND_WHEN ("Push_send is called before set_io_started and drain_sends is called") {
+      REQUIRE (iocommon.push_send(buf) == push_result::post_drain);
+      REQUIRE (iocommon.push_send(buf) == push_result::pending);
+      auto e = iocommon.drain_sends();
+      THEN ("the bufs are dropped") {
+        REQUIRE_FALSE (e);
+        REQUIRE_FALSE (iocommon.is_write_in_progress());
+        REQUIRE (iocommon.get_output_queue_stats().output_queue_size == 0);
+        REQUIRE (iocommon.push_send(buf) == push_result::post_drain);
+      }
+    }
+
+    AND_WHEN ("Push_send is called concurrently from multiple threads") {
+      bool ret = iocommon.set_io_started();
+      REQUIRE (ret);
+      constexpr int num_thrs = 4;
+      std::vector<std::thread> thrs;
+      std::atomic_int num_empty_to_non_empty { 0 };
+      for (int i = 0; i < num_thrs; ++i) {
+        thrs.emplace_back([&iocommon, &buf, &num_empty_to_non_empty, num_bufs] () {
+            chops::repeat(num_bufs, [&] () { 
+                if (iocommon.push_send(buf) == push_result::post_drain) {
+                  ++num_empty_to_non_empty;
+                }
+              }
+            );
+          }
+        );
+      }
+      for (auto& t : thrs) {
+        t.join();
+      }
+      auto e = iocommon.drain_sends();
+      THEN ("exactly one push saw the empty queue and all bufs are drained") {
+        REQUIRE (num_empty_to_non_empty == 1);
+        REQUIRE (e);
+        REQUIRE (iocommon.get_output_queue_stats().output_queue_size == (num_thrs*num_bufs-1));
+      }
+    }
+
+    AND_WHEN ("Push_send is called concurrently while drain_sends is called in a loop") {
+      bool ret = iocommon.set_io_started();
+      REQUIRE (ret);
+      constexpr int num_thrs = 4;
+      const int num_ids = num_thrs * num_bufs * 50;
+      std::atomic_int num_post_drain { 0 };
+      std::atomic_bool producers_done { false };
+      std::vector<int> drained_ids;
+      int num_non_empty_drains = 0;
+
+      // each buf carries a unique id, the queue is emptied after each drain so that
+      // every non-empty drain returns its first element
+      auto drain = [&iocommon, &drained_ids, &num_non_empty_drains] () {
+        auto e = iocommon.drain_sends();
+        if (!e) {
+          return;
+        }
+        ++num_non_empty_drains;
+        for (; e; e = iocommon.get_next_element()) {
+          int id;
+          std::memcpy(&id, e->first.data(), sizeof(id));
+          drained_ids.push_back(id);
+        }
+      };
+      std::thread consumer([&drain, &producers_done] () {
+          while (!producers_done) {
+            drain();
+          }
+        }
+      );
+      std::vector<std::thread> thrs;
+      for (int i = 0; i < num_thrs; ++i) {
+        thrs.emplace_back([&iocommon, &num_post_drain, i, num_ids] () {
+            for (int id = i; id < num_ids; id += num_thrs) {
+              std::array<std::byte, sizeof(int)> ba;
+              std::memcpy(ba.data(), &id, sizeof(id));
+              if (iocommon.push_send(chops::const_shared_buffer(ba.data(), ba.size())) ==
+                  push_result::post_drain) {
+                ++num_post_drain;
+              }
+            }
+          }
+        );
+      }
+      for (auto& t : thrs) {
+        t.join();
+      }
+      producers_done = true;
+      consumer.join();
+      drain();
+      THEN ("every buf is drained exactly once and each post_drain matches one non-empty drain") {
+        std::sort(drained_ids.begin(), drained_ids.end());
+        std::vector<int> expected_ids(num_ids);
+        std::iota(expected_ids.begin(), expected_ids.end(), 0);
+        REQUIRE (drained_ids == expected_ids);
+        REQUIRE (num_post_drain == num_non_empty_drains);
+        REQUIRE (iocommon.get_output_queue_stats().output_queue_size == 0);
+        REQUIRE (iocommon.push_send(buf) == push_result::post_drain);
+      }
+    }
+
+    AND_WHEN ("Output queue limits with the reject policy are set and bufs are pushed") {
+      bool ret = iocommon.set_io_started();
+      REQUIRE (ret);
+      chops::net::output_queue_limits lim;
+      lim.max_bufs = num_bufs;
+      iocommon.set_output_queue_limits(lim);
+      chops::repeat(num_bufs, [&iocommon, &buf] () { 
+          REQUIRE (iocommon.push_send(buf) != push_result::rejected);
+        }
+      );
+      THEN ("a push beyond the limit is rejected and counted") {
+        REQUIRE (iocommon.push_send(buf) == push_result::rejected);
+        REQUIRE (iocommon.get_output_queue_stats().bufs_dropped == 1);
+        REQUIRE (iocommon.drain_sends());
+        REQUIRE (iocommon.push_send(buf) == push_result::post_drain);
+      }
+    }
+
+    AND_WHEN ("Bufs of different priorities are drained together with no write in progress") {
+      bool ret = iocommon.set_io_started();
+      REQUIRE (ret);
+      auto hi_ba = chops::make_byte_array(0x7F);
+      chops::const_shared_buffer hi_buf(hi_ba.data(), hi_ba.size());
+      auto mid_ba = chops::make_byte_array(0x3F, 0x3F);
+      chops::const_shared_buffer mid_buf(mid_ba.data(), mid_ba.size());
+      REQUIRE (iocommon.push_send(buf) == push_result::post_drain);
+      iocommon.push_send(mid_buf, std::size_t{1u});
+      iocommon.push_send(hi_buf, chops::net::num_send_priorities - 1u);
+      iocommon.push_send(hi_buf, chops::net::num_send_priorities + 5u); // clamped to the top lane
+      iocommon.push_send(buf);
+      auto e = iocommon.drain_sends();
+      THEN ("the oldest buf in the highest lane is written first, the rest by priority") {
+        REQUIRE (e);
+        REQUIRE (e->first == hi_buf);
+        REQUIRE (iocommon.get_output_queue_stats().output_queue_size == 4u);
+        e = iocommon.get_next_element();
+        REQUIRE (e->first == hi_buf);
+        e = iocommon.get_next_element();
+        REQUIRE (e->first == mid_buf);
+        e = iocommon.get_next_element();
+        REQUIRE (e->first == buf);
+        e = iocommon.get_next_element();
+        REQUIRE (e->first == buf);
+        REQUIRE_FALSE (iocommon.get_next_element());
+      }
+    }
+
+    AND_WHEN ("Bufs are pushed with different priorities while a write is in progress") {
+      bool ret = iocommon.set_io_started();
+      REQUIRE (ret);
+      REQUIRE (iocommon.push_send(buf) == push_result::post_drain);
+      REQUIRE (iocommon.drain_sends()); // first buf is written, the rest are queued
+      auto hi_ba = chops::make_byte_array(0x7F);
+      chops::const_shared_buffer hi_buf(hi_ba.data(), hi_ba.size());
+      chops::repeat(num_bufs, [&iocommon, &buf] () { iocommon.push_send(buf); } );
+      iocommon.push_send(hi_buf, chops::net::num_send_priorities - 1u);
+      iocommon.drain_sends();
+      THEN ("the higher priority buf is the next element, and lane stats are reported") {
+        auto qs = iocommon.get_output_queue_stats();
+        REQUIRE (qs.lane_queue_size[0] == static_cast<std::size_t>(num_bufs));
+        REQUIRE (qs.lane_queue_size[chops::net::num_send_priorities - 1u] == 1u);
+        REQUIRE (qs.lane_bytes_in_queue[chops::net::num_send_priorities - 1u] == hi_buf.size());
+        auto e = iocommon.get_next_element();
+        REQUIRE (e);
+        REQUIRE (e->first == hi_buf);
+        e = iocommon.get_next_element();
+        REQUIRE (e);
+        REQUIRE (e->first == buf);
+        REQUIRE (iocommon.get_output_queue_stats().lane_queue_size[chops::net::num_send_priorities - 1u] == 0u);
+      }
+    }
+
+    AND_WHEN ("Output queue limits with the close policy are set and too many bufs are pushed") {
+      bool ret = iocommon.set_io_started();
+      REQUIRE (ret);
+      chops::net::output_queue_limits lim;
+      lim.max_bufs = num_bufs;
+      lim.policy = chops::net::queue_overflow_policy::close;
+      iocommon.set_output_queue_limits(lim);
+      chops::repeat(num_bufs + 2, [&iocommon, &buf] () { iocommon.push_send(buf); } );
+      iocommon.drain_sends();
+      THEN ("an overflow event is returned once") {
+        REQUIRE (iocommon.output_queue_event() == 
+                 std::make_error_code(chops::net::net_ip_errc::output_queue_overflow));
+        REQUIRE_FALSE (iocommon.output_queue_event());
+      }
+    }
+
   } // end given
 }
 
@@ -16,6 +16,9 @@
 #include "catch2/catch.hpp"
 
 #include <utility> // std::move
+#include <vector>
+#include <cstdint> // std::uint64_t
+#include <optional> // std::nullopt
 
 #include <asio/ip/udp.hpp> // endpoint declarations
 #include <asio/ip/tcp.hpp> // endpoint declarations
@@ -84,6 +87,387 @@ void get_next_element_test(chops::const_shared_buffer buf, int num_bufs,
   } // end given
 }
 
+template <typename E>
+void get_next_elements_test(chops::const_shared_buffer buf, int num_bufs) {
+
+  GIVEN ("A default constructed output_queue and a vector of bufs") {
+    chops::net::detail::output_queue<E> outq { };
+    std::vector<chops::const_shared_buffer> bufs;
+
+    WHEN ("Bufs are added and then gathered with a buffer limit") {
+      chops::repeat(num_bufs, [&outq, &buf] () { outq.add_element(buf); } );
+      auto cnt = outq.get_next_elements(bufs, num_bufs - 1, 0);
+      THEN ("all but one buf are gathered and the queue_stats match") {
+        REQUIRE (cnt == (num_bufs - 1));
+        REQUIRE (bufs.size() == cnt);
+        REQUIRE (bufs.front() == buf);
+        auto qs = outq.get_queue_stats();
+        REQUIRE (qs.output_queue_size == 1);
+        REQUIRE (qs.bytes_in_output_queue == buf.size());
+      }
+    }
+    AND_WHEN ("Bufs are added and then gathered with a byte limit") {
+      chops::repeat(num_bufs, [&outq, &buf] () { outq.add_element(buf); } );
+      auto cnt = outq.get_next_elements(bufs, num_bufs, 2 * buf.size() + 1);
+      THEN ("only the bufs that fit in the byte limit are gathered") {
+        REQUIRE (cnt == 2);
+        REQUIRE (outq.get_queue_stats().output_queue_size == (num_bufs - 2));
+      }
+    }
+    AND_WHEN ("A byte limit smaller than one buf is used") {
+      chops::repeat(num_bufs, [&outq, &buf] () { outq.add_element(buf); } );
+      auto cnt = outq.get_next_elements(bufs, num_bufs, 1);
+      THEN ("one buf is still gathered") {
+        REQUIRE (cnt == 1);
+      }
+    }
+    AND_WHEN ("The queue is empty") {
+      auto cnt = outq.get_next_elements(bufs, num_bufs, 0);
+      THEN ("nothing is gathered") {
+        REQUIRE (cnt == 0);
+        REQUIRE (bufs.empty());
+      }
+    }
+  } // end given
+}
+
+template <typename E>
+void sent_stats_test(chops::const_shared_buffer buf, int num_bufs) {
+
+  GIVEN ("A default constructed output_queue") {
+    chops::net::detail::output_queue<E> outq { };
+
+    WHEN ("Bufs are added and removed, an unqueued buf is written, then the write completes") {
+      chops::repeat(num_bufs, [&outq, &buf] () { outq.add_element(buf); } );
+      chops::repeat(num_bufs, [&outq] () { outq.get_next_element(); } );
+      std::vector<chops::const_shared_buffer> bufs;
+      chops::repeat(num_bufs, [&outq, &buf] () { outq.add_element(buf); } );
+      outq.get_next_elements(bufs, num_bufs, 0);
+      outq.write_started(buf.size(), chops::net::detail::output_queue<E>::clock_type::now());
+      auto qs_before = outq.get_queue_stats();
+      outq.write_completed();
+      THEN ("the bufs are recorded on write completion and the counts, peak size and histogram match") {
+        REQUIRE (qs_before.total_bufs_sent == 0);
+        REQUIRE (qs_before.dwell_time_ns.total_count() == 0);
+        auto qs = outq.get_queue_stats();
+        REQUIRE (qs.output_queue_size == 0);
+        REQUIRE (qs.total_bufs_sent == (2 * num_bufs + 1));
+        REQUIRE (qs.total_bytes_sent == ((2 * num_bufs + 1) * buf.size()));
+        REQUIRE (qs.peak_output_queue_size == num_bufs);
+        REQUIRE (qs.dwell_time_ns.total_count() == (2 * num_bufs + 1));
+        REQUIRE (qs.dwell_time_ns.value_at_percentile(100.0) > 0);
+      }
+    }
+  } // end given
+}
+
+template <typename E>
+void limits_test(chops::const_shared_buffer buf, int num_bufs) {
+
+  using outq_type = chops::net::detail::output_queue<E>;
+  using add_result = typename outq_type::add_result;
+  using water_mark_chg = typename outq_type::water_mark_chg;
+
+  REQUIRE (num_bufs > 2);
+
+  GIVEN ("An output_queue with a buffer limit") {
+    outq_type outq { };
+    chops::net::output_queue_limits lim;
+    lim.max_bufs = num_bufs;
+
+    WHEN ("The drop_newest policy is set and more bufs than the limit are added") {
+      lim.policy = chops::net::queue_overflow_policy::drop_newest;
+      outq.set_limits(lim);
+      chops::repeat(num_bufs, [&outq, &buf] () { 
+          REQUIRE (outq.add_element(buf) == add_result::queued);
+        }
+      );
+      auto ret = outq.add_element(buf);
+      THEN ("the new buf is dropped and counted") {
+        REQUIRE (ret == add_result::dropped);
+        auto qs = outq.get_queue_stats();
+        REQUIRE (qs.output_queue_size == num_bufs);
+        REQUIRE (qs.bufs_dropped == 1);
+      }
+    }
+    AND_WHEN ("The drop_oldest policy is set and more bufs than the limit are added") {
+      lim.policy = chops::net::queue_overflow_policy::drop_oldest;
+      outq.set_limits(lim);
+      chops::repeat(num_bufs, [&outq] () { 
+          outq.add_element(chops::const_shared_buffer(nullptr, 0));
+        }
+      );
+      auto ret = outq.add_element(buf);
+      THEN ("the oldest buf is dropped and the new buf is at the back of the queue") {
+        REQUIRE (ret == add_result::queued);
+        auto qs = outq.get_queue_stats();
+        REQUIRE (qs.output_queue_size == num_bufs);
+        REQUIRE (qs.bytes_in_output_queue == buf.size());
+        REQUIRE (qs.bufs_dropped == 1);
+      }
+    }
+    AND_WHEN ("The close policy is set and more bufs than the limit are added") {
+      lim.policy = chops::net::queue_overflow_policy::close;
+      outq.set_limits(lim);
+      chops::repeat(num_bufs, [&outq, &buf] () { outq.add_element(buf); } );
+      auto ret = outq.add_element(buf);
+      THEN ("an overflow is returned") {
+        REQUIRE (ret == add_result::overflow);
+        REQUIRE (outq.get_queue_stats().output_queue_size == num_bufs);
+      }
+    }
+    AND_WHEN ("The reject policy is set and the queue is at the limit") {
+      outq.set_limits(lim);
+      chops::repeat(num_bufs - 1, [&outq, &buf] () { outq.add_element(buf); } );
+      THEN ("a send is rejected only when pending bufs would exceed the limit") {
+        REQUIRE_FALSE (outq.reject(1, buf.size()));
+        REQUIRE (outq.reject(2, 2 * buf.size()));
+      }
+    }
+  } // end given
+
+  GIVEN ("An output_queue with a byte limit and water marks") {
+    outq_type outq { };
+    chops::net::output_queue_limits lim;
+    lim.max_bytes = num_bufs * buf.size();
+    lim.policy = chops::net::queue_overflow_policy::drop_newest;
+    lim.high_water_mark = (num_bufs - 1) * buf.size();
+    lim.low_water_mark = buf.size();
+    outq.set_limits(lim);
+
+    WHEN ("Bufs are added up to the byte limit and then removed") {
+      THEN ("a high water mark change happens once, then a low water mark change") {
+        REQUIRE (outq.water_mark_check() == water_mark_chg::none);
+        chops::repeat(num_bufs - 1, [&outq, &buf] () { outq.add_element(buf); } );
+        REQUIRE (outq.water_mark_check() == water_mark_chg::high);
+        outq.add_element(buf);
+        REQUIRE (outq.water_mark_check() == water_mark_chg::none);
+        REQUIRE (outq.add_element(buf) == add_result::dropped);
+        chops::repeat(num_bufs - 2, [&outq] () { outq.get_next_element(); } );
+        REQUIRE (outq.water_mark_check() == water_mark_chg::none);
+        outq.get_next_element();
+        REQUIRE (outq.water_mark_check() == water_mark_chg::low);
+        REQUIRE (outq.water_mark_check() == water_mark_chg::none);
+      }
+    }
+  } // end given
+}
+
+template <typename E>
+void conflation_test() {
+
+  using outq_type = chops::net::detail::output_queue<E>;
+  using add_result = typename outq_type::add_result;
+
+  // the first byte is the key, the second byte the update number
+  auto make_buf = [] (int key, int upd) {
+    auto ba = chops::make_byte_array(key, upd, 0x00);
+    return chops::const_shared_buffer(ba.data(), upd == 0 ? 2 : ba.size());
+  };
+  auto key_of = [] (const chops::const_shared_buffer& buf) {
+    return static_cast<std::size_t>(buf.data()[0]);
+  };
+  auto upd_of = [] (const chops::const_shared_buffer& buf) {
+    return static_cast<int>(buf.data()[1]);
+  };
+
+  GIVEN ("An output_queue with a conflation key function") {
+    outq_type outq { };
+    outq.set_key_func(key_of);
+
+    WHEN ("Bufs with repeated keys are added") {
+      REQUIRE (outq.add_element(make_buf(1, 0)) == add_result::queued);
+      REQUIRE (outq.add_element(make_buf(2, 0)) == add_result::queued);
+      REQUIRE (outq.add_element(make_buf(1, 1)) == add_result::conflated);
+      REQUIRE (outq.add_element(make_buf(3, 0)) == add_result::queued);
+      REQUIRE (outq.add_element(make_buf(2, 1)) == add_result::conflated);
+      REQUIRE (outq.add_element(make_buf(1, 2)) == add_result::conflated);
+      THEN ("each key is queued once, in first queued order, with the latest buf") {
+        auto qs = outq.get_queue_stats();
+        REQUIRE (qs.output_queue_size == 3u);
+        REQUIRE (qs.bytes_in_output_queue == 8u);
+        REQUIRE (qs.bufs_dropped == 3u);
+        std::vector<chops::const_shared_buffer> bufs;
+        REQUIRE (outq.get_next_elements(bufs, 2u, 0u) == 2u);
+        REQUIRE (key_of(bufs[0]) == 1u);
+        REQUIRE (upd_of(bufs[0]) == 2);
+        REQUIRE (key_of(bufs[1]) == 2u);
+        REQUIRE (upd_of(bufs[1]) == 1);
+        // key 1 is no longer queued, key 3 still is
+        REQUIRE (outq.add_element(make_buf(1, 3)) == add_result::queued);
+        REQUIRE (outq.add_element(make_buf(3, 1)) == add_result::conflated);
+        auto e = outq.get_next_element();
+        REQUIRE (e);
+        REQUIRE (key_of(e->first) == 3u);
+        REQUIRE (upd_of(e->first) == 1);
+        e = outq.get_next_element();
+        REQUIRE (e);
+        REQUIRE (key_of(e->first) == 1u);
+        REQUIRE (upd_of(e->first) == 3);
+        REQUIRE_FALSE (outq.get_next_element());
+        REQUIRE (outq.get_queue_stats().bytes_in_output_queue == 0u);
+      }
+    }
+    AND_WHEN ("A larger buf replaces a queued buf at the byte limit, drop_newest policy") {
+      chops::net::output_queue_limits lim;
+      lim.max_bytes = 4u;
+      lim.policy = chops::net::queue_overflow_policy::drop_newest;
+      outq.set_limits(lim);
+      outq.add_element(make_buf(1, 0));
+      outq.add_element(make_buf(2, 0));
+      THEN ("the new buf is dropped and the queued buf is kept") {
+        REQUIRE (outq.add_element(make_buf(1, 1)) == add_result::dropped);
+        auto qs = outq.get_queue_stats();
+        REQUIRE (qs.bytes_in_output_queue == 4u);
+        REQUIRE (qs.bufs_dropped == 1u);
+        auto e = outq.get_next_element();
+        REQUIRE (upd_of(e->first) == 0);
+      }
+    }
+    AND_WHEN ("A larger buf replaces a queued buf at the byte limit, close policy") {
+      chops::net::output_queue_limits lim;
+      lim.max_bytes = 4u;
+      lim.policy = chops::net::queue_overflow_policy::close;
+      outq.set_limits(lim);
+      outq.add_element(make_buf(1, 0));
+      outq.add_element(make_buf(2, 0));
+      THEN ("an overflow is returned") {
+        REQUIRE (outq.add_element(make_buf(2, 1)) == add_result::overflow);
+        REQUIRE (outq.get_queue_stats().bytes_in_output_queue == 4u);
+      }
+    }
+    AND_WHEN ("A larger buf replaces a queued buf at the byte limit, drop_oldest policy") {
+      chops::net::output_queue_limits lim;
+      lim.max_bytes = 4u;
+      lim.policy = chops::net::queue_overflow_policy::drop_oldest;
+      outq.set_limits(lim);
+      outq.add_element(make_buf(1, 0));
+      outq.add_element(make_buf(2, 0));
+      THEN ("older bufs are dropped so the limit is not exceeded") {
+        // key 1 is older than key 2, so it is dropped to make room
+        REQUIRE (outq.add_element(make_buf(2, 1)) == add_result::conflated);
+        auto qs = outq.get_queue_stats();
+        REQUIRE (qs.output_queue_size == 1u);
+        REQUIRE (qs.bytes_in_output_queue == 3u);
+        REQUIRE (qs.bufs_dropped == 2u);
+        auto e = outq.get_next_element();
+        REQUIRE (key_of(e->first) == 2u);
+        REQUIRE (upd_of(e->first) == 1);
+      }
+    }
+    AND_WHEN ("A larger buf replaces the oldest queued buf at the byte limit, drop_oldest policy") {
+      chops::net::output_queue_limits lim;
+      lim.max_bytes = 2u;
+      lim.policy = chops::net::queue_overflow_policy::drop_oldest;
+      outq.set_limits(lim);
+      outq.add_element(make_buf(1, 0));
+      THEN ("the queued buf is dropped and the new buf is queued") {
+        REQUIRE (outq.add_element(make_buf(1, 1)) == add_result::queued);
+        auto qs = outq.get_queue_stats();
+        REQUIRE (qs.output_queue_size == 1u);
+        REQUIRE (qs.bytes_in_output_queue == 3u);
+        REQUIRE (qs.bufs_dropped == 1u);
+        auto e = outq.get_next_element();
+        REQUIRE (upd_of(e->first) == 1);
+        REQUIRE_FALSE (outq.get_next_element());
+      }
+    }
+    AND_WHEN ("The key function is removed") {
+      outq.set_key_func(chops::net::output_queue_key_func());
+      outq.add_element(make_buf(1, 0));
+      THEN ("bufs with the same key are all queued") {
+        REQUIRE (outq.add_element(make_buf(1, 1)) == add_result::queued);
+        REQUIRE (outq.get_queue_stats().output_queue_size == 2u);
+      }
+    }
+  } // end given
+}
+
+template <typename E>
+void priority_test(chops::const_shared_buffer buf, int num_bufs) {
+
+  using outq_type = chops::net::detail::output_queue<E>;
+  using queue_element = typename outq_type::queue_element;
+  constexpr std::size_t top = chops::net::num_send_priorities - 1u;
+
+  auto hi_ba = chops::make_byte_array(0x7F);
+  chops::const_shared_buffer hi_buf(hi_ba.data(), hi_ba.size());
+  auto now = outq_type::clock_type::now();
+
+  GIVEN ("An output_queue with bufs queued in the lowest and highest lanes") {
+    outq_type outq { };
+    chops::repeat(num_bufs, [&outq, &buf] () { outq.add_element(buf); } );
+    outq.add_element(queue_element(hi_buf, std::nullopt), now, top);
+    outq.add_element(queue_element(hi_buf, std::nullopt), now, top + 10u);
+
+    WHEN ("The queue stats are retrieved") {
+      auto qs = outq.get_queue_stats();
+      THEN ("the totals and lane values are correct") {
+        REQUIRE (qs.output_queue_size == static_cast<std::size_t>(num_bufs + 2));
+        REQUIRE (qs.lane_queue_size[0] == static_cast<std::size_t>(num_bufs));
+        REQUIRE (qs.lane_bytes_in_queue[0] == num_bufs * buf.size());
+        REQUIRE (qs.lane_queue_size[top] == 2u);
+        REQUIRE (qs.lane_bytes_in_queue[top] == 2u * hi_buf.size());
+      }
+    }
+    AND_WHEN ("Bufs are gathered") {
+      std::vector<chops::const_shared_buffer> bufs;
+      auto cnt = outq.get_next_elements(bufs, 3u, 0u);
+      THEN ("the highest lane bufs are first, followed by the lower lane bufs") {
+        REQUIRE (cnt == 3u);
+        REQUIRE (bufs[0] == hi_buf);
+        REQUIRE (bufs[1] == hi_buf);
+        REQUIRE (bufs[2] == buf);
+        REQUIRE (outq.get_queue_stats().lane_queue_size[top] == 0u);
+      }
+    }
+    AND_WHEN ("The drop_oldest policy is set and a high priority buf is added at the limit") {
+      chops::net::output_queue_limits lim;
+      lim.max_bufs = num_bufs + 2;
+      lim.policy = chops::net::queue_overflow_policy::drop_oldest;
+      outq.set_limits(lim);
+      outq.add_element(queue_element(hi_buf, std::nullopt), now, top);
+      THEN ("a buf is dropped from the lowest lane") {
+        auto qs = outq.get_queue_stats();
+        REQUIRE (qs.bufs_dropped == 1u);
+        REQUIRE (qs.lane_queue_size[0] == static_cast<std::size_t>(num_bufs - 1));
+        REQUIRE (qs.lane_queue_size[top] == 3u);
+      }
+    }
+  } // end given
+}
+
+SCENARIO ( "Queue dwell histogram test",
+           "[output_queue] [histogram]" ) {
+
+  using hist = chops::net::queue_dwell_histogram;
+
+  GIVEN ("Values on and around bucket boundaries") {
+    THEN ("each value is within the bounds of its bucket") {
+      for (std::uint64_t v : { 0ull, 1ull, 3ull, 4ull, 5ull, 7ull, 8ull, 15ull, 1000ull,
+                               1023ull, 1024ull, 123456789ull, (1ull << 39) + 1ull }) {
+        auto idx = hist::bucket_index(v);
+        INFO ("Value: " << v << ", bucket: " << idx);
+        REQUIRE (idx < hist::num_buckets);
+        REQUIRE (hist::bucket_lower_bound(idx) <= v);
+        REQUIRE (v < hist::bucket_lower_bound(idx + 1));
+      }
+      REQUIRE (hist::bucket_index(1ull << 50) == (hist::num_buckets - 1));
+    }
+  }
+  GIVEN ("A histogram with 100 recorded values") {
+    hist h;
+    h.counts[hist::bucket_index(10)] = 90;
+    h.counts[hist::bucket_index(100000)] = 10;
+    THEN ("percentiles fall in the correct buckets") {
+      REQUIRE (h.total_count() == 100);
+      REQUIRE (h.value_at_percentile(50.0) == hist::bucket_lower_bound(hist::bucket_index(10) + 1));
+      REQUIRE (h.value_at_percentile(99.0) > 100000);
+      REQUIRE (hist().value_at_percentile(50.0) == 0);
+    }
+  }
+}
+
 SCENARIO ( "Output_queue test, udp endpoint", 
            "[output_queue] [udp]" ) {
 
@@ -102,5 +486,10 @@ SCENARIO ( "Output_queue test, tcp endpoint",
   add_element_test<asio::ip::tcp::endpoint>(chops::const_shared_buffer(std::move(mb)), 30);
   get_next_element_test<asio::ip::tcp::endpoint>(chops::const_shared_buffer(std::move(mb)), 40,
                         asio::ip::tcp::endpoint(asio::ip::tcp::v6(), 9876));
+  get_next_elements_test<asio::ip::tcp::endpoint>(chops::const_shared_buffer(ba.data(), ba.size()), 25);
+  limits_test<asio::ip::tcp::endpoint>(chops::const_shared_buffer(ba.data(), ba.size()), 10);
+  sent_stats_test<asio::ip::tcp::endpoint>(chops::const_shared_buffer(ba.data(), ba.size()), 15);
+  conflation_test<asio::ip::tcp::endpoint>();
+  priority_test<asio::ip::tcp::endpoint>(chops::const_shared_buffer(ba.data(), ba.size()), 10);
 }
 
@@ -0,0 +1,130 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for @c reconnect_backoff detail class.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch.hpp"
+
+#include <chrono>
+#include <optional>
+
+#include "net_ip/detail/reconnect_backoff.hpp"
+#include "net_ip/reconnect_policy.hpp"
+
+using namespace std::chrono_literals;
+
+SCENARIO ( "Reconnect backoff test, fixed and exponential intervals", "[reconnect_backoff]" ) {
+
+  using chops::net::detail::reconnect_backoff;
+  using chops::net::reconnect_policy;
+
+  GIVEN ("A policy with no initial interval") {
+    reconnect_backoff bo(reconnect_policy { });
+    WHEN ("the next interval is requested") {
+      THEN ("no reconnect is attempted") {
+        REQUIRE_FALSE (bo.next_interval());
+      }
+    }
+  } // end given
+
+  GIVEN ("A policy with only an initial interval") {
+    reconnect_backoff bo(reconnect_policy { 100ms });
+    WHEN ("intervals are requested") {
+      THEN ("the interval is fixed and reconnects are unlimited") {
+        for (int i = 0; i < 10; ++i) {
+          auto intvl = bo.next_interval();
+          REQUIRE (intvl);
+          REQUIRE (*intvl == 100ms);
+        }
+        REQUIRE (bo.attempts() == 10u);
+      }
+    }
+  } // end given
+
+  GIVEN ("A policy with exponential growth and a max interval") {
+    reconnect_policy pol { 100ms, 1000ms };
+    reconnect_backoff bo(pol);
+    WHEN ("intervals are requested") {
+      THEN ("the interval doubles up to the max interval") {
+        REQUIRE (*bo.next_interval() == 100ms);
+        REQUIRE (*bo.next_interval() == 200ms);
+        REQUIRE (*bo.next_interval() == 400ms);
+        REQUIRE (*bo.next_interval() == 800ms);
+        REQUIRE (*bo.next_interval() == 1000ms);
+        REQUIRE (*bo.next_interval() == 1000ms);
+      }
+    }
+    AND_WHEN ("the backoff is reset") {
+      bo.next_interval();
+      bo.next_interval();
+      bo.reset();
+      THEN ("the interval starts over at the initial interval") {
+        REQUIRE (bo.attempts() == 0u);
+        REQUIRE (*bo.next_interval() == 100ms);
+      }
+    }
+  } // end given
+
+  GIVEN ("A policy with a max number of attempts") {
+    reconnect_policy pol { 10ms };
+    pol.max_attempts = 3u;
+    reconnect_backoff bo(pol);
+    WHEN ("intervals are requested") {
+      THEN ("no reconnect is attempted after the max attempts, until a reset") {
+        REQUIRE (bo.next_interval());
+        REQUIRE (bo.next_interval());
+        REQUIRE (bo.next_interval());
+        REQUIRE_FALSE (bo.next_interval());
+        bo.reset();
+        REQUIRE (bo.next_interval());
+      }
+    }
+  } // end given
+}
+
+SCENARIO ( "Reconnect backoff test, decorrelated jitter", "[reconnect_backoff]" ) {
+
+  using chops::net::detail::reconnect_backoff;
+  using chops::net::reconnect_policy;
+
+  GIVEN ("A policy with jitter") {
+    reconnect_policy pol { 100ms, 5000ms, 3.0, true };
+    WHEN ("many intervals are requested") {
+      reconnect_backoff bo(pol, 42u);
+      THEN ("each interval is between the initial interval and the multiple of the previous "
+            "interval, capped at the max interval") {
+        auto prev = pol.initial_interval;
+        bool varied = false;
+        for (int i = 0; i < 200; ++i) {
+          auto intvl = *bo.next_interval();
+          REQUIRE (intvl >= pol.initial_interval);
+          REQUIRE (intvl <= pol.max_interval);
+          REQUIRE (intvl <= prev * 3);
+          varied = varied || (intvl != prev);
+          prev = intvl;
+        }
+        REQUIRE (varied);
+      }
+    }
+    AND_WHEN ("two backoffs use the same seed") {
+      reconnect_backoff bo1(pol, 7u);
+      reconnect_backoff bo2(pol, 7u);
+      THEN ("the intervals are the same") {
+        for (int i = 0; i < 20; ++i) {
+          REQUIRE (*bo1.next_interval() == *bo2.next_interval());
+        }
+      }
+    }
+  } // end given
+}
+
@@ -289,3 +289,242 @@ SCENARIO ( "Tcp acceptor test,  LF msgs, two-way, interval 0, 25 connectors, man
                   std::string_view("\n"), make_empty_lf_text_msg() );
 
 }
+
+// admission control scenarios use raw client sockets, and poll the acceptor stats
+
+const unsigned short admission_test_port = 30457;
+
+template <typename Pred>
+bool wait_for (Pred pred) {
+  for (int i = 0; i < 500; ++i) {
+    if (pred()) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return false;
+}
+
+void start_admission_acceptor (const std::shared_ptr<chops::net::detail::tcp_acceptor>& acc_ptr) {
+  acc_ptr->start(
+    [] (chops::net::tcp_io_interface io, std::size_t, bool starting) {
+      if (starting) { // reads detect the client closing the connection
+        io.start_io(1, [] (asio::const_buffer, chops::net::tcp_io_interface, asio::ip::tcp::endpoint) {
+            return true;
+          }
+        );
+      }
+    },
+    [] (chops::net::tcp_io_interface, std::error_code) { }
+  );
+}
+
+std::vector<asio::ip::tcp::socket> connect_clients (asio::io_context& ioc, int num) {
+  asio::ip::tcp::endpoint endp(asio::ip::address_v4::loopback(), admission_test_port);
+  std::vector<asio::ip::tcp::socket> socks;
+  chops::repeat(num, [&] () {
+      socks.emplace_back(ioc);
+      socks.back().connect(endp); // completed by the kernel even when not accepted
+    }
+  );
+  return socks;
+}
+
+SCENARIO ( "Tcp acceptor test, admission control", "[tcp_acc] [accept_limits]" ) {
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+  asio::io_context cli_ioc;
+
+  asio::ip::tcp::endpoint endp(asio::ip::address_v4::loopback(), admission_test_port);
+  auto acc_ptr = std::make_shared<chops::net::detail::tcp_acceptor>(ioc, endp, true);
+
+  GIVEN ("An acceptor with a connection limit and the pause policy") {
+    chops::net::accept_limits lim;
+    lim.max_connections = 2;
+    REQUIRE (acc_ptr->set_accept_limits(lim));
+    start_admission_acceptor(acc_ptr);
+    REQUIRE_FALSE (acc_ptr->set_accept_limits(lim));
+
+    WHEN ("more clients than the limit connect, then one disconnects") {
+      auto socks = connect_clients(cli_ioc, 4);
+      auto at_limit = wait_for([&] () {
+          auto st = acc_ptr->get_accept_stats();
+          return st.total_accepted == 2u && st.connection_limit_pauses == 1u;
+        }
+      );
+      socks[0].close();
+      auto resumed = wait_for([&] () { return acc_ptr->get_accept_stats().total_accepted == 3u; } );
+      THEN ("accepting pauses at the limit and resumes when a connection closes") {
+        REQUIRE (at_limit);
+        REQUIRE (resumed);
+        auto st = acc_ptr->get_accept_stats();
+        REQUIRE (st.current_connections == 2u);
+        REQUIRE (st.connection_limit_rejects == 0u);
+      }
+    }
+  } // end given
+
+  GIVEN ("An acceptor with a connection limit and the close policy") {
+    chops::net::accept_limits lim;
+    lim.max_connections = 1;
+    lim.policy = chops::net::accept_limit_policy::close;
+    acc_ptr->set_accept_limits(lim);
+    start_admission_acceptor(acc_ptr);
+
+    WHEN ("more clients than the limit connect") {
+      auto socks = connect_clients(cli_ioc, 3);
+      auto rejected = wait_for([&] () {
+          return acc_ptr->get_accept_stats().connection_limit_rejects == 2u;
+        }
+      );
+      char c;
+      std::error_code ec;
+      asio::read(socks[2], asio::mutable_buffer(&c, 1), ec);
+      THEN ("the connections over the limit are accepted and closed") {
+        REQUIRE (rejected);
+        REQUIRE (ec == asio::error::eof);
+        auto st = acc_ptr->get_accept_stats();
+        REQUIRE (st.total_accepted == 1u);
+        REQUIRE (st.current_connections == 1u);
+        REQUIRE (st.connection_limit_pauses == 0u);
+      }
+    }
+  } // end given
+
+  GIVEN ("An acceptor with an accept rate limit and the pause policy") {
+    chops::net::accept_limits lim;
+    lim.accept_rate = 20.0;
+    lim.accept_burst = 1;
+    acc_ptr->set_accept_limits(lim);
+    start_admission_acceptor(acc_ptr);
+
+    WHEN ("several clients connect at once") {
+      auto start = std::chrono::steady_clock::now();
+      auto socks = connect_clients(cli_ioc, 4);
+      auto all = wait_for([&] () { return acc_ptr->get_accept_stats().total_accepted == 4u; } );
+      auto elapsed = std::chrono::steady_clock::now() - start;
+      THEN ("the connections are accepted at the limited rate") {
+        REQUIRE (all);
+        REQUIRE (elapsed >= std::chrono::milliseconds(140));
+        auto st = acc_ptr->get_accept_stats();
+        REQUIRE (st.rate_limit_pauses >= 3u);
+        REQUIRE (st.rate_limit_rejects == 0u);
+      }
+    }
+  } // end given
+
+  acc_ptr->stop();
+  wk.reset();
+}
+
+SCENARIO ( "Tcp acceptor test, admission control with a distributor",
+           "[tcp_acc] [accept_limits] [distributor]" ) {
+
+  chops::net::worker wk;
+  wk.start();
+  // the accepted connections are handed off to this io_context, which is not run
+  // until after the burst, so every handoff is still in flight when admitted
+  chops::net::worker conn_wk;
+  asio::io_context cli_ioc;
+
+  chops::net::io_context_distributor dist;
+  dist.acquire = [&conn_wk] () -> asio::io_context& { return conn_wk.get_io_context(); };
+  dist.release = [] (asio::io_context&) { };
+
+  asio::ip::tcp::endpoint endp(asio::ip::address_v4::loopback(), admission_test_port);
+  auto acc_ptr = std::make_shared<chops::net::detail::tcp_acceptor>(wk.get_io_context(), 
+                                                                    endp, true, dist);
+
+  GIVEN ("An acceptor with a distributor, a connection limit and the close policy") {
+    chops::net::accept_limits lim;
+    lim.max_connections = 2;
+    lim.policy = chops::net::accept_limit_policy::close;
+    acc_ptr->set_accept_limits(lim);
+    start_admission_acceptor(acc_ptr);
+
+    WHEN ("a burst of clients connect before the handoffs complete") {
+      auto socks = connect_clients(cli_ioc, 5);
+      auto rejected = wait_for([&] () {
+          return acc_ptr->get_accept_stats().connection_limit_rejects == 3u;
+        }
+      );
+      conn_wk.start();
+      auto added = wait_for([&] () {
+          return acc_ptr->get_accept_stats().current_connections == 2u;
+        }
+      );
+      THEN ("the handoffs in flight count against the limit") {
+        REQUIRE (rejected);
+        REQUIRE (added);
+        auto st = acc_ptr->get_accept_stats();
+        REQUIRE (st.total_accepted == 2u);
+        REQUIRE (st.connection_limit_rejects == 3u);
+      }
+    }
+  } // end given
+
+  acc_ptr->stop();
+  wk.reset();
+  conn_wk.reset();
+}
+
+SCENARIO ( "Tcp acceptor test, batch accepts", "[tcp_acc] [accept_batch]" ) {
+
+  constexpr int num_clients = 10;
+
+  asio::io_context ioc;
+  asio::io_context cli_ioc;
+
+  asio::ip::tcp::endpoint endp(asio::ip::address_v4::loopback(), admission_test_port);
+  auto acc_ptr = std::make_shared<chops::net::detail::tcp_acceptor>(ioc, endp, true);
+
+  // the clients connect before the io_context runs, so the connections are waiting in
+  // the listen backlog when the acceptor first wakes up
+  auto accept_all = [&] (std::size_t batch_size) {
+    REQUIRE (acc_ptr->set_accept_batch_size(batch_size));
+    start_admission_acceptor(acc_ptr);
+    auto socks = connect_clients(cli_ioc, num_clients);
+    std::thread thr([&ioc] () { ioc.run(); } );
+    wait_for([&] () { return acc_ptr->get_accept_stats().total_accepted == num_clients; } );
+    auto st = acc_ptr->get_accept_stats(); // before the stop aborts the pending wait
+    acc_ptr->stop();
+    for (auto& s : socks) {
+      s.close();
+    }
+    thr.join();
+    return st;
+  };
+
+  GIVEN ("An acceptor with a batch size larger than the number of waiting connections") {
+    WHEN ("the io_context runs") {
+      auto st = accept_all(16u);
+      THEN ("all of the connections are accepted in one wake-up") {
+        REQUIRE (st.total_accepted == num_clients);
+        REQUIRE (st.accept_wakeups == 1u);
+      }
+    }
+  } // end given
+
+  GIVEN ("An acceptor with a batch size smaller than the number of waiting connections") {
+    WHEN ("the io_context runs") {
+      auto st = accept_all(4u);
+      THEN ("the connections are accepted in batches of at most the batch size") {
+        REQUIRE (st.total_accepted == num_clients);
+        REQUIRE (st.accept_wakeups == 3u);
+      }
+    }
+  } // end given
+
+  GIVEN ("An acceptor without batch accepts") {
+    WHEN ("the io_context runs") {
+      auto st = accept_all(1u);
+      THEN ("each connection is accepted in its own wake-up") {
+        REQUIRE (st.total_accepted == num_clients);
+        REQUIRE (st.accept_wakeups == num_clients);
+      }
+    }
+  } // end given
+}
+
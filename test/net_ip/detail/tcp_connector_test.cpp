@@ -21,6 +21,7 @@
 #include "asio/ip/tcp.hpp"
 #include "asio/buffer.hpp"
 #include "asio/io_context.hpp"
+#include "asio/post.hpp"
 
 #include <system_error> // std::error_code
 #include <cstddef> // std::size_t
@@ -32,12 +33,15 @@
 #include <functional> // std::ref, std::cref
 #include <string_view>
 #include <vector>
+#include <mutex>
 
 #include "net_ip/detail/tcp_acceptor.hpp"
 #include "net_ip/detail/tcp_connector.hpp"
 
 #include "net_ip/net_entity.hpp"
 #include "net_ip/io_interface.hpp"
+#include "net_ip/net_ip_error.hpp"
+#include "net_ip/reconnect_policy.hpp"
 
 #include "net_ip/component/worker.hpp"
 #include "net_ip/component/send_to_all.hpp"
@@ -312,3 +316,149 @@ SCENARIO ( "Tcp connector test, LF msgs, two-way, interval 0, 25 connectors, man
 
 }
 
+
+SCENARIO ( "Tcp connector test, reconnect policy with max attempts, no acceptor", 
+           "[tcp_conn_reconnect]" ) {
+
+  using namespace std::chrono_literals;
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  GIVEN ("A connector to a port with no acceptor, and a limited number of reconnects") {
+
+    chops::net::reconnect_policy pol { 10ms, 40ms };
+    pol.max_attempts = 3u;
+    pol.connect_timeout = 2000ms;
+
+    auto endp_seq = 
+        chops::net::endpoints_resolver<asio::ip::tcp>(ioc).make_endpoints(true, "127.0.0.1", "30779");
+
+    auto conn_ptr = std::make_shared<chops::net::detail::tcp_connector>(ioc,
+                       endp_seq.cbegin(), endp_seq.cend(), pol);
+
+    WHEN ("the connector is started") {
+
+      std::mutex mut;
+      std::vector<std::error_code> errs;
+      std::promise<void> stopped_prom;
+      auto stopped_fut = stopped_prom.get_future();
+      test_counter state_chg_cnt = 0;
+
+      conn_ptr->start(
+        [&state_chg_cnt] (chops::net::tcp_io_interface, std::size_t, bool) {
+          ++state_chg_cnt;
+        },
+        [&mut, &errs, &stopped_prom] (chops::net::tcp_io_interface, std::error_code err) {
+          std::lock_guard<std::mutex> lk(mut);
+          errs.push_back(err);
+          if (err == std::make_error_code(chops::net::net_ip_errc::tcp_connector_stopped)) {
+            stopped_prom.set_value();
+          }
+        }
+      );
+
+      THEN ("the first connect and each reconnect fail, then the connector stops") {
+        REQUIRE (stopped_fut.wait_for(5s) == std::future_status::ready);
+        REQUIRE_FALSE (conn_ptr->is_started());
+        REQUIRE (state_chg_cnt == 0);
+        std::lock_guard<std::mutex> lk(mut);
+        REQUIRE (errs.size() == 5u);
+        REQUIRE (errs.back() == std::make_error_code(chops::net::net_ip_errc::tcp_connector_stopped));
+      }
+    }
+  } // end given
+  wk.reset();
+
+}
+
+SCENARIO ( "Tcp connector test, connect timeout with max attempts, full listen backlog", 
+           "[tcp_conn_reconnect] [connect_timeout]" ) {
+
+  using namespace std::chrono_literals;
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  GIVEN ("A listener that never accepts, with its backlog filled by other sockets") {
+
+    // the listener's accept queue is filled and never drained, so later connect 
+    // SYNs are silently dropped and the connect attempt hangs until it times out
+    asio::ip::tcp::endpoint endp(asio::ip::make_address("127.0.0.1"), 30780);
+    asio::ip::tcp::acceptor blocker(ioc);
+    blocker.open(endp.protocol());
+    blocker.set_option(asio::socket_base::reuse_address(true));
+    blocker.bind(endp);
+    blocker.listen(0);
+
+    std::vector<std::unique_ptr<asio::ip::tcp::socket> > fillers;
+    chops::repeat(4, [&ioc, &endp, &fillers] {
+        fillers.push_back(std::make_unique<asio::ip::tcp::socket>(ioc));
+        fillers.back()->async_connect(endp, [] (const std::error_code&) { } );
+      }
+    );
+    std::this_thread::sleep_for(200ms);
+
+    chops::net::reconnect_policy pol { 10ms, 40ms };
+    pol.max_attempts = 2u;
+    pol.connect_timeout = 100ms;
+
+    std::vector<asio::ip::tcp::endpoint> endp_seq { endp };
+
+    auto conn_ptr = std::make_shared<chops::net::detail::tcp_connector>(ioc,
+                       endp_seq.cbegin(), endp_seq.cend(), pol);
+
+    WHEN ("the connector is started") {
+
+      std::mutex mut;
+      std::vector<std::error_code> errs;
+      std::promise<void> stopped_prom;
+      auto stopped_fut = stopped_prom.get_future();
+      test_counter state_chg_cnt = 0;
+
+      conn_ptr->start(
+        [&state_chg_cnt] (chops::net::tcp_io_interface, std::size_t, bool) {
+          ++state_chg_cnt;
+        },
+        [&mut, &errs, &stopped_prom] (chops::net::tcp_io_interface, std::error_code err) {
+          std::lock_guard<std::mutex> lk(mut);
+          errs.push_back(err);
+          if (err == std::make_error_code(chops::net::net_ip_errc::tcp_connector_stopped)) {
+            stopped_prom.set_value();
+          }
+        }
+      );
+
+      THEN ("each connect attempt times out, then the connector stops after max attempts") {
+        REQUIRE (stopped_fut.wait_for(5s) == std::future_status::ready);
+        REQUIRE_FALSE (conn_ptr->is_started());
+        REQUIRE (state_chg_cnt == 0);
+        std::lock_guard<std::mutex> lk(mut);
+        REQUIRE (errs.size() == pol.max_attempts + 2u);
+        for (std::size_t i = 0u; i < errs.size() - 1u; ++i) {
+          REQUIRE (errs[i] == std::errc::timed_out);
+        }
+        REQUIRE (errs.back() == std::make_error_code(chops::net::net_ip_errc::tcp_connector_stopped));
+      }
+    }
+
+    // close the sockets in the io thread before they are destroyed
+    std::promise<void> closed_prom;
+    auto closed_fut = closed_prom.get_future();
+    asio::post(ioc, [&fillers, &blocker, &closed_prom] {
+        for (auto& s : fillers) {
+          std::error_code ec;
+          s->close(ec);
+        }
+        std::error_code ec;
+        blocker.close(ec);
+        closed_prom.set_value();
+      }
+    );
+    closed_fut.wait();
+  } // end given
+  wk.reset();
+
+}
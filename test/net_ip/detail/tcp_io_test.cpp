@@ -18,6 +18,8 @@
 #include "asio/ip/tcp.hpp"
 #include "asio/connect.hpp"
 #include "asio/io_context.hpp"
+#include "asio/write.hpp"
+#include "asio/buffer.hpp"
 
 #include <system_error> // std::error_code
 #include <cstddef> // std::size_t
@@ -65,7 +67,8 @@ struct notify_me {
 };
 
 std::size_t connector_func (const vec_buf& in_msg_vec, asio::io_context& ioc, 
-                            int interval, std::string_view delim, chops::const_shared_buffer empty_msg) {
+                            int interval, std::string_view delim, chops::const_shared_buffer empty_msg,
+                            std::size_t batch_bufs, std::size_t read_ahead_size) {
 
   auto endps = 
       chops::net::endpoints_resolver<asio::ip::tcp>(ioc).make_endpoints(true, test_addr, test_port);
@@ -78,9 +81,10 @@ std::size_t connector_func (const vec_buf& in_msg_vec, asio::io_context& ioc,
 
   auto iohp = std::make_shared<chops::net::detail::tcp_io>(std::move(sock), 
                                                            notify_me(std::move(notify_prom)));
+  iohp->set_write_batch_limits(batch_bufs, 0);
 
   test_counter cnt = 0;
-  tcp_start_io(chops::net::tcp_io_interface(iohp), false, delim, cnt);
+  tcp_start_io(chops::net::tcp_io_interface(iohp), false, delim, cnt, read_ahead_size);
 
   for (auto buf : in_msg_vec) {
     iohp->send(buf);
@@ -96,7 +100,8 @@ std::size_t connector_func (const vec_buf& in_msg_vec, asio::io_context& ioc,
 }
 
 void acc_conn_test (const vec_buf& in_msg_vec, bool reply, int interval, std::string_view delim,
-                    chops::const_shared_buffer empty_msg) {
+                    chops::const_shared_buffer empty_msg, std::size_t batch_bufs = 1,
+                    std::size_t read_ahead_size = 0) {
 
   chops::net::worker wk;
   wk.start();
@@ -114,15 +119,17 @@ void acc_conn_test (const vec_buf& in_msg_vec, bool reply, int interval, std::st
         INFO ("Creating connector asynchronously, msg interval: " << interval);
 
         auto conn_fut = std::async(std::launch::async, connector_func, std::cref(in_msg_vec), 
-                                   std::ref(ioc), interval, delim, empty_msg);
+                                   std::ref(ioc), interval, delim, empty_msg, batch_bufs, read_ahead_size);
 
         notify_prom_type notify_prom;
         auto notify_fut = notify_prom.get_future();
 
         auto iohp = std::make_shared<chops::net::detail::tcp_io>(std::move(acc.accept()), 
                                                                  notify_me(std::move(notify_prom)));
+        iohp->set_write_batch_limits(batch_bufs, 0);
+        REQUIRE (iohp->get_output_queue_stats().max_write_batch_bufs == batch_bufs);
         test_counter cnt = 0;
-        tcp_start_io(chops::net::tcp_io_interface(iohp), reply, delim, cnt);
+        tcp_start_io(chops::net::tcp_io_interface(iohp), reply, delim, cnt, read_ahead_size);
 
         auto acc_err = notify_fut.get();
 // std::cerr << "Inside acc_conn_test, acc_err: " << acc_err << ", " << acc_err.message() << std::endl;
@@ -251,3 +258,114 @@ SCENARIO ( "Tcp IO handler test, LF msgs, two-way, interval 0, many msgs",
 
 }
 
+SCENARIO ( "Tcp IO handler test, variable len msgs, two-way, interval 0, many msgs, batched writes",
+           "[tcp_io] [var_len_msg] [two_way] [interval_0] [many] [batch]" ) {
+
+  acc_conn_test ( make_msg_vec (make_variable_len_msg, "Gather ye rosebuds!", 'B', 100*NumMsgs),
+                  true, 0, 
+                  std::string_view(), make_empty_variable_len_msg(), 32 );
+
+}
+
+SCENARIO ( "Tcp IO handler test, LF msgs, two-way, interval 0, many msgs, batched writes",
+           "[tcp_io] [lf_msg] [two_way] [interval_0] [many] [batch]" ) {
+
+  acc_conn_test ( make_msg_vec (make_lf_text_msg, "Scatter gather!", 'W', 300*NumMsgs),
+                  true, 0, 
+                  std::string_view("\n"), make_empty_lf_text_msg(), 64 );
+
+}
+
+SCENARIO ( "Tcp IO handler test, variable len msgs, one-way, interval 0, many msgs, read-ahead",
+           "[tcp_io] [var_len_msg] [one_way] [interval_0] [many] [read_ahead]" ) {
+
+  acc_conn_test ( make_msg_vec (make_variable_len_msg, "Read it all!", 'A', 100*NumMsgs),
+                  false, 0, 
+                  std::string_view(), make_empty_variable_len_msg(), 1, 64*1024 );
+
+}
+
+SCENARIO ( "Tcp IO handler test, variable len msgs, two-way, interval 5, small read-ahead",
+           "[tcp_io] [var_len_msg] [two_way] [interval_5] [read_ahead]" ) {
+
+  // read-ahead buffer smaller than most of the messages, forcing the buffer to grow
+  acc_conn_test ( make_msg_vec (make_variable_len_msg, "Grow it!", 'G', NumMsgs),
+                  true, 5, 
+                  std::string_view(), make_empty_variable_len_msg(), 1, 7 );
+
+}
+
+SCENARIO ( "Tcp IO handler test, variable len msgs, two-way, interval 0, many msgs, read-ahead",
+           "[tcp_io] [var_len_msg] [two_way] [interval_0] [many] [read_ahead]" ) {
+
+  acc_conn_test ( make_msg_vec (make_variable_len_msg, "Read it all, reply!", 'Y', 100*NumMsgs),
+                  true, 0, 
+                  std::string_view(), make_empty_variable_len_msg(), 1, 64*1024 );
+
+}
+
+
+SCENARIO ( "Tcp IO handler test, read-ahead with a 0 header size",
+           "[tcp_io] [read_ahead]" ) {
+
+  asio::io_context ioc;
+
+  GIVEN ("A tcp_io object") {
+    auto iohp = std::make_shared<chops::net::detail::tcp_io>(asio::ip::tcp::socket(ioc),
+                   [] (std::error_code, chops::net::detail::tcp_io_ptr) { } );
+
+    WHEN ("start_io is called with a read-ahead size and a 0 header size") {
+      THEN ("the start is rejected") {
+        REQUIRE_FALSE (iohp->start_io(0u, 
+            [] (asio::const_buffer, chops::net::tcp_io_interface, asio::ip::tcp::endpoint) {
+              return true;
+            },
+            [] (asio::mutable_buffer) -> std::size_t { return 0u; },
+            1024u));
+        REQUIRE_FALSE (iohp->is_io_started());
+      }
+    }
+  } // end given
+}
+
+SCENARIO ( "Tcp IO handler test, message handler terminates, peer never reads replies",
+           "[tcp_io] [terminate]" ) {
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  GIVEN ("A delimited tcp_io replying with more data than the socket buffers hold") {
+
+    asio::ip::tcp::acceptor acc(ioc, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0));
+    asio::ip::tcp::socket peer(ioc);
+    peer.connect(acc.local_endpoint());
+
+    notify_prom_type notify_prom;
+    auto notify_fut = notify_prom.get_future();
+    auto iohp = std::make_shared<chops::net::detail::tcp_io>(acc.accept(),
+                                                             notify_me(std::move(notify_prom)));
+
+    chops::const_shared_buffer big_reply(chops::mutable_shared_buffer(32u * 1024u * 1024u));
+    iohp->start_io(std::string_view("\n"), 
+        [big_reply] (asio::const_buffer, chops::net::tcp_io_interface io, asio::ip::tcp::endpoint) {
+          io.send(big_reply);
+          return false;
+        }
+    );
+
+    WHEN ("the peer sends a message and never reads") {
+      asio::write(peer, asio::buffer(std::string_view("quit\n")));
+
+      THEN ("the net entity is notified without waiting for the reply to be written") {
+        REQUIRE (notify_fut.wait_for(std::chrono::seconds(2)) == std::future_status::ready);
+        REQUIRE (notify_fut.get() == 
+                 std::make_error_code(chops::net::net_ip_errc::message_handler_terminated));
+      }
+    }
+    std::error_code ec;
+    peer.close(ec);
+  } // end given
+  wk.reset();
+
+}
@@ -0,0 +1,71 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for @c token_bucket class.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch.hpp"
+
+#include <chrono>
+
+#include "net_ip/detail/token_bucket.hpp"
+
+SCENARIO ( "Token bucket test", "[token_bucket]" ) {
+
+  using namespace std::chrono_literals;
+  using chops::net::detail::token_bucket;
+
+  token_bucket tb;
+  auto now = token_bucket::clock_type::now();
+
+  GIVEN ("A default constructed token bucket") {
+    THEN ("there is no limit") {
+      REQUIRE_FALSE (tb.is_limited());
+      for (int i = 0; i < 100; ++i) {
+        REQUIRE (tb.try_take(now));
+      }
+      REQUIRE (tb.time_until_token(now) == token_bucket::duration::zero());
+    }
+  } // end given
+
+  GIVEN ("A token bucket with a rate of 10 per second and a burst of 3") {
+    tb.reset(10.0, 3u, now);
+    WHEN ("the burst is taken") {
+      REQUIRE (tb.try_take(now));
+      REQUIRE (tb.try_take(now));
+      REQUIRE (tb.try_take(now));
+      THEN ("the bucket is empty until a token is added") {
+        REQUIRE_FALSE (tb.try_take(now));
+        auto t1 = tb.time_until_token(now);
+        REQUIRE (t1 >= 100ms);
+        REQUIRE (t1 < 100ms + 1us);
+        auto t2 = tb.time_until_token(now + 40ms);
+        REQUIRE (t2 >= 60ms);
+        REQUIRE (t2 < 60ms + 1us);
+        REQUIRE_FALSE (tb.try_take(now + 99ms));
+        REQUIRE (tb.try_take(now + 100ms));
+        REQUIRE_FALSE (tb.try_take(now + 100ms));
+      }
+    }
+    AND_WHEN ("a long time passes") {
+      REQUIRE (tb.try_take(now));
+      THEN ("the bucket holds at most the burst") {
+        auto later = now + 10s;
+        REQUIRE (tb.try_take(later));
+        REQUIRE (tb.try_take(later));
+        REQUIRE (tb.try_take(later));
+        REQUIRE_FALSE (tb.try_take(later));
+      }
+    }
+  } // end given
+}
+
@@ -66,7 +66,8 @@ constexpr int NumMsgs = 50;
 
 void start_udp_senders(const vec_buf& in_msg_vec, bool reply, int interval, int num_senders,
                        test_counter& send_cnt, io_context& ioc, 
-                       chops::net::err_wait_q& err_wq, const ip::udp::endpoint& recv_endp) {
+                       chops::net::err_wait_q& err_wq, const ip::udp::endpoint& recv_endp,
+                       std::size_t batch_size) {
 
   chops::net::send_to_all<chops::net::udp_io> sta { };
 
@@ -76,6 +77,7 @@ void start_udp_senders(const vec_buf& in_msg_vec, bool reply, int interval, int
   chops::repeat(num_senders, [&] (int i) {
       auto send_ptr = std::make_shared<chops::net::detail::udp_entity_io>(ioc, 
                                      make_udp_endpoint(test_addr, test_port_base+i+1));
+      send_ptr->set_datagram_batch_size(batch_size);
       senders.push_back(send_ptr);
 
       auto sender_futs = get_udp_io_futures(chops::net::udp_net_entity(send_ptr), err_wq,
@@ -108,7 +110,8 @@ std::cerr << "****** Senders total output queue size: " << qs.output_queue_size
   }
 }
 
-void udp_test (const vec_buf& in_msg_vec, bool reply, int interval, int num_senders) {
+void udp_test (const vec_buf& in_msg_vec, bool reply, int interval, int num_senders,
+               std::size_t batch_size = 1) {
 
   chops::net::worker wk;
   wk.start();
@@ -124,6 +127,7 @@ void udp_test (const vec_buf& in_msg_vec, bool reply, int interval, int num_send
 
         auto recv_endp = make_udp_endpoint(test_addr, test_port_base);
         auto recv_ptr = std::make_shared<chops::net::detail::udp_entity_io>(ioc, recv_endp);
+        recv_ptr->set_datagram_batch_size(batch_size);
 
         INFO ("Receiving UDP entity created");
 
@@ -142,10 +146,10 @@ void udp_test (const vec_buf& in_msg_vec, bool reply, int interval, int num_send
 
         INFO ("Starting first iteration of UDP senders, num: " << num_senders);
         start_udp_senders(in_msg_vec, reply, interval, num_senders,
-                          send_cnt, ioc, err_wq, recv_endp);
+                          send_cnt, ioc, err_wq, recv_endp, batch_size);
         INFO ("Starting second iteration of UDP senders");
         start_udp_senders(in_msg_vec, reply, interval, num_senders,
-                          send_cnt, ioc, err_wq, recv_endp);
+                          send_cnt, ioc, err_wq, recv_endp, batch_size);
 
 
         INFO ("Stopping receiver");
@@ -287,4 +291,113 @@ SCENARIO ( "Udp IO handler test, LF msgs, two-way, interval 50, senders 2, many
 
 }
 
+SCENARIO ( "Udp IO handler test, var len msgs, one-way, interval 10, senders 3, batched",
+           "[udp_io] [var_len_msg] [one-way] [interval_10] [senders_3] [batched]" ) {
+
+  udp_test ( make_msg_vec (make_variable_len_msg, "Batch!", 'B', 2*NumMsgs),
+             false, 10, 3, 32);
+
+}
+
+SCENARIO ( "Udp IO handler test, LF msgs, two-way, interval 20, senders 5, batched",
+           "[udp_io] [lf_msg] [two-way] [interval_20] [senders_5] [batched]" ) {
+
+  udp_test ( make_msg_vec (make_lf_text_msg, "Batch fast!", 'C', 4*NumMsgs),
+             true, 20, 5, 16);
+
+}
+
+SCENARIO ( "Udp IO handler test, multicast receiver and sender, loopback",
+           "[udp_io] [multicast]" ) {
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  constexpr int num_dgrams = 20;
+  auto port = static_cast<unsigned short>(test_port_base + 1);
+
+  chops::net::multicast_options opts;
+  opts.group = ip::make_address("239.255.0.1");
+  opts.interface_addr = ip::make_address(test_addr);
+
+  GIVEN ("A multicast receiver and a multicast sender on the loopback interface") {
+
+    auto recv_ptr = std::make_shared<chops::net::detail::udp_entity_io>(ioc, 
+                          ip::udp::endpoint(ip::address_v4::any(), port), opts, ip::udp::endpoint());
+    auto send_ptr = std::make_shared<chops::net::detail::udp_entity_io>(ioc, 
+                          ip::udp::endpoint(), opts, ip::udp::endpoint(opts.group, port));
+
+    std::promise<std::error_code> recv_err_prom;
+    auto recv_err_fut = recv_err_prom.get_future();
+    std::promise<std::size_t> recv_prom;
+    auto recv_fut = recv_prom.get_future();
+    std::size_t recv_cnt = 0u;
+    bool recv_started = false; // error callback is also invoked when stopping
+
+    auto err_cb = [] (chops::net::udp_io_interface, std::error_code) { };
+
+    chops::net::udp_net_entity recv_ent(recv_ptr);
+    recv_ent.start( [&] (chops::net::udp_io_interface io, std::size_t, bool starting) {
+        if (!starting) {
+          return;
+        }
+        io.start_io(1024u, [&] (const_buffer, chops::net::udp_io_interface, ip::udp::endpoint) {
+            if (++recv_cnt == num_dgrams) {
+              recv_prom.set_value(recv_cnt);
+            }
+            return true;
+          }
+        );
+        recv_started = true;
+        recv_err_prom.set_value(std::error_code());
+      }, 
+      [&] (chops::net::udp_io_interface, std::error_code err) {
+        if (!recv_started) {
+          recv_started = true;
+          recv_err_prom.set_value(err); // start failure, e.g. no multicast route
+        }
+      }
+    );
+
+    WHEN ("the group is joined and datagrams are sent to the group") {
+      THEN ("the datagrams are received, unless the environment does not support multicast") {
+
+        auto err = recv_err_fut.get();
+        if (err) {
+          WARN ("Multicast join failed, skipping: " << err.message());
+          recv_ent.stop();
+        }
+        else {
+          chops::net::udp_net_entity send_ent(send_ptr);
+          std::promise<chops::net::udp_io_interface> send_prom;
+          auto send_fut = send_prom.get_future();
+          send_ent.start( [&] (chops::net::udp_io_interface io, std::size_t, bool starting) {
+              if (starting) {
+                io.start_io();
+                send_prom.set_value(io);
+              }
+            }, err_cb);
+          auto send_io = send_fut.get();
+
+          auto ba = chops::make_byte_array(0x0D, 0x0E, 0x0A);
+          for (int i = 0; i < num_dgrams; ++i) {
+            send_io.send(ba.data(), ba.size());
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+          }
+          // CHECK instead of REQUIRE since UDP is an unreliable protocol
+          CHECK (recv_fut.wait_for(std::chrono::seconds(2)) == std::future_status::ready);
+
+          REQUIRE_FALSE (recv_ent.leave_multicast_group(opts.group));
+          REQUIRE (recv_ent.leave_multicast_group(opts.group)); // no longer a member
+
+          send_ent.stop();
+          recv_ent.stop();
+        }
+      }
+    }
+  } // end given
+
+  wk.reset();
+}
 
@@ -0,0 +1,284 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for @c recv_buffer_pool and @c pooled_buffer.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2019 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch2/catch.hpp"
+
+#include "asio/io_context.hpp"
+#include "asio/ip/tcp.hpp"
+#include "asio/ip/udp.hpp"
+#include "asio/write.hpp"
+#include "asio/buffer.hpp"
+
+#include <cstddef> // std::size_t, std::byte
+#include <vector>
+#include <memory> // std::make_shared
+#include <mutex>
+#include <thread>
+#include <future>
+#include <chrono>
+#include <system_error>
+
+#include "net_ip/recv_buffer_pool.hpp"
+#include "net_ip/component/worker.hpp"
+#include "net_ip/detail/tcp_acceptor.hpp"
+#include "net_ip/detail/udp_entity_io.hpp"
+#include "net_ip/net_entity.hpp"
+#include "net_ip/io_interface.hpp"
+
+#include "utility/make_byte_array.hpp"
+
+SCENARIO ( "Recv buffer pool test, acquire and release",
+           "[recv_buffer_pool]" ) {
+
+  auto ba = chops::make_byte_array(0x20, 0x21, 0x22, 0x23, 0x24);
+
+  GIVEN ("The recv_buffer_pool of an io_context") {
+    asio::io_context ioc;
+    auto& pool = asio::use_service<chops::net::recv_buffer_pool>(ioc);
+    REQUIRE (&pool == &asio::use_service<chops::net::recv_buffer_pool>(ioc));
+    REQUIRE (pool.num_allocated() == 0u);
+
+    WHEN ("a buffer is acquired and copied") {
+      auto pb = pool.acquire(ba.data(), ba.size());
+      auto pb2 = pb;
+      THEN ("the copies share the bytes, and the buffer returns to the pool when both are released") {
+        REQUIRE (pb.size() == ba.size());
+        REQUIRE (pb2.data() == pb.data());
+        REQUIRE (pb.use_count() == 2u);
+        REQUIRE (pool.num_allocated() == 1u);
+        REQUIRE (pool.num_free() == 0u);
+        pb.release();
+        REQUIRE (pb.empty());
+        REQUIRE (pool.num_free() == 0u);
+        pb2.release();
+        REQUIRE (pool.num_free() == 1u);
+        auto pb3 = pool.acquire(ba.data(), 2u);
+        REQUIRE (pb3.size() == 2u);
+        REQUIRE (pool.num_allocated() == 1u);
+        REQUIRE (pool.num_free() == 0u);
+      }
+    }
+    AND_WHEN ("a buffer is acquired by swapping in a byte vector") {
+      std::vector<std::byte> bv(ba.begin(), ba.end());
+      auto data = bv.data();
+      auto pb = pool.acquire(bv);
+      THEN ("the bytes are not copied and the vector is empty") {
+        REQUIRE (pb.data() == data);
+        REQUIRE (pb.size() == ba.size());
+        REQUIRE (bv.empty());
+      }
+    }
+    AND_WHEN ("buffers are released in other threads") {
+      std::vector<chops::net::pooled_buffer> bufs;
+      for (int i = 0; i < 10; ++i) {
+        bufs.push_back(pool.acquire(ba.data(), ba.size()));
+      }
+      std::thread thr1([b = std::vector<chops::net::pooled_buffer>(bufs.begin(), bufs.begin()+5)] { });
+      std::thread thr2([b = std::vector<chops::net::pooled_buffer>(bufs.begin()+5, bufs.end())] { });
+      bufs.clear();
+      thr1.join();
+      thr2.join();
+      THEN ("all of the buffers are back in the pool") {
+        REQUIRE (pool.num_allocated() == 10u);
+        REQUIRE (pool.num_free() == 10u);
+      }
+    }
+    AND_WHEN ("more buffers are released than the max free count") {
+      REQUIRE (pool.max_free() == chops::net::detail::default_max_free_buffers);
+      pool.set_max_free(4u);
+      std::vector<chops::net::pooled_buffer> bufs;
+      for (int i = 0; i < 10; ++i) {
+        bufs.push_back(pool.acquire(ba.data(), ba.size()));
+      }
+      bufs.clear();
+      THEN ("only the max free count is kept in the pool, and lowering it frees the excess") {
+        REQUIRE (pool.max_free() == 4u);
+        REQUIRE (pool.num_allocated() == 10u);
+        REQUIRE (pool.num_free() == 4u);
+        pool.set_max_free(1u);
+        REQUIRE (pool.num_free() == 1u);
+        auto pb = pool.acquire(ba.data(), ba.size());
+        auto pb2 = pool.acquire(ba.data(), ba.size());
+        REQUIRE (pool.num_allocated() == 11u);
+        REQUIRE (pool.num_free() == 0u);
+      }
+    }
+  } // end given
+
+  GIVEN ("A buffer acquired from an io_context that is then destroyed") {
+    chops::net::pooled_buffer pb;
+    {
+      asio::io_context ioc;
+      pb = asio::use_service<chops::net::recv_buffer_pool>(ioc).acquire(ba.data(), ba.size());
+    }
+    THEN ("the buffer is still valid and can be released") {
+      REQUIRE (pb.size() == ba.size());
+      REQUIRE (pb.data()[0] == ba[0]);
+      pb.release();
+      REQUIRE (pb.empty());
+    }
+  } // end given
+}
+
+SCENARIO ( "Recv buffer pool test, TCP message handler retaining pooled buffers",
+           "[recv_buffer_pool] [tcp_io]" ) {
+
+  constexpr unsigned short test_port = 30455;
+  constexpr std::size_t msg_size = 4u;
+  constexpr std::size_t num_msgs = 50u;
+
+  chops::net::worker wk;
+  wk.start();
+
+  GIVEN ("A TCP acceptor with a message handler taking pooled buffers") {
+
+    asio::ip::tcp::endpoint endp(asio::ip::address_v4::loopback(), test_port);
+    auto acc_ptr = std::make_shared<chops::net::detail::tcp_acceptor>(wk.get_io_context(), endp, true);
+    chops::net::tcp_acceptor_net_entity acc(acc_ptr);
+
+    std::mutex mut;
+    std::vector<chops::net::pooled_buffer> msgs;
+
+    acc.start( [&mut, &msgs] (chops::net::tcp_io_interface io, std::size_t, bool starting) {
+        if (starting) {
+          io.start_io(msg_size, [&mut, &msgs] (chops::net::pooled_buffer buf,
+                                               chops::net::tcp_io_interface,
+                                               asio::ip::tcp::endpoint) {
+              std::lock_guard<std::mutex> lk(mut);
+              msgs.push_back(std::move(buf));
+              return true;
+            }
+          );
+        }
+      },
+      [] (chops::net::tcp_io_interface, std::error_code) { }
+    );
+
+    WHEN ("messages are sent by a client") {
+      asio::io_context ioc;
+      asio::ip::tcp::socket sock(ioc);
+      sock.connect(endp);
+      for (std::size_t i = 0u; i < num_msgs; ++i) {
+        auto ba = chops::make_byte_array(0x01, 0x02, 0x03, i);
+        asio::write(sock, asio::buffer(ba.data(), ba.size()));
+      }
+      for (int i = 0; i < 200; ++i) {
+        {
+          std::lock_guard<std::mutex> lk(mut);
+          if (msgs.size() == num_msgs) {
+            break;
+          }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+
+      THEN ("each retained message is intact, and the buffers return to the pool when released") {
+        auto& pool = asio::use_service<chops::net::recv_buffer_pool>(wk.get_io_context());
+        std::lock_guard<std::mutex> lk(mut);
+        REQUIRE (msgs.size() == num_msgs);
+        for (std::size_t i = 0u; i < num_msgs; ++i) {
+          REQUIRE (msgs[i].size() == msg_size);
+          REQUIRE (msgs[i].data()[3] == static_cast<std::byte>(i));
+        }
+        REQUIRE (pool.num_allocated() == num_msgs);
+        msgs.clear();
+        REQUIRE (pool.num_free() == num_msgs);
+      }
+      sock.close();
+    }
+    acc.stop();
+  } // end given
+
+  wk.reset();
+}
+
+SCENARIO ( "Recv buffer pool test, UDP message handler retaining pooled buffers",
+           "[recv_buffer_pool] [udp_io]" ) {
+
+  constexpr unsigned short test_port = 30456;
+  constexpr std::size_t max_size = 4096u;
+  constexpr std::size_t small_size = 4u;
+  constexpr std::size_t large_size = 3000u; // at least half of max_size, swapped in
+
+  chops::net::worker wk;
+  wk.start();
+
+  GIVEN ("A UDP entity with a message handler taking pooled buffers") {
+
+    asio::ip::udp::endpoint endp(asio::ip::address_v4::loopback(), test_port);
+    auto ent_ptr = std::make_shared<chops::net::detail::udp_entity_io>(wk.get_io_context(), endp);
+    chops::net::udp_net_entity ent(ent_ptr);
+
+    std::mutex mut;
+    std::vector<chops::net::pooled_buffer> msgs;
+    std::promise<void> started_prom;
+    auto started_fut = started_prom.get_future();
+
+    ent.start( [&] (chops::net::udp_io_interface io, std::size_t, bool starting) {
+        if (starting) {
+          io.start_io(max_size, [&mut, &msgs] (chops::net::pooled_buffer buf,
+                                               chops::net::udp_io_interface,
+                                               asio::ip::udp::endpoint) {
+              std::lock_guard<std::mutex> lk(mut);
+              msgs.push_back(std::move(buf));
+              return true;
+            }
+          );
+          started_prom.set_value();
+        }
+      },
+      [] (chops::net::udp_io_interface, std::error_code) { }
+    );
+    started_fut.wait();
+
+    WHEN ("a small and a large datagram are sent") {
+      asio::io_context ioc;
+      asio::ip::udp::socket sock(ioc, asio::ip::udp::endpoint(asio::ip::udp::v4(), 0));
+      std::vector<std::byte> small_dgram(small_size, std::byte{0x0A});
+      std::vector<std::byte> large_dgram(large_size, std::byte{0x0B});
+      sock.send_to(asio::buffer(small_dgram), endp);
+      sock.send_to(asio::buffer(large_dgram), endp);
+      for (int i = 0; i < 200; ++i) {
+        {
+          std::lock_guard<std::mutex> lk(mut);
+          if (msgs.size() == 2u) {
+            break;
+          }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+
+      THEN ("both retained datagrams are intact, and the buffers return to the pool when released") {
+        auto& pool = asio::use_service<chops::net::recv_buffer_pool>(wk.get_io_context());
+        std::lock_guard<std::mutex> lk(mut);
+        // CHECK instead of REQUIRE since UDP is an unreliable protocol
+        CHECK (msgs.size() == 2u);
+        if (msgs.size() == 2u) {
+          REQUIRE (msgs[0].size() == small_size);
+          REQUIRE (msgs[0].data()[small_size-1u] == std::byte{0x0A});
+          REQUIRE (msgs[1].size() == large_size);
+          REQUIRE (msgs[1].data()[large_size-1u] == std::byte{0x0B});
+          REQUIRE (pool.num_allocated() == 2u);
+          msgs.clear();
+          REQUIRE (pool.num_free() == 2u);
+        }
+      }
+      sock.close();
+    }
+    ent.stop();
+  } // end given
+
+  wk.reset();
+}